@@ -9,8 +9,10 @@
 #include "mcp_server.h"
 #include "assets.h"
 #include "settings.h"
+#include "trace.h"
 
 #include <cstring>
+#include <cctype>
 #include <esp_log.h>
 #include <cJSON.h>
 #include <driver/gpio.h>
@@ -63,15 +65,19 @@ void Application::Initialize() {
     SetDeviceState(kDeviceStateStarting);
 
     // Setup the display
+    Trace::Begin("display_setup");
     auto display = board.GetDisplay();
     display->SetupUI();
     // Print board name/version info
     display->SetChatMessage("system", SystemInfo::GetUserAgent().c_str());
+    Trace::End("display_setup");
 
     // Setup the audio service
+    Trace::Begin("audio_init");
     auto codec = board.GetAudioCodec();
     audio_service_.Initialize(codec);
     audio_service_.Start();
+    Trace::End("audio_init");
 
     AudioServiceCallbacks callbacks;
     callbacks.on_send_queue_available = [this]() {
@@ -94,9 +100,11 @@ void Application::Initialize() {
     esp_timer_start_periodic(clock_timer_handle_, 1000000);
 
     // Add MCP common tools (only once during initialization)
+    Trace::Begin("mcp_tools");
     auto& mcp_server = McpServer::GetInstance();
     mcp_server.AddCommonTools();
     mcp_server.AddUserOnlyTools();
+    Trace::End("mcp_tools");
 
     // Set network event callback for UI updates and network state handling
     board.SetNetworkEventCallback([this](NetworkEvent event, const std::string& data) {
@@ -156,7 +164,9 @@ void Application::Initialize() {
     });
 
     // Start network asynchronously
+    Trace::Begin("network_start");
     board.StartNetwork();
+    Trace::End("network_start");
 
     // Update the status bar immediately to show the network state
     display->UpdateStatusBar(true);
@@ -179,7 +189,8 @@ void Application::Run() {
         MAIN_EVENT_START_LISTENING |
         MAIN_EVENT_STOP_LISTENING |
         MAIN_EVENT_ACTIVATION_DONE |
-        MAIN_EVENT_STATE_CHANGED;
+        MAIN_EVENT_STATE_CHANGED |
+        MAIN_EVENT_SEND_VIDEO;
 
     while (true) {
         auto bits = xEventGroupWaitBits(event_group_, ALL_EVENTS, pdTRUE, pdFALSE, portMAX_DELAY);
@@ -225,6 +236,21 @@ void Application::Run() {
             }
         }
 
+        if (bits & MAIN_EVENT_SEND_VIDEO) {
+            // One frame per wakeup, so queued audio is sent between video frames
+            auto camera = Board::GetInstance().GetCamera();
+            auto packet = camera != nullptr ? camera->PopStreamFrame() : nullptr;
+            if (packet) {
+                if (!protocol_ || !protocol_->SendVideo(std::move(packet))) {
+                    ESP_LOGW(TAG, "Failed to send video frame, stop camera stream");
+                    StopCameraStream();
+                } else {
+                    // Come back for the next queued frame
+                    xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_VIDEO);
+                }
+            }
+        }
+
         if (bits & MAIN_EVENT_WAKE_WORD_DETECTED) {
             HandleWakeWordDetectedEvent();
         }
@@ -323,10 +349,14 @@ void Application::ActivationTask() {
     ota_ = std::make_unique<Ota>();
 
     // Check for new assets version
+    Trace::Begin("check_assets");
     CheckAssetsVersion();
+    Trace::End("check_assets");
 
     // Check for new firmware version
+    Trace::Begin("check_version");
     CheckNewVersion();
+    Trace::End("check_version");
 
     // Initialize the protocol
     InitializeProtocol();
@@ -354,9 +384,11 @@ void Application::CheckAssetsVersion() {
     Settings settings("assets", true);
     // Check if there is a new assets need to be downloaded
     std::string download_url = settings.GetString("download_url");
+    std::string download_sha256 = settings.GetString("download_sha256");
 
     if (!download_url.empty()) {
         settings.EraseKey("download_url");
+        settings.EraseKey("download_sha256");
 
         char message[256];
         snprintf(message, sizeof(message), Lang::Strings::FOUND_NEW_ASSETS, download_url.c_str());
@@ -374,7 +406,7 @@ void Application::CheckAssetsVersion() {
             Schedule([display, message = std::string(buffer)]() {
                 display->SetChatMessage("system", message.c_str());
             });
-        });
+        }, download_sha256);
 
         board.SetPowerSaveLevel(PowerSaveLevel::LOW_POWER);
         vTaskDelay(pdMS_TO_TICKS(1000));
@@ -431,7 +463,7 @@ void Application::CheckNewVersion() {
         retry_delay = 10; // Reset retry delay
 
         if (ota_->HasNewVersion()) {
-            if (UpgradeFirmware(ota_->GetFirmwareUrl(), ota_->GetFirmwareVersion())) {
+            if (UpgradeFirmware(ota_->GetFirmwareUrl(), ota_->GetFirmwareVersion(), ota_->GetFirmwareSha256())) {
                 return; // This line will never be reached after reboot
             }
             // If upgrade failed, continue to normal operation
@@ -495,6 +527,9 @@ void Application::InitializeProtocol() {
     
     protocol_->OnIncomingAudio([this](std::unique_ptr<AudioStreamPacket> packet) {
         if (GetDeviceState() == kDeviceStateSpeaking) {
+            if (first_audio_pending_.exchange(false)) {
+                Trace::Instant("first_audio_received");
+            }
             audio_service_.PushPacketToDecodeQueue(std::move(packet));
         }
     });
@@ -510,6 +545,7 @@ void Application::InitializeProtocol() {
     protocol_->OnAudioChannelClosed([this, &board]() {
         board.SetPowerSaveLevel(PowerSaveLevel::LOW_POWER);
         Schedule([this]() {
+            StopCameraStream();
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
@@ -522,6 +558,7 @@ void Application::InitializeProtocol() {
         if (strcmp(type->valuestring, "tts") == 0) {
             auto state = cJSON_GetObjectItem(root, "state");
             if (strcmp(state->valuestring, "start") == 0) {
+                tts_subtitle_open_ = false;
                 Schedule([this]() {
                     aborted_ = false;
                     SetDeviceState(kDeviceStateSpeaking);
@@ -540,8 +577,21 @@ void Application::InitializeProtocol() {
                 auto text = cJSON_GetObjectItem(root, "text");
                 if (cJSON_IsString(text)) {
                     ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    Schedule([display, message = std::string(text->valuestring)]() {
-                        display->SetChatMessage("assistant", message.c_str());
+                    std::string message = text->valuestring;
+                    bool append = tts_subtitle_open_;
+                    tts_subtitle_open_ = true;
+                    if (append && isalnum((unsigned char)message[0])) {
+                        message.insert(0, " ");
+                    }
+                    // The sentence arrives ahead of its audio, show it once the audio queued before it has played
+                    audio_service_.OnPlaybackReached([this, display, append, message = std::move(message)]() {
+                        Schedule([display, append, message]() {
+                            if (append) {
+                                display->AppendChatMessage("assistant", message.c_str());
+                            } else {
+                                display->SetChatMessage("assistant", message.c_str());
+                            }
+                        });
                     });
                 }
             }
@@ -562,7 +612,7 @@ void Application::InitializeProtocol() {
             }
         } else if (strcmp(type->valuestring, "mcp") == 0) {
             auto payload = cJSON_GetObjectItem(root, "payload");
-            if (cJSON_IsObject(payload)) {
+            if (cJSON_IsObject(payload) || cJSON_IsArray(payload)) {
                 McpServer::GetInstance().ParseMessage(payload);
             }
         } else if (strcmp(type->valuestring, "system") == 0) {
@@ -715,6 +765,7 @@ void Application::ContinueOpenAudioChannel(ListeningMode mode) {
     }
 
     if (!protocol_->IsAudioChannelOpened()) {
+        TRACE_SCOPE("open_audio_channel");
         if (!protocol_->OpenAudioChannel()) {
             return;
         }
@@ -779,6 +830,7 @@ void Application::HandleWakeWordDetectedEvent() {
     auto state = GetDeviceState();
     auto wake_word = audio_service_.GetLastWakeWord();
     ESP_LOGI(TAG, "Wake word detected: %s (state: %d)", wake_word.c_str(), (int)state);
+    Trace::Instant("wake_word_detected");
 
     if (state == kDeviceStateIdle) {
         audio_service_.EncodeWakeWord();
@@ -824,6 +876,7 @@ void Application::ContinueWakeWordInvoke(const std::string& wake_word) {
     }
 
     if (!protocol_->IsAudioChannelOpened()) {
+        TRACE_SCOPE("open_audio_channel");
         if (!protocol_->OpenAudioChannel()) {
             audio_service_.EnableWakeWordDetection(true);
             return;
@@ -858,6 +911,8 @@ void Application::HandleStateChangedEvent() {
     auto display = board.GetDisplay();
     auto led = board.GetLed();
     led->OnStateChanged();
+    bool idle = new_state == kDeviceStateIdle || new_state == kDeviceStateUnknown;
+    display->SetActivity(idle ? DisplayActivity::kIdle : DisplayActivity::kActive);
     
     switch (new_state) {
         case kDeviceStateUnknown:
@@ -913,6 +968,8 @@ void Application::HandleStateChangedEvent() {
                 audio_service_.EnableWakeWordDetection(audio_service_.IsAfeWakeWord());
             }
             audio_service_.ResetDecoder();
+            first_audio_pending_ = true;
+            audio_service_.TraceNextPlayback();
             break;
         case kDeviceStateWifiConfiguring:
             audio_service_.EnableVoiceProcessing(false);
@@ -962,7 +1019,7 @@ void Application::Reboot() {
     esp_restart();
 }
 
-bool Application::UpgradeFirmware(const std::string& url, const std::string& version) {
+bool Application::UpgradeFirmware(const std::string& url, const std::string& version, const std::string& sha256) {
     auto& board = Board::GetInstance();
     auto display = board.GetDisplay();
 
@@ -994,7 +1051,7 @@ bool Application::UpgradeFirmware(const std::string& url, const std::string& ver
         Schedule([display, message = std::string(buffer)]() {
             display->SetChatMessage("system", message.c_str());
         });
-    });
+    }, sha256);
 
     if (!upgrade_success) {
         // Upgrade failed, restart audio service and continue running
@@ -1073,6 +1130,24 @@ void Application::SendMcpMessage(const std::string& payload) {
     });
 }
 
+bool Application::StartCameraStream(const CameraStreamConfig& config) {
+    auto camera = Board::GetInstance().GetCamera();
+    if (camera == nullptr || !protocol_ || !protocol_->IsAudioChannelOpened()) {
+        return false;
+    }
+    camera->StopStreaming();
+    return camera->StartStreaming(config, [this]() {
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_VIDEO);
+    });
+}
+
+void Application::StopCameraStream() {
+    auto camera = Board::GetInstance().GetCamera();
+    if (camera != nullptr && camera->IsStreaming()) {
+        camera->StopStreaming();
+    }
+}
+
 void Application::SetAecMode(AecMode mode) {
     aec_mode_ = mode;
     Schedule([this]() {
@@ -10,8 +10,10 @@
 #include <mutex>
 #include <deque>
 #include <memory>
+#include <atomic>
 
 #include "protocol.h"
+#include "camera.h"
 #include "ota.h"
 #include "audio_service.h"
 #include "device_state.h"
@@ -31,6 +33,7 @@
 #define MAIN_EVENT_START_LISTENING      (1 << 10)
 #define MAIN_EVENT_STOP_LISTENING       (1 << 11)
 #define MAIN_EVENT_STATE_CHANGED        (1 << 12)
+#define MAIN_EVENT_SEND_VIDEO           (1 << 13)
 
 
 enum AecMode {
@@ -105,9 +108,16 @@ public:
 
     void Reboot();
     void WakeWordInvoke(const std::string& wake_word);
-    bool UpgradeFirmware(const std::string& url, const std::string& version = "");
+    bool UpgradeFirmware(const std::string& url, const std::string& version = "", const std::string& sha256 = "");
     bool CanEnterSleepMode();
     void SendMcpMessage(const std::string& payload);
+
+    /**
+     * Stream camera frames over the open audio channel (main task only)
+     * Queued frames are sent one per MAIN_EVENT_SEND_VIDEO wakeup, streaming stops when the channel closes
+     */
+    bool StartCameraStream(const CameraStreamConfig& config);
+    void StopCameraStream();
     void SetAecMode(AecMode mode);
     AecMode GetAecMode() const { return aec_mode_; }
     void PlaySound(const std::string_view& sound);
@@ -140,6 +150,8 @@ private:
     bool aborted_ = false;
     bool assets_version_checked_ = false;
     bool play_popup_on_listening_ = false;  // Flag to play popup sound after state changes to listening
+    std::atomic<bool> first_audio_pending_{false};  // Trace the first audio packet of each speaking turn
+    bool tts_subtitle_open_ = false;  // Later sentences of the speaking turn are appended to its bubble
     int clock_ticks_ = 0;
     TaskHandle_t activation_task_handle_ = nullptr;
 
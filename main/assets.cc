@@ -2,11 +2,16 @@
 #include "board.h"
 #include "display.h"
 #include "application.h"
+#include "settings.h"
+#include "checksum.h"
+#include "lz4_block.h"
+#include "trace.h"
 #include "lvgl_theme.h"
 #include "emote_display.h"
 #include "expression_emote.h"
 #if HAVE_LVGL
 #include "display/lcd_display.h"
+#include "gif/lvgl_gif.h"
 #include <spi_flash_mmap.h>
 #endif
 
@@ -14,10 +19,18 @@
 #include <esp_timer.h>
 #include <esp_heap_caps.h>
 #include <cbin_font.h>
+#include <cstring>
+#include <algorithm>
 
 
 #define TAG "Assets"
 #define PARTITION_LABEL "assets"
+#define PARTITION_LABEL_B "assets_b"
+
+// Every asset starts with a 2-byte magic, "ZZ" for raw data, "ZL" for an LZ4 block
+// prefixed by its 4-byte little-endian decompressed size
+#define ASSET_MAGIC_RAW 'Z'
+#define ASSET_MAGIC_LZ4 'L'
 
 struct mmap_assets_table {
     char asset_name[32];          /*!< Name of the asset */
@@ -33,8 +46,11 @@ Assets::Assets() {
 #else
     strategy_ = std::make_unique<Assets::EmoteStrategy>();
 #endif
-    // Initialize the partition
-    InitializePartition();
+    // Initialize the partition, fall back to the other bank if the active one is broken
+    if (FindPartition(this) && !InitializePartition() && ab_layout()) {
+        ESP_LOGW(TAG, "Assets bank %c is not valid, trying the other bank", 'A' + active_bank_);
+        ActivateBank(1 - active_bank_, false);
+    }
 }
 
 Assets::~Assets() {
@@ -42,16 +58,34 @@ Assets::~Assets() {
 }
 
 bool Assets::FindPartition(Assets* assets) {
-    assets->partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL);
-    if (assets->partition_ == nullptr) {
+    assets->banks_[0] = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL);
+    if (assets->banks_[0] == nullptr) {
         ESP_LOGI(TAG, "No assets partition found");
+        assets->partition_ = nullptr;
         return false;
     }
+
+    assets->banks_[1] = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL_B);
+    if (assets->banks_[1] != nullptr && assets->banks_[1]->size == assets->banks_[0]->size) {
+        Settings settings("assets");
+        assets->active_bank_ = settings.GetInt("bank", 0) == 1 ? 1 : 0;
+    } else {
+        if (assets->banks_[1] != nullptr) {
+            ESP_LOGW(TAG, "Partition %s differs in size from %s, A/B layout disabled", PARTITION_LABEL_B, PARTITION_LABEL);
+        }
+        assets->banks_[1] = nullptr;
+        assets->active_bank_ = 0;
+    }
+    assets->partition_ = assets->banks_[assets->active_bank_];
     return true;
 }
 
 bool Assets::Apply() {
-    return strategy_ ? strategy_->Apply(this) : false;
+    if (strategy_ == nullptr || !strategy_->Apply(this)) {
+        return false;
+    }
+    applied_ = true;
+    return true;
 }
 
 bool Assets::InitializePartition() {
@@ -68,6 +102,12 @@ bool Assets::GetAssetData(const std::string& name, void*& ptr, size_t& size) {
     return strategy_ ? strategy_->GetAssetData(this, name, ptr, size) : false;
 }
 
+void Assets::ReleaseAssetData(const std::string& name) {
+    if (strategy_) {
+        strategy_->ReleaseAssetData(this, name);
+    }
+}
+
 bool Assets::LoadSrmodelsFromIndex(Assets* assets, cJSON* root) {
     void* ptr = nullptr;
     size_t size = 0;
@@ -81,6 +121,7 @@ bool Assets::LoadSrmodelsFromIndex(Assets* assets, cJSON* root) {
         }
 
         root = cJSON_ParseWithLength(static_cast<char*>(ptr), size);
+        assets->ReleaseAssetData("index.json");
         if (root == nullptr) {
             ESP_LOGE(TAG, "The index.json file is not valid");
             return false;
@@ -120,18 +161,57 @@ bool Assets::LoadSrmodelsFromIndex(Assets* assets, cJSON* root) {
 
 #if HAVE_LVGL
 uint32_t Assets::LvglStrategy::CalculateChecksum(const char* data, uint32_t length) {
-    uint32_t checksum = 0;
-    for (uint32_t i = 0; i < length; i++) {
-        checksum += data[i];
+    TRACE_SCOPE("assets_checksum");
+    return Checksum::ByteSumParallel(data, length) & 0xFFFF;
+}
+
+bool Assets::LvglStrategy::LoadTable(Assets* assets, Mapping& mapping) {
+    uint32_t stored_files = *(uint32_t*)(mapping.root + 0);
+    uint32_t stored_chksum = *(uint32_t*)(mapping.root + 4);
+    uint32_t stored_len = *(uint32_t*)(mapping.root + 8);
+
+    if (stored_len > assets->partition_->size - 12) {
+        ESP_LOGD(TAG, "The stored_len (0x%lx) is greater than the partition size (0x%lx) - 12", stored_len, assets->partition_->size);
+        return false;
     }
-    return checksum & 0xFFFF;
+
+    auto start_time = esp_timer_get_time();
+    uint32_t calculated_checksum = CalculateChecksum(mapping.root + 12, stored_len);
+    auto end_time = esp_timer_get_time();
+    ESP_LOGI(TAG, "The checksum calculation time is %d ms", int((end_time - start_time) / 1000));
+
+    if (calculated_checksum != stored_chksum) {
+        ESP_LOGE(TAG, "The calculated checksum (0x%lx) does not match the stored checksum (0x%lx)", calculated_checksum, stored_chksum);
+        return false;
+    }
+
+    size_t compressed_count = 0;
+    for (uint32_t i = 0; i < stored_files; i++) {
+        auto item = (const mmap_assets_table*)(mapping.root + 12 + i * sizeof(mmap_assets_table));
+        auto asset = Asset{
+            .size = static_cast<size_t>(item->asset_size),
+            .offset = static_cast<size_t>(12 + sizeof(mmap_assets_table) * stored_files + item->asset_offset),
+            .compressed = false,
+            .raw_size = static_cast<size_t>(item->asset_size)
+        };
+        auto data = mapping.root + asset.offset;
+        if (data[0] == ASSET_MAGIC_RAW && data[1] == ASSET_MAGIC_LZ4 && asset.size >= 4) {
+            uint32_t raw_size;
+            memcpy(&raw_size, data + 2, sizeof(raw_size));
+            asset.compressed = true;
+            asset.raw_size = raw_size;
+            compressed_count++;
+        }
+        mapping.assets[item->asset_name] = asset;
+    }
+    if (compressed_count > 0) {
+        ESP_LOGI(TAG, "%u of %lu assets are compressed", compressed_count, stored_files);
+    }
+    return true;
 }
 
 bool Assets::LvglStrategy::InitializePartition(Assets* assets) {
-    assets->partition_valid_ = false;
-    assets_.clear();
-
-    if (!Assets::FindPartition(assets)) {
+    if (assets->partition_ == nullptr) {
         return false;
     }
 
@@ -144,73 +224,250 @@ bool Assets::LvglStrategy::InitializePartition(Assets* assets) {
         return false;
     }
 
-    esp_err_t err = esp_partition_mmap(assets->partition_, 0, assets->partition_->size, ESP_PARTITION_MMAP_DATA, (const void**)&mmap_root_, &mmap_handle_);
+    auto mapping = std::make_unique<Mapping>();
+    esp_err_t err = esp_partition_mmap(assets->partition_, 0, assets->partition_->size, ESP_PARTITION_MMAP_DATA, (const void**)&mapping->root, &mapping->handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to mmap assets partition: %s", esp_err_to_name(err));
         return false;
     }
 
+    bool valid = LoadTable(assets, *mapping);
+    if (!valid && current_ != nullptr) {
+        // Keep serving the partition already in use
+        ReleaseMapping(mapping);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    ReleaseMapping(previous_);
+    previous_ = std::move(current_);
+    current_ = std::move(mapping);
     assets->partition_valid_ = true;
+    return valid;
+}
 
-    uint32_t stored_files = *(uint32_t*)(mmap_root_ + 0);
-    uint32_t stored_chksum = *(uint32_t*)(mmap_root_ + 4);
-    uint32_t stored_len = *(uint32_t*)(mmap_root_ + 8);
+void Assets::LvglStrategy::ReleaseMapping(std::unique_ptr<Mapping>& mapping) {
+    if (mapping == nullptr) {
+        return;
+    }
+    for (auto& entry : mapping->cache) {
+        heap_caps_free(entry.second.data);
+    }
+    if (mapping->handle != 0) {
+        esp_partition_munmap(mapping->handle);
+    }
+    mapping.reset();
+}
 
-    if (stored_len > assets->partition_->size - 12) {
-        ESP_LOGD(TAG, "The stored_len (0x%lx) is greater than the partition size (0x%lx) - 12", stored_len, assets->partition_->size);
-        return false;
+void Assets::LvglStrategy::EvictCache(Mapping& mapping, size_t required) {
+    // The budget only drives eviction, an asset larger than it is still decompressed on its own
+    const size_t budget = CONFIG_ASSETS_DECOMPRESS_CACHE_SIZE * 1024;
+    // Walk from the least recently used end, skipping assets still in use
+    auto it = mapping.lru.end();
+    while (mapping.cache_used + required > budget && it != mapping.lru.begin()) {
+        --it;
+        auto entry = mapping.cache.find(*it);
+        if (entry->second.pins > 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Evict decompressed asset %s (%u bytes)", it->c_str(), entry->second.size);
+        heap_caps_free(entry->second.data);
+        mapping.cache_used -= entry->second.size;
+        mapping.cache.erase(entry);
+        it = mapping.lru.erase(it);
+    }
+    if (mapping.cache_used + required > budget) {
+        ESP_LOGW(TAG, "Decompressed assets use %u KB, over the %d KB budget", (mapping.cache_used + required) / 1024,
+            CONFIG_ASSETS_DECOMPRESS_CACHE_SIZE);
+    }
+}
+
+uint8_t* Assets::LvglStrategy::Decompress(Mapping& mapping, const std::string& name, const Asset& asset) {
+    EvictCache(mapping, asset.raw_size);
+
+    auto buffer = (uint8_t*)heap_caps_malloc_prefer(asset.raw_size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+    if (buffer == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for asset %s", asset.raw_size, name.c_str());
+        return nullptr;
     }
 
     auto start_time = esp_timer_get_time();
-    uint32_t calculated_checksum = CalculateChecksum(mmap_root_ + 12, stored_len);
+    auto src = (const uint8_t*)(mapping.root + asset.offset + 2 + 4);
+    if (!Lz4DecompressBlock(src, asset.size - 4, buffer, asset.raw_size)) {
+        ESP_LOGE(TAG, "Failed to decompress asset %s", name.c_str());
+        heap_caps_free(buffer);
+        return nullptr;
+    }
     auto end_time = esp_timer_get_time();
-    ESP_LOGI(TAG, "The checksum calculation time is %d ms", int((end_time - start_time) / 1000));
+    ESP_LOGI(TAG, "Decompressed asset %s (%u -> %u bytes) in %d ms", name.c_str(),
+        asset.size - 4, asset.raw_size, int((end_time - start_time) / 1000));
 
-    if (calculated_checksum != stored_chksum) {
-        ESP_LOGE(TAG, "The calculated checksum (0x%lx) does not match the stored checksum (0x%lx)", calculated_checksum, stored_chksum);
+    mapping.cache[name] = CacheEntry{ .data = buffer, .size = asset.raw_size, .pins = 0 };
+    mapping.lru.push_front(name);
+    mapping.cache_used += asset.raw_size;
+    return buffer;
+}
+
+void Assets::LvglStrategy::Unpin(Mapping& mapping, const std::string& name) {
+    auto entry = mapping.cache.find(name);
+    if (entry != mapping.cache.end() && entry->second.pins > 0) {
+        entry->second.pins--;
+    }
+}
+
+bool Assets::LvglStrategy::GetThemeAssetData(Assets* assets, const std::string& name, void*& ptr, size_t& size) {
+    if (!GetAssetData(assets, name, ptr, size)) {
         return false;
     }
+    // The themes hold the asset until they are applied again or the mapping is released
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    current_->theme_pins.push_back(name);
+    return true;
+}
 
-    checksum_valid_ = true;
+void Assets::LvglStrategy::UnpinStaleThemeAssets() {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (current_ == nullptr) {
+        return;
+    }
+    for (auto& name : current_->stale_theme_pins) {
+        Unpin(*current_, name);
+    }
+    current_->stale_theme_pins.clear();
+}
 
-    for (uint32_t i = 0; i < stored_files; i++) {
-        auto item = (const mmap_assets_table*)(mmap_root_ + 12 + i * sizeof(mmap_assets_table));
-        auto asset = Asset{
-            .size = static_cast<size_t>(item->asset_size),
-            .offset = static_cast<size_t>(12 + sizeof(mmap_assets_table) * stored_files + item->asset_offset)
-        };
-        assets_[item->asset_name] = asset;
+void Assets::LvglStrategy::SaveBuiltinThemes() {
+    if (!builtin_themes_.empty()) {
+        return;
+    }
+    auto& theme_manager = LvglThemeManager::GetInstance();
+    for (auto name : { "light", "dark" }) {
+        auto theme = theme_manager.GetTheme(name);
+        if (theme != nullptr) {
+            builtin_themes_[name] = ThemeResources{
+                .text_font = theme->text_font(),
+                .emoji_collection = theme->emoji_collection(),
+                .background_image = theme->background_image()
+            };
+        }
     }
-    return checksum_valid_;
+}
+
+void Assets::LvglStrategy::RestoreBuiltinThemes(bool refresh) {
+    if (builtin_themes_.empty()) {
+        return;
+    }
+    auto display = Board::GetInstance().GetDisplay();
+    DisplayLockGuard lock(display);
+    auto& theme_manager = LvglThemeManager::GetInstance();
+    for (auto& [name, resources] : builtin_themes_) {
+        auto theme = theme_manager.GetTheme(name);
+        if (theme != nullptr) {
+            theme->set_text_font(resources.text_font);
+            theme->set_emoji_collection(resources.emoji_collection);
+            theme->set_background_image(resources.background_image);
+        }
+    }
+    auto current_theme = display->GetTheme();
+    if (refresh && current_theme != nullptr) {
+        display->SetTheme(current_theme);
+    }
+}
+
+void Assets::LvglStrategy::DetachDisplay() {
+    // The emoji and the images LVGL decoded may still point into the assets being released
+    auto display = Board::GetInstance().GetDisplay();
+    DisplayLockGuard lock(display);
+    auto lcd_display = dynamic_cast<LcdDisplay*>(display);
+    if (lcd_display != nullptr) {
+        lcd_display->ReloadEmotion();
+    }
+    LvglGif::ClearFrameCache();
+    lv_image_cache_drop(nullptr);
 }
 
 void Assets::LvglStrategy::UnApplyPartition(Assets* assets) {
-    if (mmap_handle_ != 0) {
-        esp_partition_munmap(mmap_handle_);
-        mmap_handle_ = 0;
-        mmap_root_ = nullptr;
+    // Move the UI off the assets before their memory goes away
+    RestoreBuiltinThemes(true);
+    DetachDisplay();
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    ReleaseMapping(previous_);
+    ReleaseMapping(current_);
+    assets->partition_valid_ = false;
+}
+
+void Assets::LvglStrategy::RestorePrevious(Assets* assets) {
+    // A failed Apply may have left part of the released assets in the themes
+    RestoreBuiltinThemes(false);
+    DetachDisplay();
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (previous_ != nullptr) {
+        ReleaseMapping(current_);
+        current_ = std::move(previous_);
     }
-    checksum_valid_ = false;
-    assets_.clear();
+    (void)assets; // Unused parameter
+}
+
+void Assets::LvglStrategy::ReleasePrevious(Assets* assets) {
+    // Apply has already moved the themes to the new bank, rebuild the emoji from them
+    DetachDisplay();
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    ReleaseMapping(previous_);
     (void)assets; // Unused parameter
 }
 
 bool Assets::LvglStrategy::GetAssetData(Assets* assets, const std::string& name, void*& ptr, size_t& size) {
-    auto asset = assets_.find(name);
-    if (asset == assets_.end()) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (current_ == nullptr) {
+        return false;
+    }
+    auto& mapping = *current_;
+    auto asset = mapping.assets.find(name);
+    if (asset == mapping.assets.end()) {
         return false;
     }
-    auto data = (const char*)(mmap_root_ + asset->second.offset);
-    if (data[0] != 'Z' || data[1] != 'Z') {
+    auto data = (const char*)(mapping.root + asset->second.offset);
+    if (data[0] != ASSET_MAGIC_RAW || (data[1] != ASSET_MAGIC_RAW && data[1] != ASSET_MAGIC_LZ4)) {
         ESP_LOGE(TAG, "The asset %s is not valid with magic %02x%02x", name.c_str(), data[0], data[1]);
         return false;
     }
 
-    ptr = static_cast<void*>(const_cast<char*>(data + 2));
-    size = asset->second.size;
+    if (!asset->second.compressed) {
+        // Zero-copy path, served straight from the mmapped partition
+        ptr = static_cast<void*>(const_cast<char*>(data + 2));
+        size = asset->second.size;
+        return true;
+    }
+
+    uint8_t* buffer = nullptr;
+    auto entry = mapping.cache.find(name);
+    if (entry != mapping.cache.end()) {
+        buffer = entry->second.data;
+        mapping.lru.remove(name);
+        mapping.lru.push_front(name);
+    } else {
+        buffer = Decompress(mapping, name, asset->second);
+        if (buffer == nullptr) {
+            return false;
+        }
+        entry = mapping.cache.find(name);
+    }
+    entry->second.pins++;
+    ptr = static_cast<void*>(buffer);
+    size = asset->second.raw_size;
+    (void)assets; // Unused parameter
     return true;
 }
 
+void Assets::LvglStrategy::ReleaseAssetData(Assets* assets, const std::string& name) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (current_ == nullptr) {
+        return;
+    }
+    Unpin(*current_, name);
+    (void)assets; // Unused parameter
+}
+
 bool Assets::LvglStrategy::Apply(Assets* assets) {
     void* ptr = nullptr;
     size_t size = 0;
@@ -220,6 +477,7 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
     }
 
     cJSON* root = cJSON_ParseWithLength(static_cast<char*>(ptr), size);
+    assets->ReleaseAssetData("index.json");
     if (root == nullptr) {
         ESP_LOGE(TAG, "The index.json file is not valid");
         return false;
@@ -235,6 +493,17 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
 
     Assets::LoadSrmodelsFromIndex(assets, root);
 
+    // Start from the firmware resources, so nothing from a previously applied bank is kept
+    SaveBuiltinThemes();
+    RestoreBuiltinThemes(false);
+    {
+        // The assets the old themes pinned stay cached until the new themes replace them on screen
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto& mapping = *current_;
+        mapping.stale_theme_pins.insert(mapping.stale_theme_pins.end(), mapping.theme_pins.begin(), mapping.theme_pins.end());
+        mapping.theme_pins.clear();
+    }
+
     auto& theme_manager = LvglThemeManager::GetInstance();
     auto light_theme = theme_manager.GetTheme("light");
     auto dark_theme = theme_manager.GetTheme("dark");
@@ -242,7 +511,7 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
     cJSON* font = cJSON_GetObjectItem(root, "text_font");
     if (cJSON_IsString(font)) {
         std::string fonts_text_file = font->valuestring;
-        if (assets->GetAssetData(fonts_text_file, ptr, size)) {
+        if (GetThemeAssetData(assets, fonts_text_file, ptr, size)) {
             auto text_font = std::make_shared<LvglCBinFont>(ptr);
             if (text_font->font() == nullptr) {
                 ESP_LOGE(TAG, "Failed to load fonts.bin");
@@ -254,6 +523,12 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
             if (dark_theme != nullptr) {
                 dark_theme->set_text_font(text_font);
             }
+            cJSON* hot_glyphs = cJSON_GetObjectItem(root, "hot_glyphs");
+            if (cJSON_IsString(hot_glyphs)) {
+                // Glyphs go into the LVGL font cache, which belongs to the LVGL task
+                DisplayLockGuard lock(Board::GetInstance().GetDisplay());
+                text_font->WarmUp(hot_glyphs->valuestring);
+            }
         } else {
             ESP_LOGE(TAG, "The font file %s is not found", fonts_text_file.c_str());
         }
@@ -270,7 +545,7 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
                 cJSON* file = cJSON_GetObjectItem(emoji, "file");
                 cJSON* eaf = cJSON_GetObjectItem(emoji, "eaf");
                 if (cJSON_IsString(name) && cJSON_IsString(file) && (NULL== eaf)) {
-                    if (!assets->GetAssetData(file->valuestring, ptr, size)) {
+                    if (!GetThemeAssetData(assets, file->valuestring, ptr, size)) {
                         ESP_LOGE(TAG, "Emoji %s image file %s is not found", name->valuestring, file->valuestring);
                         continue;
                     }
@@ -301,7 +576,7 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
                 light_theme->set_chat_background_color(LvglTheme::ParseColor(background_color->valuestring));
             }
             if (cJSON_IsString(background_image)) {
-                if (!assets->GetAssetData(background_image->valuestring, ptr, size)) {
+                if (!GetThemeAssetData(assets, background_image->valuestring, ptr, size)) {
                     ESP_LOGE(TAG, "The background image file %s is not found", background_image->valuestring);
                     return false;
                 }
@@ -322,7 +597,7 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
                 dark_theme->set_chat_background_color(LvglTheme::ParseColor(background_color->valuestring));
             }
             if (cJSON_IsString(background_image)) {
-                if (!assets->GetAssetData(background_image->valuestring, ptr, size)) {
+                if (!GetThemeAssetData(assets, background_image->valuestring, ptr, size)) {
                     ESP_LOGE(TAG, "The background image file %s is not found", background_image->valuestring);
                     return false;
                 }
@@ -339,6 +614,7 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
     if (current_theme != nullptr) {
         display->SetTheme(current_theme);
     }
+    UnpinStaleThemeAssets();
 
     // Parse hide_subtitle configuration
     cJSON* hide_subtitle = cJSON_GetObjectItem(root, "hide_subtitle");
@@ -359,10 +635,15 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
 bool Assets::EmoteStrategy::InitializePartition(Assets* assets) {
     assets->partition_valid_ = false;
 
-    if (!Assets::FindPartition(assets)) {
+    if (assets->partition_ == nullptr) {
         return false;
     }
 
+    // The emote engine holds one set of assets at a time
+    if (mounted_) {
+        UnApplyPartition(assets);
+    }
+
     esp_err_t ret = ESP_ERR_INVALID_STATE;
     auto display = Board::GetInstance().GetDisplay();
     auto* emote_display = dynamic_cast<emote::EmoteDisplay*>(display);
@@ -370,7 +651,7 @@ bool Assets::EmoteStrategy::InitializePartition(Assets* assets) {
         const emote_data_t data = {
             .type = EMOTE_SOURCE_PARTITION,
             .source = {
-                .partition_label = PARTITION_LABEL,
+                .partition_label = assets->partition_->label,
             },
             .flags = {
                 .mmap_enable = true, //must be true here!!!
@@ -381,6 +662,7 @@ bool Assets::EmoteStrategy::InitializePartition(Assets* assets) {
         ESP_LOGE(TAG, "Emote display is not initialized");
     }
     assets->partition_valid_ = ((ret == ESP_OK) ? true : false);
+    mounted_ = assets->partition_valid_;
     return assets->partition_valid_;
 }
 
@@ -390,6 +672,7 @@ void Assets::EmoteStrategy::UnApplyPartition(Assets* assets) {
     if (emote_display && emote_display->GetEmoteHandle() != nullptr) {
         emote_unmount_assets(emote_display->GetEmoteHandle());
     }
+    mounted_ = false;
     (void)assets; // Unused parameter
 }
 
@@ -423,11 +706,22 @@ bool Assets::EmoteStrategy::Apply(Assets* assets) {
     return true;
 }
 
-bool Assets::Download(std::string url, std::function<void(int progress, size_t speed)> progress_callback) {
+bool Assets::Download(std::string url, std::function<void(int progress, size_t speed)> progress_callback,
+    const std::string& expected_sha256) {
     ESP_LOGI(TAG, "Downloading new version of assets from %s", url.c_str());
 
-    // 取消当前资源分区的内存映射
-    UnApplyPartition();
+    // A/B 布局下写入非活动分区，下载期间继续使用当前资源
+    int target_bank = ab_layout() ? 1 - active_bank_ : active_bank_;
+    auto target = ab_layout() ? banks_[target_bank] : partition_;
+    if (target == nullptr) {
+        ESP_LOGE(TAG, "No assets partition to download to");
+        return false;
+    }
+
+    if (!ab_layout()) {
+        // 取消当前资源分区的内存映射
+        UnApplyPartition();
+    }
 
     // 下载新的资源文件
     auto network = Board::GetInstance().GetNetwork();
@@ -449,8 +743,8 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
         return false;
     }
 
-    if (content_length > partition_->size) {
-        ESP_LOGE(TAG, "Assets file size (%u) is larger than partition size (%lu)", content_length, partition_->size);
+    if (content_length > target->size) {
+        ESP_LOGE(TAG, "Assets file size (%u) is larger than partition size (%lu)", content_length, target->size);
         return false;
     }
 
@@ -461,8 +755,8 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
     size_t sectors_to_erase = (content_length + SECTOR_SIZE - 1) / SECTOR_SIZE; // 向上取整
     size_t total_erase_size = sectors_to_erase * SECTOR_SIZE;
     
-    ESP_LOGI(TAG, "Sector size: %u, content length: %u, sectors to erase: %u, total erase size: %u", 
-             SECTOR_SIZE, content_length, sectors_to_erase, total_erase_size);
+    ESP_LOGI(TAG, "Writing to partition %s, sector size: %u, content length: %u, sectors to erase: %u, total erase size: %u", 
+             target->label, SECTOR_SIZE, content_length, sectors_to_erase, total_erase_size);
     
     // 写入新的资源文件到分区，一边erase一边写入
     char* buffer = (char*)heap_caps_malloc(SECTOR_SIZE, MALLOC_CAP_INTERNAL);
@@ -470,6 +764,13 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
         ESP_LOGE(TAG, "Failed to allocate buffer");
         return false;
     }
+
+    // 边下载边校验：SHA-256 覆盖整个文件，16 位校验和覆盖文件头之后的数据
+    Sha256 sha256;
+    uint8_t header[12];
+    size_t payload_end = SIZE_MAX;
+    uint32_t checksum = 0;
+
     size_t total_written = 0;
     size_t recent_written = 0;
     size_t current_sector = 0;
@@ -487,6 +788,23 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
             break;
         }
 
+        sha256.Update(buffer, ret);
+        size_t chunk_end = total_written + ret;
+        if (total_written < sizeof(header)) {
+            size_t header_bytes = std::min(chunk_end, sizeof(header)) - total_written;
+            memcpy(header + total_written, buffer, header_bytes);
+            if (chunk_end >= sizeof(header)) {
+                uint32_t stored_len;
+                memcpy(&stored_len, header + 8, sizeof(stored_len));
+                payload_end = sizeof(header) + stored_len;
+            }
+        }
+        size_t sum_start = std::max(total_written, sizeof(header));
+        size_t sum_end = std::min(chunk_end, payload_end);
+        if (sum_end > sum_start) {
+            checksum = Checksum::ByteSum(buffer + (sum_start - total_written), sum_end - sum_start, checksum);
+        }
+
         // 检查是否需要擦除新的扇区
         size_t write_end_offset = total_written + ret;
         size_t needed_sectors = (write_end_offset + SECTOR_SIZE - 1) / SECTOR_SIZE;
@@ -497,14 +815,14 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
             size_t sector_end = (current_sector + 1) * SECTOR_SIZE;
             
             // 确保擦除范围不超过分区大小
-            if (sector_end > partition_->size) {
-                ESP_LOGE(TAG, "Sector end (%u) exceeds partition size (%lu)", sector_end, partition_->size);
+            if (sector_end > target->size) {
+                ESP_LOGE(TAG, "Sector end (%u) exceeds partition size (%lu)", sector_end, target->size);
                 heap_caps_free(buffer);
                 return false;
             }
             
             ESP_LOGD(TAG, "Erasing sector %u (offset: %u, size: %u)", current_sector, sector_start, SECTOR_SIZE);
-            esp_err_t err = esp_partition_erase_range(partition_, sector_start, SECTOR_SIZE);
+            esp_err_t err = esp_partition_erase_range(target, sector_start, SECTOR_SIZE);
             if (err != ESP_OK) {
                 ESP_LOGE(TAG, "Failed to erase sector %u at offset %u: %s", current_sector, sector_start, esp_err_to_name(err));
                 heap_caps_free(buffer);
@@ -515,7 +833,7 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
         }
 
         // 写入数据到分区
-        esp_err_t err = esp_partition_write(partition_, total_written, buffer, ret);
+        esp_err_t err = esp_partition_write(target, total_written, buffer, ret);
         if (err != ESP_OK) {
             ESP_LOGE(TAG, "Failed to write to assets partition at offset %u: %s", total_written, esp_err_to_name(err));
             heap_caps_free(buffer);
@@ -540,6 +858,8 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
     }
     
     http->Close();
+
+    std::string digest = sha256.FinishHex();
     heap_caps_free(buffer);
 
     if (total_written != content_length) {
@@ -550,6 +870,31 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
     ESP_LOGI(TAG, "Assets download completed, total written: %u bytes, total sectors erased: %u", 
              total_written, current_sector);
 
+    // 校验通过之前不切换分区
+    uint32_t stored_checksum;
+    memcpy(&stored_checksum, header + 4, sizeof(stored_checksum));
+    if (payload_end > total_written || (checksum & 0xFFFF) != stored_checksum) {
+        ESP_LOGE(TAG, "The downloaded assets checksum (0x%lx) does not match the stored checksum (0x%lx)",
+            checksum & 0xFFFF, stored_checksum);
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Assets SHA-256: %s", digest.c_str());
+    if (!Sha256::Matches(digest, expected_sha256)) {
+        ESP_LOGE(TAG, "The assets SHA-256 does not match the expected %s", expected_sha256.c_str());
+        return false;
+    }
+
+    if (ab_layout()) {
+        // 新分区映射并应用成功后才释放原分区，失败则继续使用原分区
+        if (!ActivateBank(target_bank, applied_)) {
+            ESP_LOGE(TAG, "Failed to activate assets bank %c, staying on bank %c", 'A' + target_bank, 'A' + active_bank_);
+            return false;
+        }
+        ESP_LOGI(TAG, "Switched to assets bank %c", 'A' + target_bank);
+        return true;
+    }
+
     // 重新初始化资源分区
     if (!InitializePartition()) {
         ESP_LOGE(TAG, "Failed to re-initialize assets partition");
@@ -558,3 +903,51 @@ bool Assets::Download(std::string url, std::function<void(int progress, size_t s
 
     return true;
 }
+
+// Map the bank and optionally apply it before the current bank is released, so LVGL
+// never refers to an unmapped partition. The bank is only persisted on success.
+bool Assets::ActivateBank(int bank, bool apply) {
+    int previous_bank = active_bank_;
+    active_bank_ = bank;
+    partition_ = banks_[bank];
+    if (!InitializePartition()) {
+        active_bank_ = previous_bank;
+        partition_ = banks_[previous_bank];
+        return false;
+    }
+
+    if (apply) {
+        auto display = Board::GetInstance().GetDisplay();
+        DisplayLockGuard lock(display);
+        if (!Apply()) {
+            ESP_LOGE(TAG, "Failed to apply assets bank %c, restoring bank %c", 'A' + bank, 'A' + previous_bank);
+            active_bank_ = previous_bank;
+            partition_ = banks_[previous_bank];
+            strategy_->RestorePrevious(this);
+            if (applied_) {
+                Apply();
+            }
+            return false;
+        }
+    }
+    strategy_->ReleasePrevious(this);
+
+    Settings settings("assets", true);
+    settings.SetInt("bank", bank);
+    return true;
+}
+
+bool Assets::SwitchBank() {
+    if (!ab_layout()) {
+        ESP_LOGW(TAG, "The assets partition has no A/B layout");
+        return false;
+    }
+
+    int previous_bank = active_bank_;
+    if (!ActivateBank(1 - previous_bank, true)) {
+        ESP_LOGE(TAG, "Assets bank %c is not valid, staying on bank %c", 'A' + (1 - previous_bank), 'A' + previous_bank);
+        return false;
+    }
+    ESP_LOGI(TAG, "Switched to assets bank %c", 'A' + active_bank_);
+    return true;
+}
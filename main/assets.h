@@ -9,15 +9,24 @@
 #include <esp_partition.h>
 #include <model_path.h>
 #include <map>
+#include <list>
+#include <vector>
+#include <mutex>
 #include <string>
 
 #if HAVE_LVGL
 #include <spi_flash_mmap.h>
 #endif
 
+class LvglFont;
+class LvglImage;
+class EmojiCollection;
+
 struct Asset {
     size_t size;
     size_t offset;
+    bool compressed;    // Stored as an LZ4 block, decompressed into the cache on first use
+    size_t raw_size;    // Decompressed size, equals size for uncompressed assets
 };
 
 class Assets {
@@ -28,11 +37,18 @@ public:
     }
     ~Assets();
 
-    bool Download(std::string url, std::function<void(int progress, size_t speed)> progress_callback);
+    bool Download(std::string url, std::function<void(int progress, size_t speed)> progress_callback,
+        const std::string& expected_sha256 = "");
     bool Apply();
+    // Switch to and apply the other bank of an A/B layout if it holds valid assets, no download needed
+    bool SwitchBank();
     bool GetAssetData(const std::string& name, void*& ptr, size_t& size);
+    // Allow a decompressed asset to be evicted from the cache, the pointer must not be used afterwards
+    void ReleaseAssetData(const std::string& name);
 
     inline bool partition_valid() const { return partition_valid_; }
+    inline bool ab_layout() const { return banks_[1] != nullptr; }
+    inline int active_bank() const { return active_bank_; }
     inline std::string default_assets_url() const { return default_assets_url_; }
 
 private:
@@ -42,6 +58,7 @@ private:
 
     bool InitializePartition();
     void UnApplyPartition();
+    bool ActivateBank(int bank, bool apply);
     static bool FindPartition(Assets* assets);
     static bool LoadSrmodelsFromIndex(Assets* assets, cJSON* root = nullptr);
   
@@ -51,7 +68,12 @@ private:
         virtual bool Apply(Assets* assets) = 0;
         virtual bool InitializePartition(Assets* assets) = 0;
         virtual void UnApplyPartition(Assets* assets) = 0;
+        // Go back to the partition mapped before the last successful InitializePartition
+        virtual void RestorePrevious(Assets* assets) { InitializePartition(assets); }
+        // Drop the partition replaced by the last InitializePartition once nothing refers to it
+        virtual void ReleasePrevious(Assets* assets) {}
         virtual bool GetAssetData(Assets* assets, const std::string& name, void*& ptr, size_t& size) = 0;
+        virtual void ReleaseAssetData(Assets* assets, const std::string& name) {}
     };
     
     class LvglStrategy : public AssetStrategy {
@@ -59,13 +81,56 @@ private:
         bool Apply(Assets* assets) override;
         bool InitializePartition(Assets* assets) override;
         void UnApplyPartition(Assets* assets) override;
+        void RestorePrevious(Assets* assets) override;
+        void ReleasePrevious(Assets* assets) override;
         bool GetAssetData(Assets* assets, const std::string& name, void*& ptr, size_t& size) override;
+        void ReleaseAssetData(Assets* assets, const std::string& name) override;
     private:
+        struct CacheEntry {
+            uint8_t* data;
+            size_t size;
+            int pins;
+        };
+
+        // A mapped partition with its own decompress cache, so the one being replaced
+        // stays readable until the UI has moved to the new one
+        struct Mapping {
+            esp_partition_mmap_handle_t handle = 0;
+            const char* root = nullptr;
+            std::map<std::string, Asset> assets;
+            // Decompressed assets, most recently used at the front of lru
+            std::map<std::string, CacheEntry> cache;
+            std::list<std::string> lru;
+            size_t cache_used = 0;
+            // Assets pinned by the applied themes, and those pinned by the themes they replaced
+            // which are unpinned once the new themes are on screen
+            std::vector<std::string> theme_pins;
+            std::vector<std::string> stale_theme_pins;
+        };
+
+        // Theme resources built into the firmware, put back before the assets replacing them are freed
+        struct ThemeResources {
+            std::shared_ptr<LvglFont> text_font;
+            std::shared_ptr<EmojiCollection> emoji_collection;
+            std::shared_ptr<LvglImage> background_image;
+        };
+
         static uint32_t CalculateChecksum(const char* data, uint32_t length);
-        std::map<std::string, Asset> assets_;
-        esp_partition_mmap_handle_t mmap_handle_ = 0;
-        const char* mmap_root_ = nullptr;
-        bool checksum_valid_ = false;
+        static bool LoadTable(Assets* assets, Mapping& mapping);
+        static void ReleaseMapping(std::unique_ptr<Mapping>& mapping);
+        static uint8_t* Decompress(Mapping& mapping, const std::string& name, const Asset& asset);
+        static void EvictCache(Mapping& mapping, size_t required);
+        static void Unpin(Mapping& mapping, const std::string& name);
+        bool GetThemeAssetData(Assets* assets, const std::string& name, void*& ptr, size_t& size);
+        void UnpinStaleThemeAssets();
+        void SaveBuiltinThemes();
+        void RestoreBuiltinThemes(bool refresh);
+        void DetachDisplay();
+
+        std::unique_ptr<Mapping> current_;
+        std::unique_ptr<Mapping> previous_;
+        std::mutex cache_mutex_;
+        std::map<std::string, ThemeResources> builtin_themes_;
     };
     
     class EmoteStrategy : public AssetStrategy {
@@ -74,6 +139,8 @@ private:
         bool InitializePartition(Assets* assets) override;
         void UnApplyPartition(Assets* assets) override;
         bool GetAssetData(Assets* assets, const std::string& name, void*& ptr, size_t& size) override;
+    private:
+        bool mounted_ = false;
     };
     
     // Strategy instance
@@ -81,7 +148,11 @@ private:
 
 protected:
     const esp_partition_t* partition_ = nullptr;
+    // Bank A is the "assets" partition, bank B the optional "assets_b" partition
+    const esp_partition_t* banks_[2] = { nullptr, nullptr };
+    int active_bank_ = 0;
     bool partition_valid_ = false;
+    bool applied_ = false;
     std::string default_assets_url_;
     srmodel_list_t* models_list_ = nullptr;
 };
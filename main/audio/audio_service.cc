@@ -1,4 +1,5 @@
 #include "audio_service.h"
+#include "trace.h"
 #include <esp_log.h>
 #include <cstring>
 
@@ -315,6 +316,20 @@ void AudioService::AudioOutputTask() {
             codec_->EnableOutput(true);
         }
         codec_->OutputData(task->pcm);
+        if (trace_next_playback_.exchange(false)) {
+            Trace::Instant("first_audio_played");
+        }
+
+        /* Advance the playback position and run the callbacks it reached */
+        if (task->duration_ms > 0) {
+            lock.lock();
+            played_ms_ += task->duration_ms;
+            auto reached = TakeReachedPlaybackMarkers();
+            lock.unlock();
+            for (auto& callback : reached) {
+                callback();
+            }
+        }
 
         /* Update the last output time */
         last_output_time_ = std::chrono::steady_clock::now();
@@ -354,6 +369,7 @@ void AudioService::OpusCodecTask() {
             auto task = std::make_unique<AudioTask>();
             task->type = kAudioTaskTypeDecodeToPlaybackQueue;
             task->timestamp = packet->timestamp;
+            task->duration_ms = packet->frame_duration;
 
             SetDecodeSampleRate(packet->sample_rate, packet->frame_duration);
             if (opus_decoder_ != nullptr) {
@@ -392,10 +408,13 @@ void AudioService::OpusCodecTask() {
                 } else {
                     ESP_LOGE(TAG, "Failed to decode audio after resize, error code: %d", ret);
                     lock.lock();
+                    /* Count the lost frame as played, so the playback position keeps up */
+                    played_ms_ += packet->frame_duration;
                 }
             } else {
                 ESP_LOGE(TAG, "Audio decoder is not configured");
                 lock.lock();
+                played_ms_ += packet->frame_duration;
             }
             debug_statistics_.decode_count++;
         }
@@ -520,11 +539,32 @@ bool AudioService::PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> pa
             return false;
         }
     }
+    queued_ms_ += packet->frame_duration;
     audio_decode_queue_.push_back(std::move(packet));
     audio_queue_cv_.notify_all();
     return true;
 }
 
+void AudioService::OnPlaybackReached(std::function<void()> callback) {
+    std::unique_lock<std::mutex> lock(audio_queue_mutex_);
+    if (played_ms_ < queued_ms_) {
+        playback_markers_.emplace_back(queued_ms_, std::move(callback));
+        return;
+    }
+    lock.unlock();
+    callback();
+}
+
+// Called with audio_queue_mutex_ held, the callbacks must be run after it is released
+std::vector<std::function<void()>> AudioService::TakeReachedPlaybackMarkers() {
+    std::vector<std::function<void()>> reached;
+    while (!playback_markers_.empty() && playback_markers_.front().first <= played_ms_) {
+        reached.push_back(std::move(playback_markers_.front().second));
+        playback_markers_.pop_front();
+    }
+    return reached;
+}
+
 std::unique_ptr<AudioStreamPacket> AudioService::PopPacketFromSendQueue() {
     std::lock_guard<std::mutex> lock(audio_queue_mutex_);
     if (audio_send_queue_.empty()) {
@@ -619,6 +659,9 @@ void AudioService::EnableAudioTesting(bool enable) {
         xEventGroupClearBits(event_group_, AS_EVENT_AUDIO_TESTING_RUNNING);
         /* Copy audio_testing_queue_ to audio_decode_queue_ */
         std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+        for (auto& packet : audio_testing_queue_) {
+            queued_ms_ += packet->frame_duration;
+        }
         audio_decode_queue_ = std::move(audio_testing_queue_);
         audio_queue_cv_.notify_all();
     }
@@ -664,7 +707,7 @@ void AudioService::WaitForPlaybackQueueEmpty() {
 }
 
 void AudioService::ResetDecoder() {
-    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    std::unique_lock<std::mutex> lock(audio_queue_mutex_);
     std::unique_lock<std::mutex> decoder_lock(decoder_mutex_);
     if (opus_decoder_ != nullptr) {
         esp_opus_dec_reset(opus_decoder_);
@@ -675,6 +718,14 @@ void AudioService::ResetDecoder() {
     audio_playback_queue_.clear();
     audio_testing_queue_.clear();
     audio_queue_cv_.notify_all();
+
+    /* The dropped audio will never be played, release everything waiting for it */
+    played_ms_ = queued_ms_;
+    auto reached = TakeReachedPlaybackMarkers();
+    lock.unlock();
+    for (auto& callback : reached) {
+        callback();
+    }
 }
 
 void AudioService::CheckAndUpdateAudioPowerState() {
@@ -6,6 +6,9 @@
 #include <condition_variable>
 #include <chrono>
 #include <mutex>
+#include <atomic>
+#include <functional>
+#include <vector>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -93,6 +96,7 @@ struct AudioTask {
     AudioTaskType type;
     std::vector<int16_t> pcm;
     uint32_t timestamp;
+    uint32_t duration_ms = 0;
 };
 
 struct DebugStatistics {
@@ -132,6 +136,11 @@ public:
     void PlaySound(const std::string_view& sound);
     bool ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples);
     void ResetDecoder();
+    // Record a trace event when the next decoded frame reaches the codec
+    void TraceNextPlayback() { trace_next_playback_ = true; }
+    // Call back (from the audio output task) once the audio queued so far has been played,
+    // or right away if nothing is pending. Pending callbacks are flushed by ResetDecoder().
+    void OnPlaybackReached(std::function<void()> callback);
     void SetModelsList(srmodel_list_t* models_list);
 
 private:
@@ -175,12 +184,17 @@ private:
     std::deque<std::unique_ptr<AudioTask>> audio_playback_queue_;
     // For server AEC
     std::deque<uint32_t> timestamp_queue_;
+    // Stream position in milliseconds of the audio pushed to the decode queue and of the audio played
+    uint64_t queued_ms_ = 0;
+    uint64_t played_ms_ = 0;
+    std::deque<std::pair<uint64_t, std::function<void()>>> playback_markers_;
 
     bool wake_word_initialized_ = false;
     bool audio_processor_initialized_ = false;
     bool voice_detected_ = false;
     bool service_stopped_ = true;
     bool audio_input_need_warmup_ = false;
+    std::atomic<bool> trace_next_playback_{false};
 
     esp_timer_handle_t audio_power_timer_ = nullptr;
     std::chrono::steady_clock::time_point last_input_time_;
@@ -191,6 +205,7 @@ private:
     void OpusCodecTask();
     void PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm);
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
+    std::vector<std::function<void()>> TakeReachedPlaybackMarkers();
     void CheckAndUpdateAudioPowerState();
 };
 
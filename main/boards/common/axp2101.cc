@@ -3,6 +3,7 @@
 #include "display.h"
 
 #include <esp_log.h>
+#include "settings.h"
 
 #define TAG "Axp2101"
 
@@ -35,6 +36,7 @@ float Axp2101::GetTemperature() {
 }
 
 void Axp2101::PowerOff() {
+    Settings::Flush();
     uint8_t value = ReadReg(0x10);
     value = value | 0x01;
     WriteReg(0x10, value);
@@ -1,4 +1,6 @@
 #include "backlight.h"
+#include "board.h"
+#include "display.h"
 #include "settings.h"
 
 #include <esp_log.h>
@@ -73,9 +75,18 @@ void Backlight::OnTransitionTimer() {
         return;
     }
 
+    bool was_off = brightness_ == 0;
     brightness_ += step_;
     SetBrightnessImpl(brightness_);
 
+    // Let the display stop rendering while nothing can be seen
+    if (was_off != (brightness_ == 0)) {
+        auto display = Board::GetInstance().GetDisplay();
+        if (display != nullptr) {
+            display->SetScreenOn(brightness_ != 0);
+        }
+    }
+
     if (brightness_ == target_brightness_) {
         esp_timer_stop(transition_timer_);
     }
@@ -2,6 +2,34 @@
 #define CAMERA_H
 
 #include <string>
+#include <memory>
+#include <functional>
+
+#include "sdkconfig.h"
+#include "protocol.h"
+
+#ifdef CONFIG_XIAOZHI_CAMERA_EXPLAIN_MAX_SIZE
+#define CAMERA_EXPLAIN_MAX_SIZE CONFIG_XIAOZHI_CAMERA_EXPLAIN_MAX_SIZE
+#else
+#define CAMERA_EXPLAIN_MAX_SIZE 0
+#endif
+
+struct CameraStreamConfig {
+    int fps = 2;            // Target frame rate
+    int quality = 60;       // Initial and maximum JPEG quality
+    int bitrate_kbps = 0;   // Target bitrate, 0 keeps the quality fixed
+    int max_pending = 2;    // Frames waiting to be sent before new captures are dropped
+};
+
+struct CameraExplainOptions {
+    int quality = 80;       // JPEG quality of the uploaded image
+    int max_size = CAMERA_EXPLAIN_MAX_SIZE;  // Long edge of the uploaded image in pixels, 0 keeps the frame size
+    // Region of interest in percent of the frame, the whole frame by default
+    int roi_x = 0;
+    int roi_y = 0;
+    int roi_width = 100;
+    int roi_height = 100;
+};
 
 class Camera {
 public:
@@ -10,7 +38,14 @@ public:
     virtual bool SetHMirror(bool enabled) = 0;
     virtual bool SetVFlip(bool enabled) = 0;
     virtual bool SetSwapBytes(bool enabled) { return false; }  // Optional, default no-op
-    virtual std::string Explain(const std::string& question) = 0;
+    virtual std::string Explain(const std::string& question, const CameraExplainOptions& options) = 0;
+
+    // Continuous JPEG streaming, optional. on_frame_ready is called from the streaming thread
+    // whenever a frame is queued, the frames are then taken with PopStreamFrame().
+    virtual bool StartStreaming(const CameraStreamConfig& config, std::function<void()> on_frame_ready) { return false; }
+    virtual void StopStreaming() {}
+    virtual bool IsStreaming() const { return false; }
+    virtual std::unique_ptr<VideoStreamPacket> PopStreamFrame() { return nullptr; }
 };
 
 #endif // CAMERA_H
@@ -0,0 +1,188 @@
+#include "camera_frame.h"
+
+#include <algorithm>
+
+#include <esp_log.h>
+
+#include "jpg/image_kernels.h"
+
+#ifdef CONFIG_SOC_PPA_SUPPORTED
+#include "driver/ppa.h"
+#endif
+
+#define TAG "CameraFrame"
+
+#ifdef CONFIG_SOC_PPA_SUPPORTED
+// Crop and scale with the PPA. The PPA scale factor has 1/16 precision, so the output may come
+// out slightly smaller than requested; the returned frame carries the real size.
+static std::shared_ptr<CameraFrame> ResampleWithPpa(const CameraFrame& src, uint16_t x, uint16_t y, uint16_t width,
+                                                    uint16_t height, uint16_t dst_width) {
+    ppa_srm_color_mode_t color_mode;
+    int bpp;
+    switch (src.format()) {
+        case V4L2_PIX_FMT_RGB565:
+            color_mode = PPA_SRM_COLOR_MODE_RGB565;
+            bpp = 2;
+            break;
+        case V4L2_PIX_FMT_RGB24:
+            color_mode = PPA_SRM_COLOR_MODE_RGB888;
+            bpp = 3;
+            break;
+        default:
+            return nullptr;
+    }
+
+    uint32_t scale16 = std::max<uint32_t>(1, (uint32_t)dst_width * 16 / width);
+    uint16_t out_width = (width * scale16 / 16) & ~1;
+    uint16_t out_height = (height * scale16 / 16) & ~1;
+    if (out_width == 0 || out_height == 0) {
+        return nullptr;
+    }
+    size_t out_len = (size_t)out_width * out_height * bpp;
+    uint8_t* out = (uint8_t*)heap_caps_malloc(out_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT | MALLOC_CAP_CACHE_ALIGNED);
+    if (out == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for scaled frame", out_len);
+        return nullptr;
+    }
+
+    ppa_client_handle_t ppa_client = nullptr;
+    ppa_client_config_t client_cfg = {
+        .oper_type = PPA_OPERATION_SRM,
+        .max_pending_trans_num = 1,
+    };
+    esp_err_t err = ppa_register_client(&client_cfg, &ppa_client);
+    if (err != ESP_OK || ppa_client == nullptr) {
+        ESP_LOGE(TAG, "ppa_register_client failed: %d", (int)err);
+        heap_caps_free(out);
+        return nullptr;
+    }
+
+    ppa_srm_oper_config_t srm_cfg = {};
+    srm_cfg.in.buffer = src.data();
+    srm_cfg.in.pic_w = src.width();
+    srm_cfg.in.pic_h = src.height();
+    srm_cfg.in.block_w = width;
+    srm_cfg.in.block_h = height;
+    srm_cfg.in.block_offset_x = x;
+    srm_cfg.in.block_offset_y = y;
+    srm_cfg.in.srm_cm = color_mode;
+
+    srm_cfg.out.buffer = out;
+    srm_cfg.out.buffer_size = out_len;
+    srm_cfg.out.pic_w = out_width;
+    srm_cfg.out.pic_h = out_height;
+    srm_cfg.out.block_offset_x = 0;
+    srm_cfg.out.block_offset_y = 0;
+    srm_cfg.out.srm_cm = color_mode;
+
+    srm_cfg.scale_x = scale16 / 16.0f;
+    srm_cfg.scale_y = scale16 / 16.0f;
+    srm_cfg.rotation_angle = PPA_SRM_ROTATION_ANGLE_0;
+    srm_cfg.mode = PPA_TRANS_MODE_BLOCKING;
+
+    err = ppa_do_scale_rotate_mirror(ppa_client, &srm_cfg);
+    (void)ppa_unregister_client(ppa_client);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ppa_do_scale_rotate_mirror failed: %d", (int)err);
+        heap_caps_free(out);
+        return nullptr;
+    }
+    return CameraFrame::FromHeap(out, out_len, out_width, out_height, src.format());
+}
+#endif  // CONFIG_SOC_PPA_SUPPORTED
+
+std::shared_ptr<CameraFrame> CameraFrame::Resample(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                                                   uint16_t dst_width, uint16_t dst_height) const {
+    if (width == 0 || height == 0 || dst_width == 0 || dst_height == 0 ||
+        x + width > width_ || y + height > height_) {
+        return nullptr;
+    }
+
+#ifdef CONFIG_SOC_PPA_SUPPORTED
+    if (dst_width < width) {
+        auto frame = ResampleWithPpa(*this, x, y, width, height, dst_width);
+        if (frame != nullptr) {
+            return frame;
+        }
+    }
+#endif
+
+    int bpp;
+    switch (format_) {
+        case V4L2_PIX_FMT_GREY:
+            bpp = 1;
+            break;
+        case V4L2_PIX_FMT_RGB565:
+        case V4L2_PIX_FMT_YUYV:
+            bpp = 2;
+            break;
+        case V4L2_PIX_FMT_RGB24:
+            bpp = 3;
+            break;
+        default:
+            return nullptr;
+    }
+
+    size_t src_stride = (size_t)width_ * bpp;
+    size_t dst_stride = (size_t)dst_width * bpp;
+    size_t out_len = dst_stride * dst_height;
+    uint8_t* out = (uint8_t*)heap_caps_malloc(out_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (out == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for scaled frame", out_len);
+        return nullptr;
+    }
+
+    const uint8_t* src = data_ + y * src_stride + x * bpp;
+    if (format_ == V4L2_PIX_FMT_YUYV) {
+        // Chroma is shared by pixel pairs, sample whole Y0 U Y1 V groups
+        image_scale_nearest(out, dst_width / 2, dst_height, dst_stride, src, width / 2, height, src_stride, 4);
+    } else if (dst_width == width && dst_height == height) {
+        // Plain crop, rows are copied as they are
+        image_scale_nearest(out, dst_width, dst_height, dst_stride, src, width, height, src_stride, bpp);
+    } else if (!image_scale_bilinear(out, dst_width, dst_height, dst_stride, src, width, height, src_stride, format_)) {
+        heap_caps_free(out);
+        return nullptr;
+    }
+    return FromHeap(out, out_len, dst_width, dst_height, format_);
+}
+
+std::shared_ptr<CameraFrame> PrepareExplainFrame(const std::shared_ptr<CameraFrame>& frame,
+                                                 const CameraExplainOptions& options) {
+    if (frame->format() == V4L2_PIX_FMT_JPEG || frame->format() == V4L2_PIX_FMT_YUV420) {
+        return frame;
+    }
+
+    // Region of interest, kept even so YUYV pixel pairs stay intact
+    int roi_x = std::clamp(options.roi_x, 0, 99);
+    int roi_y = std::clamp(options.roi_y, 0, 99);
+    int roi_width = std::clamp(options.roi_width, 1, 100 - roi_x);
+    int roi_height = std::clamp(options.roi_height, 1, 100 - roi_y);
+    uint16_t x = (frame->width() * roi_x / 100) & ~1;
+    uint16_t y = frame->height() * roi_y / 100;
+    uint16_t width = std::max(2, (frame->width() * roi_width / 100) & ~1);
+    uint16_t height = std::max(1, frame->height() * roi_height / 100);
+    width = std::min<uint16_t>(width, frame->width() - x);
+    height = std::min<uint16_t>(height, frame->height() - y);
+
+    uint16_t dst_width = width;
+    uint16_t dst_height = height;
+    int long_edge = std::max(width, height);
+    if (options.max_size > 0 && long_edge > options.max_size) {
+        dst_width = std::max(2, (width * options.max_size / long_edge) & ~1);
+        dst_height = std::max(1, height * options.max_size / long_edge);
+    }
+
+    if (x == 0 && y == 0 && width == frame->width() && height == frame->height() &&
+        dst_width == width && dst_height == height) {
+        return frame;
+    }
+
+    auto resampled = frame->Resample(x, y, width, height, dst_width, dst_height);
+    if (resampled == nullptr) {
+        ESP_LOGW(TAG, "Failed to resample frame, uploading it unchanged");
+        return frame;
+    }
+    ESP_LOGI(TAG, "Explain frame %dx%d -> roi %dx%d+%d+%d -> %dx%d", frame->width(), frame->height(), width, height, x,
+             y, resampled->width(), resampled->height());
+    return resampled;
+}
@@ -0,0 +1,86 @@
+#ifndef CAMERA_FRAME_H
+#define CAMERA_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#include <esp_cache.h>
+#include <esp_heap_caps.h>
+
+#include "camera.h"
+#include "jpg/image_to_jpeg.h"
+
+// A captured frame shared by the preview image, the JPEG encoder thread and the explain upload.
+// The pixels normally stay in the driver's buffer (camera_fb_t or a V4L2 mmap buffer); the release
+// callback hands that buffer back to the driver when the last reference goes away.
+class CameraFrame {
+public:
+    using ReleaseCallback = std::function<void()>;
+
+    CameraFrame(uint8_t* data, size_t len, uint16_t width, uint16_t height, v4l2_pix_fmt_t format,
+                ReleaseCallback release)
+        : data_(data), len_(len), width_(width), height_(height), format_(format), release_(std::move(release)) {}
+
+    ~CameraFrame() {
+        if (dirty_) {
+            // Pixels were converted in place by the CPU; write the cache back so that stale lines
+            // evicted later cannot overwrite the next frame the DMA puts into this buffer.
+            esp_cache_msync(data_, len_, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+        }
+        if (release_) {
+            release_();
+        }
+    }
+
+    CameraFrame(const CameraFrame&) = delete;
+    CameraFrame& operator=(const CameraFrame&) = delete;
+
+    // Wrap a buffer allocated with heap_caps_malloc, freed together with the frame
+    static std::shared_ptr<CameraFrame> FromHeap(uint8_t* data, size_t len, uint16_t width, uint16_t height,
+                                                 v4l2_pix_fmt_t format) {
+        return std::make_shared<CameraFrame>(data, len, width, height, format, [data]() { heap_caps_free(data); });
+    }
+
+    // Heap copy that no longer references the driver buffer, nullptr if out of memory
+    std::shared_ptr<CameraFrame> Clone() const {
+        uint8_t* data = (uint8_t*)heap_caps_malloc(len_, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (data == nullptr) {
+            return nullptr;
+        }
+        memcpy(data, data_, len_);
+        return FromHeap(data, len_, width_, height_, format_);
+    }
+
+    // Crop to (x, y, width, height) and scale to dst_width x dst_height into a new heap frame.
+    // Uses the PPA where available, the result may then be slightly smaller than requested.
+    std::shared_ptr<CameraFrame> Resample(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                                          uint16_t dst_width, uint16_t dst_height) const;
+
+    uint8_t* data() const { return data_; }
+    size_t len() const { return len_; }
+    uint16_t width() const { return width_; }
+    uint16_t height() const { return height_; }
+    v4l2_pix_fmt_t format() const { return format_; }
+
+    // Call after modifying a driver-owned buffer in place (e.g. byte swapping)
+    void MarkDirty() { dirty_ = true; }
+    void SetFormat(v4l2_pix_fmt_t format) { format_ = format; }
+
+private:
+    uint8_t* data_;
+    size_t len_;
+    uint16_t width_;
+    uint16_t height_;
+    v4l2_pix_fmt_t format_;
+    ReleaseCallback release_;
+    bool dirty_ = false;
+};
+
+// Apply the region of interest and size limit of an explain request, returns frame itself if nothing changes
+std::shared_ptr<CameraFrame> PrepareExplainFrame(const std::shared_ptr<CameraFrame>& frame,
+                                                 const CameraExplainOptions& options);
+
+#endif // CAMERA_FRAME_H
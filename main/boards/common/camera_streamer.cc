@@ -0,0 +1,164 @@
+#include "camera_streamer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "jpg/image_to_jpeg.h"
+
+#define TAG "CameraStreamer"
+
+#define STREAM_MIN_QUALITY 10
+#define STREAM_QUALITY_STEP 5
+#define STREAM_RATE_WINDOW_US 1000000
+
+CameraStreamer::CameraStreamer(const CameraStreamConfig& config, GrabCallback grab, std::function<void()> on_frame_ready)
+    : config_(config), grab_(grab), on_frame_ready_(on_frame_ready) {
+    config_.fps = std::clamp(config_.fps, 1, 30);
+    config_.quality = std::clamp(config_.quality, STREAM_MIN_QUALITY, 100);
+    config_.max_pending = std::max(config_.max_pending, 1);
+    quality_ = config_.quality;
+
+    ESP_LOGI(TAG, "Start streaming: fps=%d, quality=%d, bitrate=%dkbps, max_pending=%d",
+             config_.fps, config_.quality, config_.bitrate_kbps, config_.max_pending);
+    thread_ = std::thread([this]() { StreamLoop(); });
+}
+
+CameraStreamer::~CameraStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    condition_variable_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ESP_LOGI(TAG, "Stop streaming");
+}
+
+std::unique_ptr<VideoStreamPacket> CameraStreamer::PopFrame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (send_queue_.empty()) {
+        return nullptr;
+    }
+    auto packet = std::move(send_queue_.front());
+    send_queue_.pop_front();
+    return packet;
+}
+
+void CameraStreamer::StreamLoop() {
+    const int64_t interval = 1000000 / config_.fps;
+    int64_t next_time = esp_timer_get_time();
+    window_start_time_ = next_time;
+
+    while (true) {
+        size_t pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            int64_t delay = next_time - esp_timer_get_time();
+            if (delay > 0) {
+                condition_variable_.wait_for(lock, std::chrono::microseconds(delay), [this]() { return !running_; });
+            }
+            if (!running_) {
+                break;
+            }
+            pending = send_queue_.size();
+        }
+        // Keep the cadence, but never try to catch up with a burst after a slow frame
+        next_time = std::max(next_time + interval, esp_timer_get_time());
+
+        if (pending >= (size_t)config_.max_pending) {
+            UpdateRateControl(0, true);
+            continue;
+        }
+
+        auto frame = grab_();
+        if (frame == nullptr) {
+            continue;
+        }
+        int64_t capture_time = esp_timer_get_time();
+
+        auto packet = std::make_unique<VideoStreamPacket>();
+        packet->timestamp = capture_time / 1000;
+        packet->width = frame->width();
+        packet->height = frame->height();
+        bool ok = Encode(*frame, *packet);
+        // Hand the buffer back to the driver before the packet waits in the queue
+        frame.reset();
+        if (!ok) {
+            continue;
+        }
+
+        UpdateRateControl(packet->payload.size(), false);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            send_queue_.push_back(std::move(packet));
+        }
+        if (on_frame_ready_) {
+            on_frame_ready_();
+        }
+    }
+}
+
+bool CameraStreamer::Encode(const CameraFrame& frame, VideoStreamPacket& packet) {
+    if (frame.format() == V4L2_PIX_FMT_JPEG) {
+        packet.payload.assign(frame.data(), frame.data() + frame.len());
+        return true;
+    }
+
+    packet.payload.reserve(frame.len() / 8);
+    bool ok = image_to_jpeg_cb(frame.data(), frame.len(), frame.width(), frame.height(), frame.format(), quality_,
+        [](void* arg, size_t index, const void* data, size_t len) -> size_t {
+            auto payload = static_cast<std::vector<uint8_t>*>(arg);
+            if (index == 0 && data != nullptr && len > 0) {
+                auto bytes = static_cast<const uint8_t*>(data);
+                payload->insert(payload->end(), bytes, bytes + len);
+            }
+            return len;
+        }, &packet.payload);
+    if (!ok || packet.payload.empty()) {
+        ESP_LOGE(TAG, "Failed to encode frame %dx%d", frame.width(), frame.height());
+        return false;
+    }
+    return true;
+}
+
+void CameraStreamer::UpdateRateControl(size_t frame_bytes, bool dropped) {
+    window_bytes_ += frame_bytes;
+    if (dropped) {
+        window_dropped_++;
+    } else {
+        window_frames_++;
+    }
+
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - window_start_time_;
+    if (elapsed < STREAM_RATE_WINDOW_US) {
+        return;
+    }
+
+    int kbps = (int)(window_bytes_ * 8 * 1000 / elapsed);
+    int quality = quality_;
+    if (window_dropped_ > 0) {
+        // The consumer can't keep up, smaller frames help more than fewer frames
+        quality -= STREAM_QUALITY_STEP;
+    } else if (config_.bitrate_kbps > 0) {
+        if (kbps > config_.bitrate_kbps) {
+            quality -= STREAM_QUALITY_STEP;
+        } else if (kbps < config_.bitrate_kbps * 3 / 4) {
+            quality += STREAM_QUALITY_STEP;
+        }
+    } else {
+        quality += STREAM_QUALITY_STEP;
+    }
+    quality_ = std::clamp(quality, STREAM_MIN_QUALITY, config_.quality);
+
+    ESP_LOGD(TAG, "Stream: %lu frames, %lu dropped, %d kbps, quality %d",
+             window_frames_, window_dropped_, kbps, quality_);
+    window_start_time_ = now;
+    window_bytes_ = 0;
+    window_frames_ = 0;
+    window_dropped_ = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef CAMERA_STREAMER_H
+#define CAMERA_STREAMER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "camera.h"
+#include "camera_frame.h"
+
+// Grabs frames at a fixed rate, encodes them to JPEG and keeps them in a short send queue.
+// When the consumer falls behind the queue fills up and new captures are skipped, so the
+// stream degrades to a lower frame rate instead of growing latency.
+class CameraStreamer {
+public:
+    using GrabCallback = std::function<std::shared_ptr<CameraFrame>()>;
+
+    CameraStreamer(const CameraStreamConfig& config, GrabCallback grab, std::function<void()> on_frame_ready);
+    ~CameraStreamer();
+
+    std::unique_ptr<VideoStreamPacket> PopFrame();
+
+private:
+    CameraStreamConfig config_;
+    GrabCallback grab_;
+    std::function<void()> on_frame_ready_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    bool running_ = true;
+    std::deque<std::unique_ptr<VideoStreamPacket>> send_queue_;
+
+    int quality_;
+    int64_t window_start_time_ = 0;
+    size_t window_bytes_ = 0;
+    uint32_t window_frames_ = 0;
+    uint32_t window_dropped_ = 0;
+
+    void StreamLoop();
+    bool Encode(const CameraFrame& frame, VideoStreamPacket& packet);
+    void UpdateRateControl(size_t frame_bytes, bool dropped);
+};
+
+#endif // CAMERA_STREAMER_H
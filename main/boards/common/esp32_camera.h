@@ -2,22 +2,18 @@
 #include "sdkconfig.h"
 
 #include <lvgl.h>
-#include <thread>
 #include <memory>
+#include <mutex>
 #include <vector>
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
-
 #include "camera.h"
+#include "camera_frame.h"
+#include "camera_streamer.h"
+#include "explain_cache.h"
+#include "explain_uploader.h"
 #include "esp_camera.h"
 #include "jpg/image_to_jpeg.h"
-
-struct JpegChunk
-{
-    uint8_t *data;
-    size_t len;
-};
+#include "lvgl_image.h"
 
 class Esp32Camera : public Camera
 {
@@ -26,10 +22,24 @@ private:
     bool swap_bytes_enabled_ = true;  // Swap pixel byte order for RGB565, enabled by default
     std::string explain_url_;
     std::string explain_token_;
-    std::thread encoder_thread_;
-    camera_fb_t *current_fb_ = nullptr;
-    uint8_t *encode_buf_ = nullptr;  // Buffer for JPEG encoding (with optional byte swap)
-    size_t encode_buf_size_ = 0;
+    std::shared_ptr<CameraFrame> frame_;  // Wraps the driver's camera_fb_t, shared with preview and encoder
+    // Decoded preview of JPEG frames, the buffer is kept and reused by the next capture
+    std::shared_ptr<CameraFrame> preview_frame_;
+    uint8_t *preview_buffer_ = nullptr;
+    size_t preview_buffer_size_ = 0;
+    std::unique_ptr<CameraStreamer> streamer_;
+    ExplainCache explain_cache_;
+    ExplainUploader explain_uploader_;
+    std::mutex grab_mutex_;
+    // Guards frame_, the preview, streamer_ and explain_cache_, the MCP tools run on worker tasks
+    // while the stream is stopped from the main task
+    mutable std::mutex camera_mutex_;
+    // One upload at a time, held without camera_mutex_ so that the stream can be stopped meanwhile
+    std::mutex explain_mutex_;
+
+    std::shared_ptr<CameraFrame> GrabFrame(int skip_frames);
+    void ReleasePreview();
+    std::unique_ptr<LvglImage> DecodeJpegPreview(int display_width);
 
 public:
     Esp32Camera(const camera_config_t &config);
@@ -40,5 +50,12 @@ public:
     virtual bool SetHMirror(bool enabled) override;
     virtual bool SetVFlip(bool enabled) override;
     virtual bool SetSwapBytes(bool enabled) override;
-    virtual std::string Explain(const std::string &question) override;
+    virtual std::string Explain(const std::string &question, const CameraExplainOptions &options) override;
+    virtual bool StartStreaming(const CameraStreamConfig &config, std::function<void()> on_frame_ready) override;
+    virtual void StopStreaming() override;
+    virtual bool IsStreaming() const override {
+        std::lock_guard<std::mutex> lock(camera_mutex_);
+        return streamer_ != nullptr;
+    }
+    virtual std::unique_ptr<VideoStreamPacket> PopStreamFrame() override;
 };
@@ -7,10 +7,11 @@
 #include <unistd.h>
 #include <errno.h>
 #include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <cstdio>
 #include <cstring>
 
-#include "esp_imgfx_color_convert.h"
 #include "esp_video_device.h"
 #include "esp_video_init.h"
 #include "linux/videodev2.h"
@@ -19,6 +20,7 @@
 #include "display.h"
 #include "esp_video.h"
 #include "esp_jpeg_common.h"
+#include "jpg/image_kernels.h"
 #include "jpg/image_to_jpeg.h"
 #include "jpg/jpeg_to_image.h"
 #include "lvgl_display.h"
@@ -42,7 +44,6 @@
 #error "CONFIG_XIAOZHI_CAMERA_IMAGE_ROTATION_ANGLE is not set"
 #endif  // angle
 #else   // target
-#include "esp_imgfx_rotate.h"
 #if defined(CONFIG_XIAOZHI_CAMERA_IMAGE_ROTATION_ANGLE_90)
 #define IMAGE_ROTATION_ANGLE (90)
 #elif defined(CONFIG_XIAOZHI_CAMERA_IMAGE_ROTATION_ANGLE_270)
@@ -267,11 +268,11 @@ EspVideo::EspVideo(const esp_video_init_config_t& config) {
     }
 
 #ifdef CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
-    frame_.width = setformat.fmt.pix.height;
-    frame_.height = setformat.fmt.pix.width;
+    frame_width_ = setformat.fmt.pix.height;
+    frame_height_ = setformat.fmt.pix.width;
 #else
-    frame_.width = setformat.fmt.pix.width;
-    frame_.height = setformat.fmt.pix.height;
+    frame_width_ = setformat.fmt.pix.width;
+    frame_height_ = setformat.fmt.pix.height;
 #endif
 
     // 申请缓冲并mmap
@@ -363,6 +364,8 @@ EspVideo::EspVideo(const esp_video_init_config_t& config) {
 }
 
 EspVideo::~EspVideo() {
+    streamer_.reset();
+    frame_.reset();
     if (streaming_on_ && video_fd_ >= 0) {
         int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
         ioctl(video_fd_, VIDIOC_STREAMOFF, &type);
@@ -385,421 +388,282 @@ void EspVideo::SetExplainUrl(const std::string& url, const std::string& token) {
     explain_token_ = token;
 }
 
-bool EspVideo::Capture() {
-    if (encoder_thread_.joinable()) {
-        encoder_thread_.join();
+#ifdef CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
+/**
+ * @brief 旋转一帧图像，结果写入新分配的 PSRAM 缓冲区
+ *
+ * 旋转完成后调用方释放 src，驱动缓冲区随即归还给驱动。
+ *
+ * @param src 传感器原始方向的帧 (sensor_width_ x sensor_height_)
+ * @return 旋转后的帧 (frame_width_ x frame_height_)，失败返回 nullptr
+ */
+std::shared_ptr<CameraFrame> EspVideo::RotateFrame(const std::shared_ptr<CameraFrame>& src) {
+#ifndef CONFIG_SOC_PPA_SUPPORTED
+    uint8_t* rotate_dst = (uint8_t*)heap_caps_aligned_alloc(64, src->len(), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (rotate_dst == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate memory for rotate image");
+        return nullptr;
     }
 
-    if (!streaming_on_ || video_fd_ < 0) {
-        return false;
+    // YUYV 按 2 字节像素旋转，与 RGB565 相同
+    v4l2_pix_fmt_t rotate_fmt = src->format() == V4L2_PIX_FMT_YUYV ? V4L2_PIX_FMT_RGB565 : src->format();
+    if (!image_rotate(rotate_dst, src->data(), src->len(), sensor_width_, sensor_height_, rotate_fmt,
+                      IMAGE_ROTATION_ANGLE)) {
+        heap_caps_free(rotate_dst);
+        return nullptr;
+    }
+    return CameraFrame::FromHeap(rotate_dst, src->len(), frame_width_, frame_height_, src->format());
+#else   // CONFIG_SOC_PPA_SUPPORTED
+    const uint8_t* rotate_src = src->data();
+    uint8_t* converted = nullptr;
+    size_t rotate_len = (size_t)frame_width_ * frame_height_ * 2;
+
+    ppa_srm_color_mode_t ppa_color_mode;
+    switch (src->format()) {
+        case V4L2_PIX_FMT_RGB565:
+            ppa_color_mode = PPA_SRM_COLOR_MODE_RGB565;
+            break;
+        case V4L2_PIX_FMT_RGB24:
+            ppa_color_mode = PPA_SRM_COLOR_MODE_RGB888;
+            break;
+        case V4L2_PIX_FMT_YUYV: {
+            ESP_LOGW(TAG, "YUYV format is not supported for PPA rotation, using software conversion to RGB888");
+            size_t converted_len = (size_t)sensor_width_ * sensor_height_ * 3;
+            converted = (uint8_t*)heap_caps_malloc(converted_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (converted == nullptr) {
+                ESP_LOGE(TAG, "Failed to allocate memory for rotate image");
+                return nullptr;
+            }
+            if (!image_convert(converted, converted_len, V4L2_PIX_FMT_RGB24, src->data(), src->len(),
+                               V4L2_PIX_FMT_YUYV, sensor_width_, sensor_height_)) {
+                heap_caps_free(converted);
+                return nullptr;
+            }
+            rotate_src = converted;
+            ppa_color_mode = PPA_SRM_COLOR_MODE_RGB888;
+            break;
+        }
+        default:
+            ESP_LOGE(TAG, "unsupported sensor format for PPA rotation: 0x%08lx", sensor_format_);
+            return nullptr;
     }
 
-    for (int i = 0; i < 3; i++) {
-        struct v4l2_buffer buf = {};
+    uint8_t* rotate_dst = (uint8_t*)heap_caps_malloc(rotate_len,
+                                                     MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT | MALLOC_CAP_CACHE_ALIGNED);
+    if (rotate_dst == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate memory for rotate image");
+        heap_caps_free(converted);
+        return nullptr;
+    }
+
+    ppa_client_handle_t ppa_client = nullptr;
+    ppa_client_config_t client_cfg = {
+        .oper_type = PPA_OPERATION_SRM,
+        .max_pending_trans_num = 1,
+    };
+    esp_err_t err = ppa_register_client(&client_cfg, &ppa_client);
+    if (err != ESP_OK || ppa_client == nullptr) {
+        ESP_LOGE(TAG, "ppa_register_client failed: %d", (int)err);
+        heap_caps_free(rotate_dst);
+        heap_caps_free(converted);
+        return nullptr;
+    }
+
+    ppa_srm_rotation_angle_t ppa_angle = IMAGE_ROTATION_ANGLE;
+
+    ppa_srm_oper_config_t srm_cfg = {};
+    srm_cfg.in.buffer = (void*)rotate_src;
+    srm_cfg.in.pic_w = sensor_width_;
+    srm_cfg.in.pic_h = sensor_height_;
+    srm_cfg.in.block_w = sensor_width_;
+    srm_cfg.in.block_h = sensor_height_;
+    srm_cfg.in.block_offset_x = 0;
+    srm_cfg.in.block_offset_y = 0;
+    srm_cfg.in.srm_cm = ppa_color_mode;
+
+    srm_cfg.out.buffer = (void*)rotate_dst;
+    srm_cfg.out.buffer_size = rotate_len;
+    srm_cfg.out.pic_w = frame_width_;
+    srm_cfg.out.pic_h = frame_height_;
+    srm_cfg.out.block_offset_x = 0;
+    srm_cfg.out.block_offset_y = 0;
+    srm_cfg.out.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+
+    // 等比例缩放 1.0
+    srm_cfg.scale_x = 1.0f;
+    srm_cfg.scale_y = 1.0f;
+    srm_cfg.rotation_angle = ppa_angle;
+    srm_cfg.mode = PPA_TRANS_MODE_BLOCKING;
+    srm_cfg.user_data = nullptr;
+
+    err = ppa_do_scale_rotate_mirror(ppa_client, &srm_cfg);
+    (void)ppa_unregister_client(ppa_client);
+    heap_caps_free(converted);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ppa_do_scale_rotate_mirror failed: %d", (int)err);
+        heap_caps_free(rotate_dst);
+        return nullptr;
+    }
+    return CameraFrame::FromHeap(rotate_dst, rotate_len, frame_width_, frame_height_, V4L2_PIX_FMT_RGB565);
+#endif  // CONFIG_SOC_PPA_SUPPORTED
+}
+#endif  // CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
+
+/**
+ * @brief 从驱动取一帧，完成字节序交换与旋转
+ *
+ * 未旋转时帧直接引用驱动的 mmap 缓冲区。
+ *
+ * @param skip_frames 丢弃的旧帧数量
+ * @return 取到的帧，失败返回 nullptr
+ */
+std::shared_ptr<CameraFrame> EspVideo::GrabFrame(int skip_frames) {
+    std::lock_guard<std::mutex> lock(grab_mutex_);
+
+    // 丢弃旧帧，保留最新的一帧
+    struct v4l2_buffer buf = {};
+    for (int i = 0; i <= skip_frames; i++) {
+        if (i > 0 && ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
+            ESP_LOGE(TAG, "VIDIOC_QBUF failed");
+        }
+        buf = {};
         buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
         buf.memory = V4L2_MEMORY_MMAP;
         if (ioctl(video_fd_, VIDIOC_DQBUF, &buf) != 0) {
             ESP_LOGE(TAG, "VIDIOC_DQBUF failed");
-            return false;
+            return nullptr;
         }
-        if (i == 2) {
-            // 保存帧副本到PSRAM
-            if (frame_.data) {
-                heap_caps_free(frame_.data);
-                frame_.data = nullptr;
-                frame_.format = 0;
-            }
-            frame_.len = buf.bytesused;
-            frame_.data = (uint8_t*)heap_caps_malloc(frame_.len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-            if (!frame_.data) {
-                ESP_LOGE(TAG, "alloc frame copy failed: need allocate %lu bytes", buf.bytesused);
-                if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                    ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                }
-                return false;
-            }
+    }
 
 #ifdef CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
-            ESP_LOGW(TAG, "mmap_buffers_[buf.index].length = %d, sensor_width = %d, sensor_height = %d",
-                     mmap_buffers_[buf.index].length, sensor_width_, sensor_height_);
+    ESP_LOGD(TAG, "mmap_buffers_[buf.index].length = %d, sensor_width = %d, sensor_height = %d",
+             mmap_buffers_[buf.index].length, sensor_width_, sensor_height_);
+    uint16_t raw_width = sensor_width_;
+    uint16_t raw_height = sensor_height_;
 #else
-            ESP_LOGW(TAG, "mmap_buffers_[buf.index].length = %d, frame.width = %d, frame.height = %d",
-                     mmap_buffers_[buf.index].length, frame_.width, frame_.height);
+    ESP_LOGD(TAG, "mmap_buffers_[buf.index].length = %d, frame.width = %d, frame.height = %d",
+             mmap_buffers_[buf.index].length, frame_width_, frame_height_);
+    uint16_t raw_width = frame_width_;
+    uint16_t raw_height = frame_height_;
 #endif  // CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
-            ESP_LOG_BUFFER_HEXDUMP(TAG, mmap_buffers_[buf.index].start, MIN(mmap_buffers_[buf.index].length, 256),
-                                   ESP_LOG_DEBUG);
-
-            switch (sensor_format_) {
-                case V4L2_PIX_FMT_RGB565:
-                case V4L2_PIX_FMT_RGB24:
-                case V4L2_PIX_FMT_YUYV:
-                case V4L2_PIX_FMT_YUV420:
-                case V4L2_PIX_FMT_GREY:
+    ESP_LOG_BUFFER_HEXDUMP(TAG, mmap_buffers_[buf.index].start, MIN(mmap_buffers_[buf.index].length, 256),
+                           ESP_LOG_DEBUG);
+
+    uint8_t* data = (uint8_t*)mmap_buffers_[buf.index].start;
+    size_t len = MIN(mmap_buffers_[buf.index].length, buf.bytesused);
+    v4l2_pix_fmt_t format;
+    bool swap_bytes = false;
+    switch (sensor_format_) {
+        case V4L2_PIX_FMT_RGB565:
+        case V4L2_PIX_FMT_RGB24:
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_YUV420:
+        case V4L2_PIX_FMT_GREY:
 #ifdef CONFIG_XIAOZHI_CAMERA_ALLOW_JPEG_INPUT
-                case V4L2_PIX_FMT_JPEG:
+        case V4L2_PIX_FMT_JPEG:
 #endif  // CONFIG_XIAOZHI_CAMERA_ALLOW_JPEG_INPUT
+            format = sensor_format_;
 #ifdef CONFIG_XIAOZHI_ENABLE_CAMERA_ENDIANNESS_SWAP
-                {
-                    auto src16 = (uint16_t*)mmap_buffers_[buf.index].start;
-                    auto dst16 = (uint16_t*)frame_.data;
-                    size_t count = (size_t)mmap_buffers_[buf.index].length / 2;
-                    for (size_t i = 0; i < count; i++) {
-                        dst16[i] = __builtin_bswap16(src16[i]);
-                    }
-                }
-#else
-                    memcpy(frame_.data, mmap_buffers_[buf.index].start,
-                           MIN(mmap_buffers_[buf.index].length, frame_.len));
+            swap_bytes = true;
 #endif  // CONFIG_XIAOZHI_ENABLE_CAMERA_ENDIANNESS_SWAP
-                    frame_.format = sensor_format_;
-                    break;
-                case V4L2_PIX_FMT_YUV422P: {
-                    // 这个格式是 422 YUYV，不是 planer
-                    frame_.format = V4L2_PIX_FMT_YUYV;
+            break;
+        case V4L2_PIX_FMT_YUV422P:
+            // 这个格式是 422 YUYV，不是 planer
+            format = V4L2_PIX_FMT_YUYV;
 #ifdef CONFIG_XIAOZHI_ENABLE_CAMERA_ENDIANNESS_SWAP
-                    {
-                        auto src16 = (uint16_t*)mmap_buffers_[buf.index].start;
-                        auto dst16 = (uint16_t*)frame_.data;
-                        size_t count = (size_t)mmap_buffers_[buf.index].length / 2;
-                        for (size_t i = 0; i < count; i++) {
-                            dst16[i] = __builtin_bswap16(src16[i]);
-                        }
-                    }
-#else
-                    memcpy(frame_.data, mmap_buffers_[buf.index].start,
-                           MIN(mmap_buffers_[buf.index].length, frame_.len));
+            swap_bytes = true;
 #endif  // CONFIG_XIAOZHI_ENABLE_CAMERA_ENDIANNESS_SWAP
-                    break;
-                }
-                case V4L2_PIX_FMT_RGB565X: {
-                    // 大端序的 RGB565 需要转换为小端序
-                    // 目前 esp_video 的大小端都会返回格式为 RGB565，不会返回格式为 RGB565X，此 case 用于未来版本兼容
-                    auto src16 = (uint16_t*)mmap_buffers_[buf.index].start;
-                    auto dst16 = (uint16_t*)frame_.data;
-                    size_t pixel_count = (size_t)frame_.width * (size_t)frame_.height;
-                    for (size_t i = 0; i < pixel_count; i++) {
-                        dst16[i] = __builtin_bswap16(src16[i]);
-                    }
-                    frame_.format = V4L2_PIX_FMT_RGB565;
-                    break;
-                }
-                default:
-                    ESP_LOGE(TAG, "unsupported sensor format: 0x%08lx", sensor_format_);
-                    if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                        ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                    }
-                    return false;
-            }
-
-#ifdef CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
-#ifndef CONFIG_SOC_PPA_SUPPORTED
-            uint8_t* rotate_dst =
-                (uint8_t*)heap_caps_aligned_alloc(64, frame_.len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-            if (rotate_dst == nullptr) {
-                ESP_LOGE(TAG, "Failed to allocate memory for rotate image");
-                if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                    ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                }
-                return false;
-            }
-            uint8_t* rotate_src = (uint8_t*)frame_.data;
-
-            esp_imgfx_rotate_cfg_t rotate_cfg = {
-                .in_res =
-                    {
-                        .width = static_cast<int16_t>(sensor_width_),
-                        .height = static_cast<int16_t>(sensor_height_),
-                    },
-                .degree = IMAGE_ROTATION_ANGLE,
-            };
-            switch (frame_.format) {
-                case V4L2_PIX_FMT_RGB565:
-                    rotate_cfg.in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB565_LE;
-                    break;
-                case V4L2_PIX_FMT_YUYV:
-                    rotate_cfg.in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB565_LE;
-                    break;
-                case V4L2_PIX_FMT_GREY:
-                    rotate_cfg.in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_Y;
-                    break;
-                case V4L2_PIX_FMT_RGB24:
-                    rotate_cfg.in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB888;
-                    break;
-                default:
-                    ESP_LOGE(TAG, "unsupported sensor format: 0x%08lx", sensor_format_);
-                    if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                        ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                    }
-                    return false;
-            }
-            esp_imgfx_rotate_handle_t rotate_handle = nullptr;
-            esp_imgfx_err_t imgfx_err = esp_imgfx_rotate_open(&rotate_cfg, &rotate_handle);
-            if (imgfx_err != ESP_IMGFX_ERR_OK || rotate_handle == nullptr) {
-                ESP_LOGE(TAG, "esp_imgfx_rotate_create failed");
-                if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                    ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                }
-                return false;
-            }
-
-            esp_imgfx_data_t rotate_input_data = {
-                .data = rotate_src,
-                .data_len = frame_.len,
-            };
-            esp_imgfx_data_t rotate_output_data = {
-                .data = rotate_dst,
-                .data_len = frame_.len,
-            };
-
-            imgfx_err = esp_imgfx_rotate_process(rotate_handle, &rotate_input_data, &rotate_output_data);
-            if (imgfx_err != ESP_IMGFX_ERR_OK) {
-                ESP_LOGE(TAG, "esp_imgfx_rotate_process failed");
-                heap_caps_free(rotate_dst);
-                rotate_dst = nullptr;
-                if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                    ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                }
-                esp_imgfx_rotate_close(rotate_handle);
-                rotate_handle = nullptr;
-                return false;
-            }
-
-            frame_.data = rotate_dst;
-
-            heap_caps_free(rotate_src);
-            rotate_src = nullptr;
-
-            esp_imgfx_rotate_close(rotate_handle);
-            rotate_handle = nullptr;
-#else   // CONFIG_SOC_PPA_SUPPORTED
-            uint8_t* rotate_src = nullptr;
-
-            ppa_srm_color_mode_t ppa_color_mode;
-            switch (frame_.format) {
-                case V4L2_PIX_FMT_RGB565:
-                    rotate_src = (uint8_t*)frame_.data;
-                    ppa_color_mode = PPA_SRM_COLOR_MODE_RGB565;
-                    break;
-                case V4L2_PIX_FMT_RGB24:
-                    rotate_src = (uint8_t*)frame_.data;
-                    ppa_color_mode = PPA_SRM_COLOR_MODE_RGB888;
-                    break;
-                case V4L2_PIX_FMT_YUYV: {
-                    ESP_LOGW(TAG, "YUYV format is not supported for PPA rotation, using software conversion to RGB888");
-                    rotate_src = (uint8_t*)heap_caps_malloc(frame_.width * frame_.height * 3,
-                                                            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-                    if (rotate_src == nullptr) {
-                        ESP_LOGE(TAG, "Failed to allocate memory for rotate image");
-                        if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                            ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                        }
-                        return false;
-                    }
-                    esp_imgfx_color_convert_cfg_t convert_cfg = {
-                        .in_res = {.width = static_cast<int16_t>(frame_.width),
-                                   .height = static_cast<int16_t>(frame_.height)},
-                        .in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_YUYV,
-                        .out_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB888,
-                    };
-                    esp_imgfx_color_convert_handle_t convert_handle = nullptr;
-                    esp_imgfx_err_t err = esp_imgfx_color_convert_open(&convert_cfg, &convert_handle);
-                    if (err != ESP_IMGFX_ERR_OK || convert_handle == nullptr) {
-                        ESP_LOGE(TAG, "esp_imgfx_color_convert_open failed");
-                        heap_caps_free(rotate_src);
-                        rotate_src = nullptr;
-                        if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                            ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                        }
-                        return false;
-                    }
-                    esp_imgfx_data_t convert_input_data = {
-                        .data = frame_.data,
-                        .data_len = frame_.len,
-                    };
-                    esp_imgfx_data_t convert_output_data = {
-                        .data = rotate_src,
-                        .data_len = static_cast<uint32_t>(frame_.width * frame_.height * 3),
-                    };
-                    err = esp_imgfx_color_convert_process(convert_handle, &convert_input_data, &convert_output_data);
-                    if (err != ESP_IMGFX_ERR_OK) {
-                        ESP_LOGE(TAG, "esp_imgfx_color_convert_process failed");
-                        heap_caps_free(rotate_src);
-                        rotate_src = nullptr;
-                        esp_imgfx_color_convert_close(convert_handle);
-                        convert_handle = nullptr;
-                        if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                            ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                        }
-                        return false;
-                    }
-                    esp_imgfx_color_convert_close(convert_handle);
-                    convert_handle = nullptr;
-                    ppa_color_mode = PPA_SRM_COLOR_MODE_RGB888;
-                    heap_caps_free(frame_.data);
-                    frame_.data = rotate_src;
-                    frame_.len = frame_.width * frame_.height * 3;
-                    break;
-                }
-                default:
-                    ESP_LOGE(TAG, "unsupported sensor format for PPA rotation: 0x%08lx", sensor_format_);
-                    if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                        ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                    }
-                    return false;
-            }
-
-            uint8_t* rotate_dst = (uint8_t*)heap_caps_malloc(
-                frame_.width * frame_.height * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT | MALLOC_CAP_CACHE_ALIGNED);
-            if (rotate_dst == nullptr) {
-                ESP_LOGE(TAG, "Failed to allocate memory for rotate image");
-                if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                    ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                }
-                return false;
+            break;
+        case V4L2_PIX_FMT_RGB565X:
+            // 大端序的 RGB565 需要转换为小端序
+            // 目前 esp_video 的大小端都会返回格式为 RGB565，不会返回格式为 RGB565X，此 case 用于未来版本兼容
+            format = V4L2_PIX_FMT_RGB565;
+            swap_bytes = true;
+            break;
+        default:
+            ESP_LOGE(TAG, "unsupported sensor format: 0x%08lx", sensor_format_);
+            if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
+                ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
             }
+            return nullptr;
+    }
 
-            ppa_client_handle_t ppa_client = nullptr;
-            ppa_client_config_t client_cfg = {
-                .oper_type = PPA_OPERATION_SRM,
-                .max_pending_trans_num = 1,
-            };
-            esp_err_t err = ppa_register_client(&client_cfg, &ppa_client);
-            if (err != ESP_OK || ppa_client == nullptr) {
-                ESP_LOGE(TAG, "ppa_register_client failed: %d", (int)err);
-                heap_caps_free(rotate_dst);
-                rotate_dst = nullptr;
-                if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                    ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                }
-                return false;
-            }
+    // 帧直接引用驱动的 mmap 缓冲区，预览、编码线程都释放后才 QBUF 归还驱动
+    auto frame = std::make_shared<CameraFrame>(data, len, raw_width, raw_height, format, [fd = video_fd_, buf]() mutable {
+        if (ioctl(fd, VIDIOC_QBUF, &buf) != 0) {
+            ESP_LOGE(TAG, "VIDIOC_QBUF failed");
+        }
+    });
+    if (swap_bytes) {
+        // 此时还没有其他使用者，直接原地交换
+        image_swap_bytes16(data, data, len / 2);
+        frame->MarkDirty();
+    }
 
-            ppa_srm_rotation_angle_t ppa_angle = IMAGE_ROTATION_ANGLE;
-
-            ppa_srm_oper_config_t srm_cfg = {};
-            srm_cfg.in.buffer = (void*)rotate_src;
-            srm_cfg.in.pic_w = sensor_width_;
-            srm_cfg.in.pic_h = sensor_height_;
-            srm_cfg.in.block_w = sensor_width_;
-            srm_cfg.in.block_h = sensor_height_;
-            srm_cfg.in.block_offset_x = 0;
-            srm_cfg.in.block_offset_y = 0;
-            srm_cfg.in.srm_cm = ppa_color_mode;
-
-            srm_cfg.out.buffer = (void*)rotate_dst;
-            srm_cfg.out.buffer_size = frame_.len;
-            srm_cfg.out.pic_w = frame_.width;
-            srm_cfg.out.pic_h = frame_.height;
-            srm_cfg.out.block_offset_x = 0;
-            srm_cfg.out.block_offset_y = 0;
-            srm_cfg.out.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
-
-            // 等比例缩放 1.0
-            srm_cfg.scale_x = 1.0f;
-            srm_cfg.scale_y = 1.0f;
-            srm_cfg.rotation_angle = ppa_angle;
-            srm_cfg.mode = PPA_TRANS_MODE_BLOCKING;
-            srm_cfg.user_data = nullptr;
-
-            err = ppa_do_scale_rotate_mirror(ppa_client, &srm_cfg);
-            if (err != ESP_OK) {
-                ESP_LOGE(TAG, "ppa_do_scale_rotate_mirror failed: %d", (int)err);
-                heap_caps_free(rotate_dst);
-                rotate_dst = nullptr;
-                (void)ppa_unregister_client(ppa_client);
-                if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-                    ESP_LOGE(TAG, "Cleanup: VIDIOC_QBUF failed");
-                }
-                return false;
-            }
+#ifdef CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
+    // 旋转需要另一块缓冲区，旋转完成后驱动缓冲区随 frame 一起释放
+    frame = RotateFrame(frame);
+#endif  // CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
+    return frame;
+}
 
-            (void)ppa_unregister_client(ppa_client);
+bool EspVideo::Capture() {
+    if (!streaming_on_ || video_fd_ < 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(camera_mutex_);
 
-            frame_.data = rotate_dst;
-            frame_.len = frame_.width * frame_.height * 2;
-            frame_.format = V4L2_PIX_FMT_RGB565;
-            heap_caps_free(rotate_src);
-            rotate_src = nullptr;
-#endif  // CONFIG_SOC_PPA_SUPPORTED
-#endif  // CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
-        }
+    // 上一帧可能还在预览，先释放它，让缓冲区回到驱动后再取新帧（驱动只有 1~2 个缓冲区）
+    auto display = dynamic_cast<LvglDisplay*>(Board::GetInstance().GetDisplay());
+    if (frame_ != nullptr && frame_.use_count() > 1 && display != nullptr) {
+        display->SetPreviewImage(nullptr);
+    }
+    frame_.reset();
 
-        if (ioctl(video_fd_, VIDIOC_QBUF, &buf) != 0) {
-            ESP_LOGE(TAG, "VIDIOC_QBUF failed");
+    auto frame = GrabFrame(2);
+    if (frame == nullptr) {
+        return false;
+    }
+    if (streamer_ != nullptr) {
+        // 推流任务还要继续从驱动取帧，拍照的帧复制一份，不占用驱动缓冲区
+        frame = frame->Clone();
+        if (frame == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate memory for frame copy");
+            return false;
         }
     }
+    frame_ = std::move(frame);
+    explain_cache_.OnCapture(*frame_);
 
     // 显示预览图片
-    auto display = dynamic_cast<LvglDisplay*>(Board::GetInstance().GetDisplay());
     if (display != nullptr) {
-        if (!frame_.data) {
-            ESP_LOGE(TAG, "frame.data is null");
-            return false;
-        }
-        uint16_t w = frame_.width;
-        uint16_t h = frame_.height;
-        size_t lvgl_image_size = frame_.len;
-        size_t stride = ((w * 2) + 3) & ~3;  // 4字节对齐
-        lv_color_format_t color_format = LV_COLOR_FORMAT_RGB565;
-        uint8_t* data = nullptr;
-
-        switch (frame_.format) {
+        uint16_t w = frame_->width();
+        uint16_t h = frame_->height();
+        std::unique_ptr<LvglImage> image;
+
+        switch (frame_->format()) {
             // LVGL 显示 YUV 系的图像似乎都有问题，暂时转换为 RGB565 显示
             case V4L2_PIX_FMT_YUYV:
             case V4L2_PIX_FMT_YUV420:
             case V4L2_PIX_FMT_RGB24: {
-                color_format = LV_COLOR_FORMAT_RGB565;
-                data = (uint8_t*)heap_caps_malloc(w * h * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+                uint8_t* data = (uint8_t*)heap_caps_malloc(w * h * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
                 if (data == nullptr) {
                     ESP_LOGE(TAG, "Failed to allocate memory for preview image");
                     return false;
                 }
-                esp_imgfx_color_convert_cfg_t convert_cfg = {
-                    .in_res = {.width = static_cast<int16_t>(frame_.width),
-                               .height = static_cast<int16_t>(frame_.height)},
-                    .in_pixel_fmt = static_cast<esp_imgfx_pixel_fmt_t>(frame_.format),
-                    .out_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB565_LE,
-                    .color_space_std = ESP_IMGFX_COLOR_SPACE_STD_BT601,
-                };
-                esp_imgfx_color_convert_handle_t convert_handle = nullptr;
-                esp_imgfx_err_t err = esp_imgfx_color_convert_open(&convert_cfg, &convert_handle);
-                if (err != ESP_IMGFX_ERR_OK || convert_handle == nullptr) {
-                    ESP_LOGE(TAG, "esp_imgfx_color_convert_open failed");
+                if (!image_convert(data, w * h * 2, V4L2_PIX_FMT_RGB565, frame_->data(), frame_->len(),
+                                   frame_->format(), w, h)) {
                     heap_caps_free(data);
-                    data = nullptr;
                     return false;
                 }
-                esp_imgfx_data_t convert_input_data = {
-                    .data = frame_.data,
-                    .data_len = frame_.len,
-                };
-                esp_imgfx_data_t convert_output_data = {
-                    .data = data,
-                    .data_len = static_cast<uint32_t>(w * h * 2),
-                };
-                err = esp_imgfx_color_convert_process(convert_handle, &convert_input_data, &convert_output_data);
-                if (err != ESP_IMGFX_ERR_OK) {
-                    ESP_LOGE(TAG, "esp_imgfx_color_convert_process failed");
-                    heap_caps_free(data);
-                    data = nullptr;
-                    esp_imgfx_color_convert_close(convert_handle);
-                    convert_handle = nullptr;
-                    return false;
-                }
-                esp_imgfx_color_convert_close(convert_handle);
-                convert_handle = nullptr;
-                lvgl_image_size = w * h * 2;
+                image = std::make_unique<LvglAllocatedImage>(data, w * h * 2, w, h, w * 2, LV_COLOR_FORMAT_RGB565);
                 break;
             }
 
             case V4L2_PIX_FMT_RGB565:
-                data = (uint8_t*)heap_caps_malloc(w * h * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-                if (data == nullptr) {
-                    ESP_LOGE(TAG, "Failed to allocate memory for preview image");
-                    return false;
-                }
-                memcpy(data, frame_.data, frame_.len);
-                lvgl_image_size = frame_.len;  // fallthrough 时兼顾 YUYV 与 RGB565
+                // 预览直接引用帧数据，不再复制
+                image = std::make_unique<LvglSharedImage>(frame_, frame_->data(), frame_->len(), w, h, w * 2,
+                                                          LV_COLOR_FORMAT_RGB565);
                 break;
 
 #ifdef CONFIG_XIAOZHI_CAMERA_ALLOW_JPEG_INPUT
@@ -810,8 +674,8 @@ bool EspVideo::Capture() {
                 size_t out_height = 0;
                 size_t out_stride = 0;
 
-                esp_err_t ret =
-                    jpeg_to_image(frame_.data, frame_.len, &out_data, &out_len, &out_width, &out_height, &out_stride);
+                esp_err_t ret = jpeg_to_image(frame_->data(), frame_->len(), &out_data, &out_len, &out_width,
+                                              &out_height, &out_stride);
                 if (ret != ESP_OK) {
                     ESP_LOGE(TAG, "Failed to decode JPEG image: %d (%s)", (int)ret, esp_err_to_name(ret));
                     if (out_data) {
@@ -821,25 +685,53 @@ bool EspVideo::Capture() {
                     return false;
                 }
 
-                data = out_data;
-                w = out_width;
-                h = out_height;
-                lvgl_image_size = out_len;
-                stride = out_stride;
+                image = std::make_unique<LvglAllocatedImage>(out_data, out_len, out_width, out_height, out_stride,
+                                                             LV_COLOR_FORMAT_RGB565);
                 break;
             }
 #endif
             default:
-                ESP_LOGE(TAG, "unsupported frame format: 0x%08lx", frame_.format);
+                ESP_LOGE(TAG, "unsupported frame format: 0x%08lx", frame_->format());
                 return false;
         }
 
-        auto image = std::make_unique<LvglAllocatedImage>(data, lvgl_image_size, w, h, stride, color_format);
         display->SetPreviewImage(std::move(image));
     }
     return true;
 }
 
+bool EspVideo::StartStreaming(const CameraStreamConfig& config, std::function<void()> on_frame_ready) {
+    std::lock_guard<std::mutex> lock(camera_mutex_);
+    if (!streaming_on_ || video_fd_ < 0 || streamer_ != nullptr) {
+        return false;
+    }
+
+    // 释放上一张照片占用的驱动缓冲区，推流需要持续取帧
+    auto display = dynamic_cast<LvglDisplay*>(Board::GetInstance().GetDisplay());
+    if (frame_ != nullptr && frame_.use_count() > 1 && display != nullptr) {
+        display->SetPreviewImage(nullptr);
+    }
+    frame_.reset();
+
+    streamer_ = std::make_unique<CameraStreamer>(config, [this]() { return GrabFrame(0); }, on_frame_ready);
+    return true;
+}
+
+void EspVideo::StopStreaming() {
+    std::lock_guard<std::mutex> lock(camera_mutex_);
+    streamer_.reset();
+    // 推流结束后不再频繁编码，释放编码器缓存的句柄和缓冲区
+    image_to_jpeg_release_cache();
+}
+
+std::unique_ptr<VideoStreamPacket> EspVideo::PopStreamFrame() {
+    std::lock_guard<std::mutex> lock(camera_mutex_);
+    if (streamer_ == nullptr) {
+        return nullptr;
+    }
+    return streamer_->PopFrame();
+}
+
 bool EspVideo::SetHMirror(bool enabled) {
     if (video_fd_ < 0)
         return false;
@@ -882,160 +774,53 @@ bool EspVideo::SetVFlip(bool enabled) {
  * 问题对图像进行AI分析并返回结果。
  *
  * 实现特点：
- * - 使用独立线程编码JPEG，与主线程分离
+ * - 在常驻的编码线程中编码JPEG，不再每次创建线程
  * - 采用分块传输编码(chunked transfer encoding)优化内存使用
- * - 通过队列机制实现编码线程和发送线程的数据同步
+ * - 编码线程与发送线程通过固定大小的环形缓冲区交换数据，满时编码等待，空时发送等待
  * - 支持设备ID、客户端ID和认证令牌的HTTP头部配置
  *
  * @param question 要向AI提出的关于图像的问题，将作为表单字段发送
+ * @param options  上传前的裁剪区域、最大边长与 JPEG 质量
  * @return std::string 服务器返回的JSON格式响应字符串
  *         成功时包含AI分析结果，失败时包含错误信息
  *         格式示例：{"success": true, "result": "分析结果"}
  *                  {"success": false, "message": "错误信息"}
  *
  * @note 调用此函数前必须先调用SetExplainUrl()设置服务器URL
- * @note 函数会等待之前的编码线程完成后再开始新的处理
+ * @note 函数返回前编码已经完成，帧数据不再被引用
  * @warning 如果摄像头缓冲区为空或网络连接失败，将返回错误信息
  */
-std::string EspVideo::Explain(const std::string& question) {
+std::string EspVideo::Explain(const std::string& question, const CameraExplainOptions& options) {
     if (explain_url_.empty()) {
         throw std::runtime_error("Image explain URL or token is not set");
     }
 
-    // 创建局部的 JPEG 队列, 40 entries is about to store 512 * 40 = 20480 bytes of JPEG data
-    QueueHandle_t jpeg_queue = xQueueCreate(40, sizeof(JpegChunk));
-    if (jpeg_queue == nullptr) {
-        ESP_LOGE(TAG, "Failed to create JPEG queue");
-        throw std::runtime_error("Failed to create JPEG queue");
-    }
-
-    // We spawn a thread to encode the image to JPEG using optimized encoder (cost about 500ms and 8KB SRAM)
-    encoder_thread_ = std::thread([this, jpeg_queue]() {
-        uint16_t w = frame_.width ? frame_.width : 320;
-        uint16_t h = frame_.height ? frame_.height : 240;
-        v4l2_pix_fmt_t enc_fmt = frame_.format;
-        bool ok = image_to_jpeg_cb(
-            frame_.data, frame_.len, w, h, enc_fmt, 80,
-            [](void* arg, size_t index, const void* data, size_t len) -> size_t {
-                auto jpeg_queue = static_cast<QueueHandle_t>(arg);
-                JpegChunk chunk = {.data = nullptr, .len = len};
-                if (index == 0 && data != nullptr && len > 0) {
-                    chunk.data = (uint8_t*)heap_caps_aligned_alloc(16, len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-                    if (chunk.data == nullptr) {
-                        ESP_LOGE(TAG, "Failed to allocate %zu bytes for JPEG chunk", len);
-                        chunk.len = 0;
-                    } else {
-                        memcpy(chunk.data, data, len);
-                    }
-                } else {
-                    chunk.len = 0;  // Sentinel or error
-                }
-                xQueueSend(jpeg_queue, &chunk, portMAX_DELAY);
-                return len;
-            },
-            jpeg_queue);
-
-        if (!ok) {
-            JpegChunk chunk = {.data = nullptr, .len = 0};
-            xQueueSend(jpeg_queue, &chunk, portMAX_DELAY);
-        }
-    });
-
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(3);
-    // 构造multipart/form-data请求体
-    std::string boundary = "----ESP32_CAMERA_BOUNDARY";
-
-    // 配置HTTP客户端，使用分块传输编码
-    http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
-    http->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
-    if (!explain_token_.empty()) {
-        http->SetHeader("Authorization", "Bearer " + explain_token_);
-    }
-    http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
-    http->SetHeader("Transfer-Encoding", "chunked");
-    if (!http->Open("POST", explain_url_)) {
-        ESP_LOGE(TAG, "Failed to connect to explain URL");
-        // Clear the queue
-        encoder_thread_.join();
-        JpegChunk chunk;
-        while (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) == pdPASS) {
-            if (chunk.data != nullptr) {
-                heap_caps_free(chunk.data);
-            } else {
-                break;
-            }
-        }
-        vQueueDelete(jpeg_queue);
-        throw std::runtime_error("Failed to connect to explain URL");
-    }
-
+    std::lock_guard<std::mutex> explain_lock(explain_mutex_);
+    std::shared_ptr<CameraFrame> frame;
     {
-        // 第一块：question字段
-        std::string question_field;
-        question_field += "--" + boundary + "\r\n";
-        question_field += "Content-Disposition: form-data; name=\"question\"\r\n";
-        question_field += "\r\n";
-        question_field += question + "\r\n";
-        http->Write(question_field.c_str(), question_field.size());
-    }
-    {
-        // 第二块：文件字段头部
-        std::string file_header;
-        file_header += "--" + boundary + "\r\n";
-        file_header += "Content-Disposition: form-data; name=\"file\"; filename=\"camera.jpg\"\r\n";
-        file_header += "Content-Type: image/jpeg\r\n";
-        file_header += "\r\n";
-        http->Write(file_header.c_str(), file_header.size());
-    }
-
-    // 第三块：JPEG数据
-    size_t total_sent = 0;
-    bool saw_terminator = false;
-    while (true) {
-        JpegChunk chunk;
-        if (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) != pdPASS) {
-            ESP_LOGE(TAG, "Failed to receive JPEG chunk");
-            break;
+        std::lock_guard<std::mutex> lock(camera_mutex_);
+        if (frame_ == nullptr) {
+            throw std::runtime_error("No camera frame captured");
         }
-        if (chunk.data == nullptr) {
-            saw_terminator = true;
-            break;  // The last chunk
+
+        // 场景没有变化时直接复用上一次相同问题的回答
+        std::string cached_result;
+        if (explain_cache_.Lookup(question, options, cached_result)) {
+            return cached_result;
         }
-        http->Write((const char*)chunk.data, chunk.len);
-        total_sent += chunk.len;
-        heap_caps_free(chunk.data);
-    }
-    // Wait for the encoder thread to finish
-    encoder_thread_.join();
-    // 清理队列
-    vQueueDelete(jpeg_queue);
-
-    if (!saw_terminator || total_sent == 0) {
-        ESP_LOGE(TAG, "JPEG encoder failed or produced empty output");
-        throw std::runtime_error("Failed to encode image to JPEG");
+        frame = frame_;
     }
 
+    // 编码在常驻线程中进行，边编码边通过环形缓冲区上传
+    std::string result = explain_uploader_.Upload(explain_url_, explain_token_, question, frame, options);
     {
-        // 第四块：multipart尾部
-        std::string multipart_footer;
-        multipart_footer += "\r\n--" + boundary + "--\r\n";
-        http->Write(multipart_footer.c_str(), multipart_footer.size());
+        std::lock_guard<std::mutex> lock(camera_mutex_);
+        explain_cache_.Store(question, options, result);
     }
-    // 结束块
-    http->Write("", 0);
-
-    if (http->GetStatusCode() != 200) {
-        ESP_LOGE(TAG, "Failed to upload photo, status code: %d", http->GetStatusCode());
-        throw std::runtime_error("Failed to upload photo");
-    }
-
-    std::string result = http->ReadAll();
-    http->Close();
 
     // Get remain task stack size
     size_t remain_stack_size = uxTaskGetStackHighWaterMark(nullptr);
-    ESP_LOGI(TAG, "Explain image size=%d bytes, compressed size=%d, remain stack size=%d, question=%s\n%s",
-             (int)frame_.len, (int)total_sent, (int)remain_stack_size, question.c_str(), result.c_str());
+    ESP_LOGI(TAG, "Explain remain stack size=%d, question=%s\n%s", (int)remain_stack_size, question.c_str(),
+             result.c_str());
     return result;
 }
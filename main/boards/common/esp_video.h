@@ -2,31 +2,23 @@
 #include "sdkconfig.h"
 
 #include <lvgl.h>
-#include <thread>
 #include <memory>
+#include <mutex>
 #include <vector>
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
-
 #include "camera.h"
+#include "camera_frame.h"
+#include "camera_streamer.h"
+#include "explain_cache.h"
+#include "explain_uploader.h"
 #include "jpg/image_to_jpeg.h"
 #include "esp_video_init.h"
 
-struct JpegChunk {
-    uint8_t* data;
-    size_t len;
-};
-
 class EspVideo : public Camera {
 private:
-    struct FrameBuffer {
-        uint8_t *data = nullptr;
-        size_t len = 0;
-        uint16_t width = 0;
-        uint16_t height = 0;
-        v4l2_pix_fmt_t format = 0;
-    } frame_;
+    std::shared_ptr<CameraFrame> frame_;  // 最近一次拍摄的帧，与预览图、编码线程共享
+    uint16_t frame_width_ = 0;  // 输出帧尺寸（旋转后）
+    uint16_t frame_height_ = 0;
     v4l2_pix_fmt_t sensor_format_ = 0;
 #ifdef CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
     uint16_t sensor_width_ = 0;
@@ -38,7 +30,19 @@ private:
     std::vector<MmapBuffer> mmap_buffers_;
     std::string explain_url_;
     std::string explain_token_;
-    std::thread encoder_thread_;
+    std::unique_ptr<CameraStreamer> streamer_;
+    ExplainCache explain_cache_;
+    ExplainUploader explain_uploader_;
+    std::mutex grab_mutex_;
+    // 保护 frame_、预览、streamer_ 和 explain_cache_：MCP 工具在工作线程执行，推流可能在主线程停止
+    mutable std::mutex camera_mutex_;
+    // 同一时间只上传一张照片，上传期间不持有 camera_mutex_，推流仍可停止
+    std::mutex explain_mutex_;
+
+    std::shared_ptr<CameraFrame> GrabFrame(int skip_frames);
+#ifdef CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
+    std::shared_ptr<CameraFrame> RotateFrame(const std::shared_ptr<CameraFrame>& src);
+#endif  // CONFIG_XIAOZHI_ENABLE_ROTATE_CAMERA_IMAGE
 
 public:
     EspVideo(const esp_video_init_config_t& config);
@@ -49,5 +53,12 @@ public:
     // 翻转控制函数
     virtual bool SetHMirror(bool enabled) override;
     virtual bool SetVFlip(bool enabled) override;
-    virtual std::string Explain(const std::string& question);
+    virtual std::string Explain(const std::string& question, const CameraExplainOptions& options);
+    virtual bool StartStreaming(const CameraStreamConfig& config, std::function<void()> on_frame_ready) override;
+    virtual void StopStreaming() override;
+    virtual bool IsStreaming() const override {
+        std::lock_guard<std::mutex> lock(camera_mutex_);
+        return streamer_ != nullptr;
+    }
+    virtual std::unique_ptr<VideoStreamPacket> PopStreamFrame() override;
 };
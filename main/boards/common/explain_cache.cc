@@ -0,0 +1,139 @@
+#include "explain_cache.h"
+
+#include <cstdlib>
+
+#include <cJSON.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "ExplainCache"
+
+// A scene counts as changed once this many cells (about 1% of the thumbnail) differ
+#define SCENE_CHANGED_CELLS 8
+
+static inline uint8_t LumaAt(const CameraFrame& frame, int x, int y) {
+    const uint8_t* data = frame.data();
+    size_t index = (size_t)y * frame.width() + x;
+    switch (frame.format()) {
+        case V4L2_PIX_FMT_GREY:
+        case V4L2_PIX_FMT_YUV420:  // Y plane comes first
+            return data[index];
+        case V4L2_PIX_FMT_YUYV:
+            return data[index * 2];
+        case V4L2_PIX_FMT_RGB565: {
+            uint16_t p = data[index * 2] | (data[index * 2 + 1] << 8);
+            int r = (p >> 8) & 0xF8;
+            int g = (p >> 3) & 0xFC;
+            int b = (p << 3) & 0xF8;
+            return (r * 77 + g * 150 + b * 29) >> 8;
+        }
+        case V4L2_PIX_FMT_RGB24: {
+            const uint8_t* p = data + index * 3;
+            return (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8;
+        }
+        default:
+            return 0;
+    }
+}
+
+SceneSignature SceneSignature::FromFrame(const CameraFrame& frame) {
+    SceneSignature signature;
+    switch (frame.format()) {
+        case V4L2_PIX_FMT_GREY:
+        case V4L2_PIX_FMT_YUV420:
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_RGB565:
+        case V4L2_PIX_FMT_RGB24:
+            break;
+        default:
+            return signature;
+    }
+    if (frame.width() < kColumns * 2 || frame.height() < kRows * 2) {
+        return signature;
+    }
+
+    // Average a 2x2 grid of samples per cell, enough to smooth sensor noise without reading the frame
+    for (int row = 0; row < kRows; row++) {
+        int y0 = (row * 4 + 1) * frame.height() / (kRows * 4);
+        int y1 = (row * 4 + 3) * frame.height() / (kRows * 4);
+        for (int col = 0; col < kColumns; col++) {
+            int x0 = (col * 4 + 1) * frame.width() / (kColumns * 4);
+            int x1 = (col * 4 + 3) * frame.width() / (kColumns * 4);
+            int sum = LumaAt(frame, x0, y0) + LumaAt(frame, x1, y0) + LumaAt(frame, x0, y1) + LumaAt(frame, x1, y1);
+            signature.luma_[row * kColumns + col] = sum / 4;
+        }
+    }
+    signature.valid_ = true;
+    return signature;
+}
+
+int SceneSignature::CountChangedCells(const SceneSignature& other, int threshold) const {
+    if (!valid_ || !other.valid_) {
+        return -1;
+    }
+    int changed = 0;
+    for (int i = 0; i < kColumns * kRows; i++) {
+        if (std::abs(luma_[i] - other.luma_[i]) > threshold) {
+            changed++;
+        }
+    }
+    return changed;
+}
+
+static bool SameOptions(const CameraExplainOptions& a, const CameraExplainOptions& b) {
+    return a.quality == b.quality && a.max_size == b.max_size && a.roi_x == b.roi_x && a.roi_y == b.roi_y &&
+           a.roi_width == b.roi_width && a.roi_height == b.roi_height;
+}
+
+void ExplainCache::OnCapture(const CameraFrame& frame) {
+#if CONFIG_XIAOZHI_CAMERA_EXPLAIN_CACHE_SECONDS > 0
+    auto signature = SceneSignature::FromFrame(frame);
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_ = signature;
+#endif
+}
+
+bool ExplainCache::Lookup(const std::string& question, const CameraExplainOptions& options, std::string& result) {
+#if CONFIG_XIAOZHI_CAMERA_EXPLAIN_CACHE_SECONDS > 0
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cached_result_.empty() || question != cached_question_ || !SameOptions(options, cached_options_)) {
+        return false;
+    }
+    int64_t age = esp_timer_get_time() - cached_time_;
+    if (age > (int64_t)CONFIG_XIAOZHI_CAMERA_EXPLAIN_CACHE_SECONDS * 1000000) {
+        return false;
+    }
+    int changed = current_.CountChangedCells(cached_signature_, CONFIG_XIAOZHI_CAMERA_SCENE_CHANGE_THRESHOLD);
+    if (changed < 0 || changed >= SCENE_CHANGED_CELLS) {
+        ESP_LOGD(TAG, "Scene changed: %d cells", changed);
+        return false;
+    }
+    ESP_LOGI(TAG, "Scene unchanged (%d cells differ), reusing the answer from %d ms ago", changed, (int)(age / 1000));
+    result = cached_result_;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ExplainCache::Store(const std::string& question, const CameraExplainOptions& options, const std::string& result) {
+#if CONFIG_XIAOZHI_CAMERA_EXPLAIN_CACHE_SECONDS > 0
+    // Errors reported by the server are not worth repeating
+    auto root = cJSON_Parse(result.c_str());
+    if (root == nullptr) {
+        return;
+    }
+    bool success = !cJSON_IsFalse(cJSON_GetObjectItem(root, "success"));
+    cJSON_Delete(root);
+    if (!success) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cached_signature_ = current_;
+    cached_question_ = question;
+    cached_options_ = options;
+    cached_result_ = result;
+    cached_time_ = esp_timer_get_time();
+#endif
+}
@@ -0,0 +1,52 @@
+#ifndef EXPLAIN_CACHE_H
+#define EXPLAIN_CACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "camera.h"
+#include "camera_frame.h"
+
+// Coarse luma thumbnail of a frame. Two signatures are compared block by block (SAD per cell)
+// to tell whether the scene changed between two captures.
+class SceneSignature {
+public:
+    static constexpr int kColumns = 32;
+    static constexpr int kRows = 24;
+
+    // Sample the frame, returns an invalid signature for formats that can't be sampled (JPEG)
+    static SceneSignature FromFrame(const CameraFrame& frame);
+
+    bool valid() const { return valid_; }
+
+    // Number of cells whose mean luma differs by more than threshold, -1 if either side is invalid
+    int CountChangedCells(const SceneSignature& other, int threshold) const;
+
+private:
+    uint8_t luma_[kColumns * kRows];
+    bool valid_ = false;
+};
+
+// Remembers the answer of the last Explain request together with the signature of the frame it
+// was asked about. The same question on an unchanged scene is then answered without uploading.
+class ExplainCache {
+public:
+    // Called with every new capture, the signature is compared against the cached one on lookup
+    void OnCapture(const CameraFrame& frame);
+
+    // True and the previous answer if the question and options match and the scene didn't change
+    bool Lookup(const std::string& question, const CameraExplainOptions& options, std::string& result);
+    void Store(const std::string& question, const CameraExplainOptions& options, const std::string& result);
+
+private:
+    std::mutex mutex_;
+    SceneSignature current_;
+    SceneSignature cached_signature_;
+    std::string cached_question_;
+    CameraExplainOptions cached_options_;
+    std::string cached_result_;
+    int64_t cached_time_ = 0;
+};
+
+#endif // EXPLAIN_CACHE_H
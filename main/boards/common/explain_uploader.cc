@@ -0,0 +1,257 @@
+#include "explain_uploader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "board.h"
+#include "system_info.h"
+#include "jpg/image_to_jpeg.h"
+
+#define TAG "ExplainUploader"
+
+#define EXPLAIN_RING_SIZE (32 * 1024)
+
+ExplainUploader::~ExplainUploader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        cancelled_ = true;
+    }
+    condition_variable_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    if (ring_ != nullptr) {
+        heap_caps_free(ring_);
+    }
+}
+
+void ExplainUploader::WorkerLoop() {
+    while (true) {
+        std::shared_ptr<CameraFrame> frame;
+        CameraExplainOptions options;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_variable_.wait(lock, [this]() { return !running_ || job_frame_ != nullptr; });
+            if (!running_) {
+                break;
+            }
+            frame = job_frame_;
+            options = job_options_;
+        }
+
+        Encode(frame, options);
+        frame.reset();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_frame_.reset();
+            encoding_ = false;
+        }
+        condition_variable_.notify_all();
+    }
+}
+
+void ExplainUploader::Encode(const std::shared_ptr<CameraFrame>& frame, const CameraExplainOptions& options) {
+    int64_t start_time = esp_timer_get_time();
+    if (frame->format() == V4L2_PIX_FMT_JPEG) {
+        // Already compressed by the sensor, upload the bytes without re-encoding
+        bool ok = RingWrite(frame->data(), frame->len());
+        std::lock_guard<std::mutex> lock(mutex_);
+        encode_ok_ = ok;
+        encode_time_us_ = esp_timer_get_time() - start_time;
+        return;
+    }
+
+    // Crop and downscale before encoding, the server resizes large images anyway
+    auto source = PrepareExplainFrame(frame, options);
+    bool ok = image_to_jpeg_cb(source->data(), source->len(), source->width(), source->height(), source->format(),
+                               options.quality,
+        [](void* arg, size_t index, const void* data, size_t len) -> size_t {
+            auto uploader = static_cast<ExplainUploader*>(arg);
+            if (index == 0 && data != nullptr && len > 0) {
+                if (!uploader->RingWrite(static_cast<const uint8_t*>(data), len)) {
+                    return 0;
+                }
+            }
+            return len;
+        }, this);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    encode_ok_ = ok && !cancelled_;
+    encode_time_us_ = esp_timer_get_time() - start_time;
+}
+
+bool ExplainUploader::RingWrite(const uint8_t* data, size_t len) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (len > 0) {
+        if (ring_used_ == EXPLAIN_RING_SIZE && !cancelled_) {
+            int64_t wait_start = esp_timer_get_time();
+            condition_variable_.wait(lock, [this]() { return cancelled_ || ring_used_ < EXPLAIN_RING_SIZE; });
+            encoder_stall_us_ += esp_timer_get_time() - wait_start;
+        }
+        if (cancelled_) {
+            return false;
+        }
+        // Copy into the free space up to the end of the ring, the rest wraps around next time
+        size_t write_pos = (ring_read_ + ring_used_) % EXPLAIN_RING_SIZE;
+        size_t n = std::min(len, std::min(EXPLAIN_RING_SIZE - ring_used_, EXPLAIN_RING_SIZE - write_pos));
+        memcpy(ring_ + write_pos, data, n);
+        ring_used_ += n;
+        data += n;
+        len -= n;
+        condition_variable_.notify_all();
+    }
+    return true;
+}
+
+size_t ExplainUploader::RingPeek(const uint8_t** data) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (ring_used_ == 0 && encoding_) {
+        int64_t wait_start = esp_timer_get_time();
+        condition_variable_.wait(lock, [this]() { return ring_used_ > 0 || !encoding_; });
+        writer_stall_us_ += esp_timer_get_time() - wait_start;
+    }
+    // Contiguous part only, the wrapped part is returned by the next call
+    *data = ring_ + ring_read_;
+    return std::min(ring_used_, EXPLAIN_RING_SIZE - ring_read_);
+}
+
+void ExplainUploader::RingConsume(size_t len) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring_read_ = (ring_read_ + len) % EXPLAIN_RING_SIZE;
+        ring_used_ -= len;
+    }
+    condition_variable_.notify_all();
+}
+
+void ExplainUploader::CancelAndWait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    condition_variable_.notify_all();
+    condition_variable_.wait(lock, [this]() { return !encoding_; });
+}
+
+std::string ExplainUploader::Upload(const std::string& url, const std::string& token, const std::string& question,
+                                    const std::shared_ptr<CameraFrame>& frame, const CameraExplainOptions& options) {
+    if (ring_ == nullptr) {
+        ring_ = (uint8_t*)heap_caps_malloc(EXPLAIN_RING_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (ring_ == nullptr) {
+            throw std::runtime_error("Failed to allocate JPEG ring buffer");
+        }
+    }
+    if (!worker_.joinable()) {
+        worker_ = std::thread([this]() { WorkerLoop(); });
+    }
+
+    // Start encoding right away, it overlaps with the connection setup below
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring_read_ = 0;
+        ring_used_ = 0;
+        encoder_stall_us_ = 0;
+        writer_stall_us_ = 0;
+        cancelled_ = false;
+        encode_ok_ = false;
+        encoding_ = true;
+        job_frame_ = frame;
+        job_options_ = options;
+    }
+    condition_variable_.notify_all();
+
+    auto network = Board::GetInstance().GetNetwork();
+    auto http = network->CreateHttp(3);
+    std::string boundary = "----ESP32_CAMERA_BOUNDARY";
+
+    http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
+    http->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
+    if (!token.empty()) {
+        http->SetHeader("Authorization", "Bearer " + token);
+    }
+    http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
+    http->SetHeader("Transfer-Encoding", "chunked");
+    if (!http->Open("POST", url)) {
+        ESP_LOGE(TAG, "Failed to connect to explain URL");
+        CancelAndWait();
+        throw std::runtime_error("Failed to connect to explain URL");
+    }
+
+    {
+        std::string question_field;
+        question_field += "--" + boundary + "\r\n";
+        question_field += "Content-Disposition: form-data; name=\"question\"\r\n";
+        question_field += "\r\n";
+        question_field += question + "\r\n";
+        http->Write(question_field.c_str(), question_field.size());
+    }
+    {
+        std::string file_header;
+        file_header += "--" + boundary + "\r\n";
+        file_header += "Content-Disposition: form-data; name=\"file\"; filename=\"camera.jpg\"\r\n";
+        file_header += "Content-Type: image/jpeg\r\n";
+        file_header += "\r\n";
+        http->Write(file_header.c_str(), file_header.size());
+    }
+
+    // Each contiguous span of the ring goes out as one chunk, no intermediate copy
+    int64_t upload_start = esp_timer_get_time();
+    size_t total_sent = 0;
+    while (true) {
+        const uint8_t* data = nullptr;
+        size_t len = RingPeek(&data);
+        if (len == 0) {
+            break;  // Encoder finished and the ring is drained
+        }
+        if (http->Write((const char*)data, len) < 0) {
+            ESP_LOGE(TAG, "Failed to write JPEG data");
+            CancelAndWait();
+            throw std::runtime_error("Failed to upload photo");
+        }
+        RingConsume(len);
+        total_sent += len;
+    }
+    int64_t upload_time = esp_timer_get_time() - upload_start;
+
+    bool encode_ok;
+    int64_t encode_time, encoder_stall, writer_stall;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        encode_ok = encode_ok_;
+        encode_time = encode_time_us_;
+        encoder_stall = encoder_stall_us_;
+        writer_stall = writer_stall_us_;
+    }
+    if (!encode_ok || total_sent == 0) {
+        ESP_LOGE(TAG, "JPEG encoder failed or produced empty output");
+        throw std::runtime_error("Failed to encode image to JPEG");
+    }
+
+    {
+        std::string multipart_footer;
+        multipart_footer += "\r\n--" + boundary + "--\r\n";
+        http->Write(multipart_footer.c_str(), multipart_footer.size());
+    }
+    http->Write("", 0);
+
+    if (http->GetStatusCode() != 200) {
+        ESP_LOGE(TAG, "Failed to upload photo, status code: %d", http->GetStatusCode());
+        throw std::runtime_error("Failed to upload photo");
+    }
+
+    std::string result = http->ReadAll();
+    http->Close();
+
+    // Encoder stall means the network was the bottleneck, writer stall means the encoder was
+    int upload_ms = std::max<int>(1, upload_time / 1000);
+    ESP_LOGI(TAG, "Uploaded %dx%d frame: %u bytes in %d ms (%d KB/s), encode %d ms, encoder stalled %d ms, "
+             "writer stalled %d ms", frame->width(), frame->height(), (unsigned)total_sent, upload_ms,
+             (int)(total_sent / upload_ms), (int)(encode_time / 1000), (int)(encoder_stall / 1000),
+             (int)(writer_stall / 1000));
+    return result;
+}
@@ -0,0 +1,59 @@
+#ifndef EXPLAIN_UPLOADER_H
+#define EXPLAIN_UPLOADER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "camera.h"
+#include "camera_frame.h"
+
+// Uploads a frame to the explain server as multipart/form-data while it is being encoded.
+// A persistent worker thread encodes the JPEG into a fixed byte ring; the HTTP writer sends
+// straight out of the ring with chunked transfer encoding. A full ring blocks the encoder and an
+// empty ring blocks the writer, so memory use stays bounded whichever side is slower.
+class ExplainUploader {
+public:
+    ExplainUploader() = default;
+    ~ExplainUploader();
+
+    ExplainUploader(const ExplainUploader&) = delete;
+    ExplainUploader& operator=(const ExplainUploader&) = delete;
+
+    // Returns the server response, throws std::runtime_error on failure
+    std::string Upload(const std::string& url, const std::string& token, const std::string& question,
+                       const std::shared_ptr<CameraFrame>& frame, const CameraExplainOptions& options);
+
+private:
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    bool running_ = true;
+
+    // Encode job, the worker clears job_frame_ when it is done with it
+    std::shared_ptr<CameraFrame> job_frame_;
+    CameraExplainOptions job_options_;
+    bool encoding_ = false;
+    bool encode_ok_ = false;
+    bool cancelled_ = false;
+    int64_t encode_time_us_ = 0;
+
+    // Byte ring, allocated once on first use
+    uint8_t* ring_ = nullptr;
+    size_t ring_read_ = 0;
+    size_t ring_used_ = 0;
+    int64_t encoder_stall_us_ = 0;
+    int64_t writer_stall_us_ = 0;
+
+    void WorkerLoop();
+    void Encode(const std::shared_ptr<CameraFrame>& frame, const CameraExplainOptions& options);
+    bool RingWrite(const uint8_t* data, size_t len);
+    size_t RingPeek(const uint8_t** data);
+    void RingConsume(size_t len);
+    void CancelAndWait();
+};
+
+#endif // EXPLAIN_UPLOADER_H
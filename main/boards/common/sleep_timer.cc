@@ -2,11 +2,11 @@
 #include "application.h"
 #include "board.h"
 #include "display.h"
+#include "lvgl_display.h"
 #include "settings.h"
 
 #include <esp_log.h>
 #include <esp_sleep.h>
-#include <esp_lvgl_port.h>
 
 #define TAG "SleepTimer"
 
@@ -90,14 +90,20 @@ void SleepTimer::CheckTimer() {
                     auto& board = Board::GetInstance();
                     board.GetDisplay()->UpdateStatusBar(true);
                     lv_refr_now(nullptr);
-                    lvgl_port_stop();
+                    // Counted with the display governor, which may have stopped the LVGL task already
+                    auto lvgl_display = dynamic_cast<LvglDisplay*>(board.GetDisplay());
+                    if (lvgl_display != nullptr) {
+                        lvgl_display->SuspendRendering();
+                    }
     
                     // 配置timer唤醒源（30秒后自动唤醒）
                     esp_sleep_enable_timer_wakeup(30 * 1000000);
                     
                     // 进入light sleep模式
                     esp_light_sleep_start();
-                    lvgl_port_resume();
+                    if (lvgl_display != nullptr) {
+                        lvgl_display->ResumeRendering();
+                    }
 
                     auto wakeup_reason = esp_sleep_get_wakeup_cause();
                     ESP_LOGI(TAG, "Wake up from light sleep, wakeup_reason: %d", wakeup_reason);
@@ -118,6 +124,7 @@ void SleepTimer::CheckTimer() {
             on_enter_deep_sleep_mode_();
         }
 
+        Settings::Flush();
         esp_deep_sleep_start();
     }
 }
@@ -3,6 +3,7 @@
 #include "display.h"
 
 #include <esp_log.h>
+#include "settings.h"
 
 #define TAG "Sy6970"
 
@@ -61,5 +62,6 @@ int Sy6970::GetBatteryLevel() {
 }
 
 void Sy6970::PowerOff() {
+    Settings::Flush();
     WriteReg(0x09, 0B01100100);
 }
@@ -525,7 +525,15 @@ public:
         ESP_LOGI(TAG, "开始注册MCP工具...");
 
         // 统一动作工具（除了舵机序列外的所有动作）
-        mcp_server.AddTool("self.otto.action",
+        struct ActionArgs {
+            std::string action;
+            int steps;
+            int speed;
+            int direction;
+            int amount;
+            int arm_swing;
+        };
+        mcp_server.AddTool<ActionArgs>("self.otto.action",
                            "执行机器人动作。action: 动作名称；根据动作类型提供相应参数：direction: 方向，1=前进/左转，-1=后退/右转；0=左右同时"
                            "steps: 动作步数，1-100；speed: 动作速度，100-3000，数值越小越快；amount: 动作幅度，0-170；arm_swing: 手臂摆动幅度，0-170；"
                            "基础动作：walk(行走，需steps/speed/direction/arm_swing)、turn(转身，需steps/speed/direction/arm_swing)、jump(跳跃，需steps/speed)、"
@@ -535,22 +543,22 @@ public:
                            "手部动作(需手部舵机)：hands_up(举手，需speed/direction)、hands_down(放手，需speed/direction)、hand_wave(挥手，需direction)、"
                            "windmill(大风车，需steps/speed/amount)、takeoff(起飞，需steps/speed/amount)、fitness(健身，需steps/speed/amount)、"
                            "greeting(打招呼，需direction/steps)、shy(害羞，需direction/steps)、radio_calisthenics(广播体操)、magic_circle(爱的魔力转圈圈)",
-                           PropertyList({
-                               Property("action", kPropertyTypeString, "sit"),
-                               Property("steps", kPropertyTypeInteger, 3, 1, 100),
-                               Property("speed", kPropertyTypeInteger, 700, 100, 3000),
-                               Property("direction", kPropertyTypeInteger, 1, -1, 1),
-                               Property("amount", kPropertyTypeInteger, 30, 0, 170),
-                               Property("arm_swing", kPropertyTypeInteger, 50, 0, 170)
-                           }),
-                           [this](const PropertyList& properties) -> ReturnValue {
-                               std::string action = properties["action"].value<std::string>();
+                           {
+                               McpArgument("action", &ActionArgs::action, std::string("sit")),
+                               McpArgument("steps", &ActionArgs::steps, 3, 1, 100),
+                               McpArgument("speed", &ActionArgs::speed, 700, 100, 3000),
+                               McpArgument("direction", &ActionArgs::direction, 1, -1, 1),
+                               McpArgument("amount", &ActionArgs::amount, 30, 0, 170),
+                               McpArgument("arm_swing", &ActionArgs::arm_swing, 50, 0, 170)
+                           },
+                           [this](const ActionArgs& args) -> ReturnValue {
+                               const std::string& action = args.action;
                                // 所有参数都有默认值，直接访问即可
-                               int steps = properties["steps"].value<int>();
-                               int speed = properties["speed"].value<int>();
-                               int direction = properties["direction"].value<int>();
-                               int amount = properties["amount"].value<int>();
-                               int arm_swing = properties["arm_swing"].value<int>();
+                               int steps = args.steps;
+                               int speed = args.speed;
+                               int direction = args.direction;
+                               int amount = args.amount;
+                               int arm_swing = args.arm_swing;
 
                                // 基础移动动作
                                if (action == "walk") {
@@ -656,7 +664,7 @@ public:
                                } else {
                                    return "错误：无效的动作名称。可用动作：walk, turn, jump, swing, moonwalk, bend, shake_leg, updown, whirlwind_leg, sit, showcase, home, hands_up, hands_down, hand_wave, windmill, takeoff, fitness, greeting, shy, radio_calisthenics, magic_circle";
                                }
-                           });
+                           })->set_execution(kMcpToolBackground);  // 动作队列满时会阻塞，放到后台按顺序执行
 
 
         // 舵机序列工具（支持分段发送，每次发送一个序列，自动排队执行）
@@ -697,7 +705,7 @@ public:
                 // 如果sequence是JSON字符串，直接使用；如果是对象字符串，也需要使用
                 QueueServoSequence(sequence.c_str());
                 return true;
-            });
+            })->set_execution(kMcpToolBackground);
 
 
         mcp_server.AddTool("self.otto.stop", "立即停止所有动作并复位", PropertyList(),
@@ -90,6 +90,9 @@ void OttoEmojiDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
         if (gif_controller_) {
             gif_controller_->Start();
         }
+        if (anim_controller_) {
+            anim_controller_->Start();
+        }
         return;
     }
 
@@ -107,6 +110,9 @@ void OttoEmojiDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     if (gif_controller_) {
         gif_controller_->Stop();
     }
+    if (anim_controller_) {
+        anim_controller_->Stop();
+    }
     lv_obj_add_flag(emoji_box_, LV_OBJ_FLAG_HIDDEN);
     lv_obj_remove_flag(preview_image_, LV_OBJ_FLAG_HIDDEN);
     esp_timer_stop(preview_timer_);
@@ -674,7 +674,10 @@ bool SscmaCamera::SetVFlip(bool enabled) {
  * @note 函数会等待之前的编码线程完成后再开始新的处理
  * @warning 如果摄像头缓冲区为空或网络连接失败，将返回错误信息
  */
-std::string SscmaCamera::Explain(const std::string& question) {
+std::string SscmaCamera::Explain(const std::string& question, const CameraExplainOptions& options) {
+    // 图像由 SSCMA 模组直接输出 JPEG，不支持裁剪缩放
+    (void)options;
+
     if (explain_url_.empty()) {
         return "{\"success\": false, \"message\": \"Image explain URL or token is not set\"}";
     }
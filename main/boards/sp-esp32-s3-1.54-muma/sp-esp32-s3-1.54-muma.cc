@@ -24,6 +24,7 @@
 #include "power_save_timer.h"
 #include <esp_sleep.h>
 #include <driver/rtc_io.h>
+#include "settings.h"
 
 #define TAG "Spotpear_esp32_s3_lcd_1_54"
 
@@ -104,6 +105,7 @@ private:
             // 启用保持功能，确保睡眠期间电平不变
             rtc_gpio_hold_en(GPIO_NUM_3);
             esp_lcd_panel_disp_on_off(panel_, false); //关闭显示
+            Settings::Flush();
             esp_deep_sleep_start();
         });
         power_save_timer_->SetEnabled(true);
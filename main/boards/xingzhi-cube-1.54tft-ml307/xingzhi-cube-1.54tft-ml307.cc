@@ -15,6 +15,7 @@
 
 #include <driver/rtc_io.h>
 #include <esp_sleep.h>
+#include "settings.h"
 
 #define TAG "XINGZHI_CUBE_1_54TFT_ML307"
 
@@ -60,6 +61,7 @@ private:
             // 启用保持功能，确保睡眠期间电平不变
             rtc_gpio_hold_en(GPIO_NUM_21);
             esp_lcd_panel_disp_on_off(panel_, false); //关闭显示
+            Settings::Flush();
             esp_deep_sleep_start();
         });
         power_save_timer_->SetEnabled(true);
@@ -0,0 +1,131 @@
+#include "checksum.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <cstring>
+#include <strings.h>
+
+#define TAG "Checksum"
+
+// Buffers smaller than this are not worth the cost of a task switch
+#define PARALLEL_MIN_LENGTH (256 * 1024)
+
+uint32_t Checksum::ByteSum(const void* data, size_t length, uint32_t seed) {
+    auto p = static_cast<const uint8_t*>(data);
+    uint32_t sum = seed;
+
+    // Align to a word boundary
+    while (length > 0 && (reinterpret_cast<uintptr_t>(p) & 3) != 0) {
+        sum += *p++;
+        length--;
+    }
+
+    // Add bytes pairwise into two 16-bit lanes, each word adds at most 2 * 255 per lane,
+    // so the lanes are folded into the sum every 128 words before they can overflow
+    auto words = reinterpret_cast<const uint32_t*>(p);
+    size_t word_count = length / 4;
+    while (word_count > 0) {
+        size_t block = word_count < 128 ? word_count : 128;
+        uint32_t lanes = 0;
+        for (size_t i = 0; i < block; i++) {
+            uint32_t w = words[i];
+            lanes += (w & 0x00FF00FF) + ((w >> 8) & 0x00FF00FF);
+        }
+        sum += (lanes & 0xFFFF) + (lanes >> 16);
+        words += block;
+        word_count -= block;
+    }
+
+    // Trailing bytes
+    p = reinterpret_cast<const uint8_t*>(words);
+    for (size_t i = 0; i < (length & 3); i++) {
+        sum += p[i];
+    }
+    return sum;
+}
+
+#if CONFIG_FREERTOS_NUMBER_OF_CORES > 1
+struct ByteSumJob {
+    const uint8_t* data;
+    size_t length;
+    uint32_t result;
+    SemaphoreHandle_t done;
+};
+
+static void ByteSumTask(void* arg) {
+    auto job = static_cast<ByteSumJob*>(arg);
+    job->result = Checksum::ByteSum(job->data, job->length);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+#endif
+
+uint32_t Checksum::ByteSumParallel(const void* data, size_t length) {
+#if CONFIG_FREERTOS_NUMBER_OF_CORES > 1
+    if (length >= PARALLEL_MIN_LENGTH) {
+        // The second half goes to a helper task on the other core
+        size_t first_half = (length / 2) & ~size_t(3);
+        ByteSumJob job = {
+            .data = static_cast<const uint8_t*>(data) + first_half,
+            .length = length - first_half,
+            .result = 0,
+            .done = xSemaphoreCreateBinary(),
+        };
+        if (job.done != nullptr) {
+            BaseType_t other_core = xPortGetCoreID() == 0 ? 1 : 0;
+            if (xTaskCreatePinnedToCore(ByteSumTask, "byte_sum", 2048, &job, uxTaskPriorityGet(NULL), NULL, other_core) == pdPASS) {
+                uint32_t sum = ByteSum(data, first_half);
+                xSemaphoreTake(job.done, portMAX_DELAY);
+                vSemaphoreDelete(job.done);
+                return sum + job.result;
+            }
+            ESP_LOGW(TAG, "Failed to create byte sum task, falling back to single core");
+            vSemaphoreDelete(job.done);
+        }
+    }
+#endif
+    return ByteSum(data, length);
+}
+
+Sha256::Sha256() {
+    mbedtls_sha256_init(&context_);
+    mbedtls_sha256_starts(&context_, 0);
+}
+
+Sha256::~Sha256() {
+    mbedtls_sha256_free(&context_);
+}
+
+void Sha256::Update(const void* data, size_t length) {
+    mbedtls_sha256_update(&context_, static_cast<const unsigned char*>(data), length);
+}
+
+void Sha256::Finish(uint8_t digest[kDigestSize]) {
+    if (finished_) {
+        ESP_LOGW(TAG, "SHA-256 already finished");
+    }
+    mbedtls_sha256_finish(&context_, digest);
+    finished_ = true;
+}
+
+std::string Sha256::FinishHex() {
+    uint8_t digest[kDigestSize];
+    Finish(digest);
+    return ToHex(digest, sizeof(digest));
+}
+
+std::string Sha256::ToHex(const uint8_t* digest, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    std::string result(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        result[i * 2] = hex[digest[i] >> 4];
+        result[i * 2 + 1] = hex[digest[i] & 0x0F];
+    }
+    return result;
+}
+
+bool Sha256::Matches(const std::string& hex_digest, const std::string& expected) {
+    return expected.empty() || strcasecmp(hex_digest.c_str(), expected.c_str()) == 0;
+}
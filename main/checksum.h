@@ -0,0 +1,41 @@
+#ifndef _CHECKSUM_H_
+#define _CHECKSUM_H_
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include <mbedtls/sha256.h>
+
+class Checksum {
+public:
+    // Sum of all bytes as unsigned values, added to seed. Reads a 32-bit word at a time.
+    static uint32_t ByteSum(const void* data, size_t length, uint32_t seed = 0);
+    // Same as ByteSum, but large buffers are split across both cores on dual-core chips
+    static uint32_t ByteSumParallel(const void* data, size_t length);
+};
+
+// Streaming SHA-256, backed by the SHA peripheral when CONFIG_MBEDTLS_HARDWARE_SHA is enabled
+class Sha256 {
+public:
+    static constexpr size_t kDigestSize = 32;
+
+    Sha256();
+    ~Sha256();
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+
+    void Update(const void* data, size_t length);
+    void Finish(uint8_t digest[kDigestSize]);
+    std::string FinishHex();
+
+    static std::string ToHex(const uint8_t* digest, size_t length);
+    // Compare a hex digest case-insensitively, an empty expected digest always matches
+    static bool Matches(const std::string& hex_digest, const std::string& expected);
+
+private:
+    mbedtls_sha256_context context_;
+    bool finished_ = false;
+};
+
+#endif // _CHECKSUM_H_
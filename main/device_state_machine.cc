@@ -1,4 +1,5 @@
 #include "device_state_machine.h"
+#include "trace.h"
 
 #include <algorithm>
 #include <esp_log.h>
@@ -124,6 +125,10 @@ bool DeviceStateMachine::TransitionTo(DeviceState new_state) {
     current_state_.store(new_state);
     ESP_LOGI(TAG, "State: %s -> %s",
              GetStateName(old_state), GetStateName(new_state));
+    if (old_state != kDeviceStateUnknown) {
+        Trace::End(GetStateName(old_state), Trace::kStateTrack);
+    }
+    Trace::Begin(GetStateName(new_state), Trace::kStateTrack);
 
     // Notify callback
     NotifyStateChange(old_state, new_state);
@@ -25,6 +25,12 @@ private:
     std::string name_;
 };
 
+// What the device is doing, displays use it to decide how often the screen needs refreshing
+enum class DisplayActivity {
+    kActive,    // Listening, speaking, configuring: full refresh rate
+    kIdle,      // Standby: reduced refresh rate
+};
+
 class Display {
 public:
     Display();
@@ -35,11 +41,16 @@ public:
     virtual void ShowNotification(const std::string &notification, int duration_ms = 3000);
     virtual void SetEmotion(const char* emotion);
     virtual void SetChatMessage(const char* role, const char* content);
+    // Append a streamed fragment to the latest message of the same role, by default it replaces the message
+    virtual void AppendChatMessage(const char* role, const char* content);
     virtual void ClearChatMessages();
     virtual void SetTheme(Theme* theme);
     virtual Theme* GetTheme() { return current_theme_; }
     virtual void UpdateStatusBar(bool update_all = false);
     virtual void SetPowerSaveMode(bool on);
+    virtual void SetActivity(DisplayActivity activity) { }
+    // Backlight fully off, nothing drawn can be seen
+    virtual void SetScreenOn(bool on) { }
     virtual void SetupUI() { }
 
     inline int width() const { return width_; }
@@ -11,6 +11,8 @@
 #include <esp_err.h>
 #include <esp_lvgl_port.h>
 #include <esp_psram.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
 #include <cstring>
 #include <src/misc/cache/lv_cache.h>
 
@@ -18,6 +20,12 @@
 
 #define TAG "LcdDisplay"
 
+// SPI panels render in bands. With two bands LVGL renders band N+1 while the SPI DMA sends
+// band N, both bands take at most 1/8 of the free internal DMA capable RAM.
+#define SPI_LCD_MIN_DOUBLE_BUFFER_LINES 10
+#define SPI_LCD_SINGLE_BUFFER_LINES 20
+#define SPI_LCD_MAX_BUFFER_BYTES (48 * 1024)
+
 LV_FONT_DECLARE(BUILTIN_TEXT_FONT);
 LV_FONT_DECLARE(BUILTIN_ICON_FONT);
 LV_FONT_DECLARE(font_awesome_30_4);
@@ -134,12 +142,13 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     lvgl_port_init(&port_cfg);
 
     ESP_LOGI(TAG, "Adding LCD display");
+    ChooseDrawBuffers();
     const lvgl_port_display_cfg_t display_cfg = {
         .io_handle = panel_io_,
         .panel_handle = panel_,
         .control_handle = nullptr,
-        .buffer_size = static_cast<uint32_t>(width_ * 20),
-        .double_buffer = false,
+        .buffer_size = static_cast<uint32_t>(width_ * buffer_lines_),
+        .double_buffer = double_buffered_,
         .trans_size = 0,
         .hres = static_cast<uint32_t>(width_),
         .vres = static_cast<uint32_t>(height_),
@@ -169,8 +178,30 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
     }
+
+    // Draw buffer timings are reported from boot, before the governor starts
+    HookRefreshEvents();
 }
 
+void SpiLcdDisplay::ChooseDrawBuffers() {
+    const uint32_t caps = MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL;
+    size_t line_bytes = width_ * sizeof(uint16_t);
+    size_t budget = std::min<size_t>(heap_caps_get_free_size(caps) / 8, SPI_LCD_MAX_BUFFER_BYTES);
+    // Each band is allocated as a single block
+    size_t lines = std::min(budget / 2, heap_caps_get_largest_free_block(caps)) / line_bytes;
+    lines = std::min<size_t>(lines, height_ / 2);
+
+    if (lines >= SPI_LCD_MIN_DOUBLE_BUFFER_LINES) {
+        double_buffered_ = true;
+        buffer_lines_ = lines;
+    } else {
+        // Not enough DMA RAM for two useful bands, render and send one band at a time
+        double_buffered_ = false;
+        buffer_lines_ = std::min(SPI_LCD_SINGLE_BUFFER_LINES, height_);
+    }
+    ESP_LOGI(TAG, "Draw buffers: %d x %d lines (%u bytes each)", double_buffered_ ? 2 : 1,
+        buffer_lines_, (unsigned)(buffer_lines_ * line_bytes));
+}
 
 // RGB LCD implementation
 RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel,
@@ -291,6 +322,7 @@ LcdDisplay::~LcdDisplay() {
         gif_controller_->Stop();
         gif_controller_.reset();
     }
+    anim_controller_.reset();
     
     if (preview_timer_ != nullptr) {
         esp_timer_stop(preview_timer_);
@@ -466,6 +498,7 @@ void LcdDisplay::SetupUI() {
 
     // We'll create chat messages dynamically in SetChatMessage
     chat_message_label_ = nullptr;
+    chat_slot_pool_.clear();
 
     low_battery_popup_ = lv_obj_create(screen);
     lv_obj_set_scrollbar_mode(low_battery_popup_, LV_SCROLLBAR_MODE_OFF);
@@ -494,196 +527,202 @@ void LcdDisplay::SetupUI() {
 #else
 #define  MAX_MESSAGES 20
 #endif
-void LcdDisplay::SetChatMessage(const char* role, const char* content) {
-    DisplayLockGuard lock(this);
-    if (content_ == nullptr) {
-        return;
+#define CHAT_BUBBLE_MIN_WIDTH 20
+#define CHAT_BUBBLE_MAX_WIDTH (LV_HOR_RES * 85 / 100 - 16)  // 85% of screen width
+
+static const char* GetChatBubbleType(lv_obj_t* obj) {
+    // Text messages are a transparent row holding the bubble, image previews are bare bubbles
+    void* type = lv_obj_get_user_data(obj);
+    if (type != nullptr) {
+        return static_cast<const char*>(type);
     }
-    
-    // Check if message count exceeds limit
-    uint32_t child_count = lv_obj_get_child_cnt(content_);
-    if (child_count >= MAX_MESSAGES) {
-        // Delete the oldest message (first child object)
-        lv_obj_t* first_child = lv_obj_get_child(content_, 0);
-        if (first_child != nullptr) {
-            lv_obj_del(first_child);
-            // Refresh child count after deletion
-            child_count = lv_obj_get_child_cnt(content_);
-        }
-        // Scroll to the last message immediately (get last_child after deletion)
-        if (child_count > 0) {
-            lv_obj_t* last_child = lv_obj_get_child(content_, child_count - 1);
-            if (last_child != nullptr && lv_obj_is_valid(last_child)) {
-                lv_obj_scroll_to_view_recursive(last_child, LV_ANIM_OFF);
-            }
+    if (lv_obj_get_child_cnt(obj) == 0) {
+        return nullptr;
+    }
+    return static_cast<const char*>(lv_obj_get_user_data(lv_obj_get_child(obj, 0)));
+}
+
+static void MeasureChatText(const char* text, const lv_font_t* font, int32_t letter_space,
+                            lv_coord_t& widest, lv_coord_t& last_line) {
+    // The text continues the last line, so only the new characters are measured
+    while (true) {
+        const char* end = strchr(text, '\n');
+        uint32_t length = end != nullptr ? end - text : strlen(text);
+        last_line += lv_text_get_width(text, length, font, letter_space);
+        widest = std::max(widest, last_line);
+        if (end == nullptr) {
+            break;
         }
+        text = end + 1;
+        last_line = 0;
     }
-    
-    // Collapse system messages (if it's a system message, check if the last message is also a system message)
-    if (strcmp(role, "system") == 0) {
-        // Refresh child count to get accurate count after potential deletion above
-        child_count = lv_obj_get_child_cnt(content_);
-        if (child_count > 0) {
-            // Get the last message container
-            lv_obj_t* last_container = lv_obj_get_child(content_, child_count - 1);
-            if (last_container != nullptr && lv_obj_is_valid(last_container) && lv_obj_get_child_cnt(last_container) > 0) {
-                // Get the bubble inside the container
-                lv_obj_t* last_bubble = lv_obj_get_child(last_container, 0);
-                if (last_bubble != nullptr && lv_obj_is_valid(last_bubble)) {
-                    // Check if bubble type is system message
-                    void* bubble_type_ptr = lv_obj_get_user_data(last_bubble);
-                    if (bubble_type_ptr != nullptr && strcmp((const char*)bubble_type_ptr, "system") == 0) {
-                        // If the last message is also a system message, delete it
-                        lv_obj_del(last_container);
-                    }
-                }
-            }
+}
+
+lv_obj_t* LcdDisplay::AcquireChatSlot() {
+    // Pooled rows are hidden at the front of content_, the visible messages follow in order
+    uint32_t visible_count = lv_obj_get_child_cnt(content_) - chat_slot_pool_.size();
+    while (visible_count >= MAX_MESSAGES) {
+        lv_obj_t* oldest = lv_obj_get_child(content_, chat_slot_pool_.size());
+        const char* type = GetChatBubbleType(oldest);
+        if (type == nullptr || strcmp(type, "image") != 0) {
+            // The oldest message row becomes the newest one, no LVGL objects are freed or allocated
+            lv_obj_move_to_index(oldest, -1);
+            return oldest;
         }
-    } else {
-        // Hide the centered AI logo
-        lv_obj_add_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
+        // Image previews own their decoded image, they are not worth keeping around
+        lv_obj_del(oldest);
+        visible_count--;
     }
 
-    // Avoid empty message boxes
-    if(strlen(content) == 0) {
-        return;
+    if (!chat_slot_pool_.empty()) {
+        lv_obj_t* slot = chat_slot_pool_.back();
+        chat_slot_pool_.pop_back();
+        lv_obj_move_to_index(slot, -1);
+        lv_obj_remove_flag(slot, LV_OBJ_FLAG_HIDDEN);
+        return slot;
     }
 
     auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
 
-    // Create a message bubble
-    lv_obj_t* msg_bubble = lv_obj_create(content_);
+    // A full-width transparent row, so the bubble can be aligned left, right or centered
+    lv_obj_t* slot = lv_obj_create(content_);
+    lv_obj_set_width(slot, LV_HOR_RES);
+    lv_obj_set_height(slot, LV_SIZE_CONTENT);
+    lv_obj_set_scrollbar_mode(slot, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_set_style_bg_opa(slot, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(slot, 0, 0);
+    lv_obj_set_style_pad_all(slot, 0, 0);
+
+    lv_obj_t* msg_bubble = lv_obj_create(slot);
     lv_obj_set_style_radius(msg_bubble, 8, 0);
     lv_obj_set_scrollbar_mode(msg_bubble, LV_SCROLLBAR_MODE_OFF);
     lv_obj_set_style_border_width(msg_bubble, 0, 0);
     lv_obj_set_style_pad_all(msg_bubble, lvgl_theme->spacing(4), 0);
+    lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
+    lv_obj_set_size(msg_bubble, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+    lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
 
-    // Create the message text
     lv_obj_t* msg_text = lv_label_create(msg_bubble);
-    lv_label_set_text(msg_text, content);
-    
-    // Calculate bubble width constraints
-    lv_coord_t max_width = LV_HOR_RES * 85 / 100 - 16;  // 85% of screen width
-    lv_coord_t min_width = 20;  
-    
-    // Let LVGL calculate the natural text width first
-    lv_obj_set_width(msg_text, LV_SIZE_CONTENT);
-    lv_obj_update_layout(msg_text);
-    lv_coord_t text_width = lv_obj_get_width(msg_text);
-    
-    // Ensure text width is not less than minimum width
-    if (text_width < min_width) {
-        text_width = min_width;
-    }
-
-    // Constrain to max width
-    lv_coord_t bubble_width = (text_width < max_width) ? text_width : max_width;
-    
-    // Set message text width
-    lv_obj_set_width(msg_text, bubble_width);
     lv_label_set_long_mode(msg_text, LV_LABEL_LONG_WRAP);
+    return slot;
+}
 
-    // Set bubble width
-    lv_obj_set_width(msg_bubble, bubble_width);
-    lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-
-    // Set alignment and style based on message role
-    if (strcmp(role, "user") == 0) {
-        // User messages are right-aligned with green background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->user_bubble_color(), 0);
-        lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->text_color(), 0);
-        
-        // Set custom attribute to mark bubble type
-        lv_obj_set_user_data(msg_bubble, (void*)"user");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "assistant") == 0) {
-        // Assistant messages are left-aligned with white background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->assistant_bubble_color(), 0);
-        lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->text_color(), 0);
-        
-        // Set custom attribute to mark bubble type
-        lv_obj_set_user_data(msg_bubble, (void*)"assistant");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "system") == 0) {
-        // System messages are center-aligned with light gray background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->system_bubble_color(), 0);
-        lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->system_text_color(), 0);
-        
-        // Set custom attribute to mark bubble type
-        lv_obj_set_user_data(msg_bubble, (void*)"system");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
+void LcdDisplay::ReleaseChatSlot(lv_obj_t* slot) {
+    lv_obj_t* msg_text = lv_obj_get_child(lv_obj_get_child(slot, 0), 0);
+    if (msg_text == chat_message_label_) {
+        chat_message_label_ = nullptr;
     }
-    
-    // Create a full-width container for user messages to ensure right alignment
-    if (strcmp(role, "user") == 0) {
-        // Create a full-width container
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        // Make container transparent and borderless
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        // Move the message bubble into this container
-        lv_obj_set_parent(msg_bubble, container);
-        
-        // Right align the bubble in the container
-        lv_obj_align(msg_bubble, LV_ALIGN_RIGHT_MID, -25, 0);
-        
-        // Auto-scroll to this container
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
-    } else if (strcmp(role, "system") == 0) {
-        // Create full-width container for system messages to ensure center alignment
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        lv_obj_set_parent(msg_bubble, container);
-        lv_obj_align(msg_bubble, LV_ALIGN_CENTER, 0, 0);
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
+    // Drop the text buffer, the objects themselves are kept for the next message
+    lv_label_set_text_static(msg_text, "");
+    lv_obj_add_flag(slot, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_move_to_index(slot, 0);
+    chat_slot_pool_.push_back(slot);
+}
+
+void LcdDisplay::SetChatMessage(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (content_ == nullptr) {
+        return;
+    }
+
+    // Collapse system messages: a system message replaces the last message if that is also a system message
+    lv_obj_t* slot = nullptr;
+    bool is_system = strcmp(role, "system") == 0;
+    if (is_system) {
+        lv_obj_t* last_child = lv_obj_get_child(content_, -1);
+        if (last_child != nullptr && !lv_obj_has_flag(last_child, LV_OBJ_FLAG_HIDDEN)) {
+            const char* type = GetChatBubbleType(last_child);
+            if (type != nullptr && strcmp(type, "system") == 0) {
+                slot = last_child;
+            }
+        }
     } else {
-        // For assistant messages
-        // Left align assistant messages
-        lv_obj_align(msg_bubble, LV_ALIGN_LEFT_MID, 0, 0);
+        // Hide the centered AI logo
+        lv_obj_add_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
+    }
 
-        // Auto-scroll to the message bubble
-        lv_obj_scroll_to_view_recursive(msg_bubble, LV_ANIM_ON);
+    // Avoid empty message boxes
+    if (strlen(content) == 0) {
+        if (slot != nullptr) {
+            ReleaseChatSlot(slot);
+        }
+        return;
     }
-    
+
+    if (slot == nullptr) {
+        slot = AcquireChatSlot();
+    }
+    lv_obj_t* msg_bubble = lv_obj_get_child(slot, 0);
+    lv_obj_t* msg_text = lv_obj_get_child(msg_bubble, 0);
+    lv_label_set_text(msg_text, content);
+
+    // Measure the natural text width once from the font metrics, without a layout pass.
+    // The label then keeps this fixed width and only its height is laid out
+    chat_text_width_ = 0;
+    chat_last_line_width_ = 0;
+    MeasureChatText(content, lv_obj_get_style_text_font(msg_text, LV_PART_MAIN),
+        lv_obj_get_style_text_letter_space(msg_text, LV_PART_MAIN), chat_text_width_, chat_last_line_width_);
+    lv_obj_set_width(msg_text, LV_CLAMP(CHAT_BUBBLE_MIN_WIDTH, chat_text_width_, CHAT_BUBBLE_MAX_WIDTH));
+
+    // Restyle only when the recycled bubble had a different role, SetTheme keeps the colors current
+    const char* type = strcmp(role, "user") == 0 ? "user" : (is_system ? "system" : "assistant");
+    const char* old_type = static_cast<const char*>(lv_obj_get_user_data(msg_bubble));
+    if (old_type == nullptr || strcmp(old_type, type) != 0) {
+        auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
+        lv_obj_set_user_data(msg_bubble, (void*)type);
+        if (strcmp(type, "user") == 0) {
+            // User messages are right-aligned
+            lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->user_bubble_color(), 0);
+            lv_obj_set_style_text_color(msg_text, lvgl_theme->text_color(), 0);
+            lv_obj_align(msg_bubble, LV_ALIGN_RIGHT_MID, -25, 0);
+        } else if (strcmp(type, "system") == 0) {
+            // System messages are centered
+            lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->system_bubble_color(), 0);
+            lv_obj_set_style_text_color(msg_text, lvgl_theme->system_text_color(), 0);
+            lv_obj_align(msg_bubble, LV_ALIGN_CENTER, 0, 0);
+        } else {
+            // Assistant messages are left-aligned
+            lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->assistant_bubble_color(), 0);
+            lv_obj_set_style_text_color(msg_text, lvgl_theme->text_color(), 0);
+            lv_obj_align(msg_bubble, LV_ALIGN_LEFT_MID, 0, 0);
+        }
+    }
+
+    // Only the new row needs to be brought into view
+    lv_obj_scroll_to_view(slot, LV_ANIM_ON);
+
     // Store reference to the latest message label
     chat_message_label_ = msg_text;
 }
 
+void LcdDisplay::AppendChatMessage(const char* role, const char* content) {
+    {
+        DisplayLockGuard lock(this);
+        if (content_ == nullptr) {
+            return;
+        }
+
+        // Extend the latest bubble if it is still the last row and has the same role
+        lv_obj_t* slot = chat_message_label_ != nullptr ? lv_obj_get_parent(lv_obj_get_parent(chat_message_label_)) : nullptr;
+        const char* type = slot != nullptr && slot == lv_obj_get_child(content_, -1) ? GetChatBubbleType(slot) : nullptr;
+        if (type != nullptr && strcmp(type, role) == 0) {
+            if (content[0] == '\0') {
+                return;
+            }
+            MeasureChatText(content, lv_obj_get_style_text_font(chat_message_label_, LV_PART_MAIN),
+                lv_obj_get_style_text_letter_space(chat_message_label_, LV_PART_MAIN), chat_text_width_, chat_last_line_width_);
+            lv_coord_t width = LV_CLAMP(CHAT_BUBBLE_MIN_WIDTH, chat_text_width_, CHAT_BUBBLE_MAX_WIDTH);
+            if (width != lv_obj_get_style_width(chat_message_label_, LV_PART_MAIN)) {
+                lv_obj_set_width(chat_message_label_, width);
+            }
+            lv_label_ins_text(chat_message_label_, LV_LABEL_POS_LAST, content);
+            lv_obj_scroll_to_view(slot, LV_ANIM_ON);
+            return;
+        }
+    }
+    SetChatMessage(role, content);
+}
+
 void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     DisplayLockGuard lock(this);
     if (content_ == nullptr) {
@@ -693,7 +732,15 @@ void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     if (image == nullptr) {
         return;
     }
-    
+
+    // Bubbles stay in the chat history, don't pin a borrowed buffer (e.g. a camera frame) that long
+    if (auto shared_image = dynamic_cast<LvglSharedImage*>(image.get())) {
+        image = shared_image->Copy();
+        if (image == nullptr) {
+            return;
+        }
+    }
+
     auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
     // Create a message bubble for image preview
     lv_obj_t* img_bubble = lv_obj_create(content_);
@@ -774,10 +821,20 @@ void LcdDisplay::ClearChatMessages() {
         return;
     }
     
-    // Use lv_obj_clean to delete all children of content_ (chat message bubbles)
-    lv_obj_clean(content_);
-    
-    // Reset chat_message_label_ as it has been deleted
+    // Return the message rows to the pool instead of deleting them, image previews are deleted
+    std::vector<lv_obj_t*> rows;
+    uint32_t child_count = lv_obj_get_child_cnt(content_);
+    for (uint32_t i = chat_slot_pool_.size(); i < child_count; i++) {
+        rows.push_back(lv_obj_get_child(content_, i));
+    }
+    for (auto row : rows) {
+        const char* type = GetChatBubbleType(row);
+        if (type != nullptr && strcmp(type, "image") == 0) {
+            lv_obj_del(row);
+        } else {
+            ReleaseChatSlot(row);
+        }
+    }
     chat_message_label_ = nullptr;
     
     // Show the centered AI logo (emoji_label_) again
@@ -960,8 +1017,13 @@ void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
         lv_obj_remove_flag(emoji_box_, LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(preview_image_, LV_OBJ_FLAG_HIDDEN);
         preview_image_cached_.reset();
-        if (gif_controller_) {
-            gif_controller_->Start();
+        if (!animations_paused_) {
+            if (gif_controller_) {
+                gif_controller_->Start();
+            }
+            if (anim_controller_) {
+                anim_controller_->Start();
+            }
         }
         return;
     }
@@ -978,6 +1040,9 @@ void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     if (gif_controller_) {
         gif_controller_->Stop();
     }
+    if (anim_controller_) {
+        anim_controller_->Stop();
+    }
     lv_obj_add_flag(emoji_box_, LV_OBJ_FLAG_HIDDEN);
     lv_obj_remove_flag(preview_image_, LV_OBJ_FLAG_HIDDEN);
     esp_timer_stop(preview_timer_);
@@ -1002,12 +1067,15 @@ void LcdDisplay::ClearChatMessages() {
 #endif
 
 void LcdDisplay::SetEmotion(const char* emotion) {
+    DisplayLockGuard lock(this);
+    current_emotion_ = emotion;
+
     // Stop any running GIF animation
     if (gif_controller_) {
-        DisplayLockGuard lock(this);
         gif_controller_->Stop();
         gif_controller_.reset();
     }
+    anim_controller_.reset();
     
     if (emoji_image_ == nullptr) {
         return;
@@ -1018,7 +1086,6 @@ void LcdDisplay::SetEmotion(const char* emotion) {
     if (image == nullptr) {
         const char* utf8 = font_awesome_get_utf8(emotion);
         if (utf8 != nullptr && emoji_label_ != nullptr) {
-            DisplayLockGuard lock(this);
             lv_label_set_text(emoji_label_, utf8);
             lv_obj_add_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
             lv_obj_remove_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
@@ -1026,8 +1093,28 @@ void LcdDisplay::SetEmotion(const char* emotion) {
         return;
     }
 
-    DisplayLockGuard lock(this);
-    if (image->IsGif()) {
+    if (image->IsAnimation()) {
+        // Pre-rendered animation, played from the mmapped assets
+        anim_controller_ = std::make_unique<LvglAnimation>(image->image_dsc());
+
+        if (anim_controller_->IsLoaded()) {
+            anim_controller_->SetLoopDelay(3000);
+            anim_controller_->SetFrameCallback([this]() {
+                lv_image_set_src(emoji_image_, anim_controller_->image_dsc());
+            });
+
+            lv_image_set_src(emoji_image_, anim_controller_->image_dsc());
+            if (!animations_paused_) {
+                anim_controller_->Start();
+            }
+
+            lv_obj_add_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_remove_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            ESP_LOGE(TAG, "Failed to load animation for emotion: %s", emotion);
+            anim_controller_.reset();
+        }
+    } else if (image->IsGif()) {
         // Create new GIF controller
         gif_controller_ = std::make_unique<LvglGif>(image->image_dsc());
         
@@ -1041,7 +1128,9 @@ void LcdDisplay::SetEmotion(const char* emotion) {
             
             // Set initial frame and start animation
             lv_image_set_src(emoji_image_, gif_controller_->image_dsc());
-            gif_controller_->Start();
+            if (!animations_paused_) {
+                gif_controller_->Start();
+            }
             
             // Show GIF, hide others
             lv_obj_add_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
@@ -1058,13 +1147,14 @@ void LcdDisplay::SetEmotion(const char* emotion) {
 
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
     // In WeChat message style, if emotion is neutral, don't display it
-    uint32_t child_count = lv_obj_get_child_cnt(content_);
+    uint32_t child_count = lv_obj_get_child_cnt(content_) - chat_slot_pool_.size();
     if (strcmp(emotion, "neutral") == 0 && child_count > 0) {
         // Stop GIF animation if running
         if (gif_controller_) {
             gif_controller_->Stop();
             gif_controller_.reset();
         }
+        anim_controller_.reset();
         
         lv_obj_add_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
@@ -1072,6 +1162,38 @@ void LcdDisplay::SetEmotion(const char* emotion) {
 #endif
 }
 
+void LcdDisplay::ReloadEmotion() {
+    DisplayLockGuard lock(this);
+    if (gif_controller_) {
+        gif_controller_->Stop();
+        gif_controller_.reset();
+    }
+    anim_controller_.reset();
+    if (emoji_image_ == nullptr) {
+        return;
+    }
+    // Drop the old source first, the emotion may have no image in the current theme
+    lv_image_set_src(emoji_image_, nullptr);
+    lv_obj_add_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
+    if (!current_emotion_.empty()) {
+        std::string emotion = current_emotion_;
+        SetEmotion(emotion.c_str());
+    }
+}
+
+void LcdDisplay::PauseAnimations(bool paused) {
+    // The preview image keeps the emoji animations stopped until it is hidden
+    if (preview_image_ != nullptr && !lv_obj_has_flag(preview_image_, LV_OBJ_FLAG_HIDDEN)) {
+        return;
+    }
+    if (gif_controller_) {
+        paused ? gif_controller_->Stop() : gif_controller_->Start();
+    }
+    if (anim_controller_) {
+        paused ? anim_controller_->Stop() : anim_controller_->Start();
+    }
+}
+
 void LcdDisplay::SetTheme(Theme* theme) {
     DisplayLockGuard lock(this);
     
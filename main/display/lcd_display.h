@@ -3,6 +3,7 @@
 
 #include "lvgl_display.h"
 #include "gif/lvgl_gif.h"
+#include "lvgl_animation.h"
 
 #include <esp_lcd_panel_io.h>
 #include <esp_lcd_panel_ops.h>
@@ -10,6 +11,8 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
 
 #define PREVIEW_IMAGE_DURATION_MS 5000
 
@@ -30,13 +33,23 @@ protected:
     lv_obj_t* emoji_label_ = nullptr;
     lv_obj_t* emoji_image_ = nullptr;
     std::unique_ptr<LvglGif> gif_controller_ = nullptr;
+    std::unique_ptr<LvglAnimation> anim_controller_ = nullptr;
+    std::string current_emotion_;
     lv_obj_t* emoji_box_ = nullptr;
     lv_obj_t* chat_message_label_ = nullptr;
     esp_timer_handle_t preview_timer_ = nullptr;
     std::unique_ptr<LvglImage> preview_image_cached_ = nullptr;
     bool hide_subtitle_ = false;  // Control whether to hide chat messages/subtitles
+    // Cleared message rows, kept hidden at the front of content_ and reused by the next messages
+    std::vector<lv_obj_t*> chat_slot_pool_;
+    // Measured widths of the latest message, so appended fragments are measured on their own
+    lv_coord_t chat_text_width_ = 0;
+    lv_coord_t chat_last_line_width_ = 0;
 
     void InitializeLcdThemes();
+    virtual void PauseAnimations(bool paused) override;
+    lv_obj_t* AcquireChatSlot();
+    void ReleaseChatSlot(lv_obj_t* slot);
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
@@ -48,6 +61,9 @@ public:
     ~LcdDisplay();
     virtual void SetEmotion(const char* emotion) override;
     virtual void SetChatMessage(const char* role, const char* content) override;
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    virtual void AppendChatMessage(const char* role, const char* content) override;
+#endif
     virtual void ClearChatMessages() override;
     virtual void SetPreviewImage(std::unique_ptr<LvglImage> image) override;
     virtual void SetupUI() override;
@@ -56,6 +72,10 @@ public:
     
     // Set whether to hide chat messages/subtitles
     void SetHideSubtitle(bool hide);
+
+    // Rebuild the current emoji from the current theme, dropping any image or animation
+    // that still points into assets about to be released
+    void ReloadEmotion();
 };
 
 // SPI LCD display
@@ -64,6 +84,15 @@ public:
     SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel,
                   int width, int height, int offset_x, int offset_y,
                   bool mirror_x, bool mirror_y, bool swap_xy);
+
+    int buffer_lines() const { return buffer_lines_; }
+    bool double_buffered() const { return double_buffered_; }
+
+private:
+    int buffer_lines_ = 0;
+    bool double_buffered_ = false;
+
+    void ChooseDrawBuffers();
 };
 
 // RGB LCD display
@@ -1,16 +1,181 @@
 #include "lvgl_gif.h"
 #include <esp_log.h>
+#include <esp_heap_caps.h>
 #include <cstring>
+#include <vector>
+#include <list>
 
 #define TAG "LvglGif"
 
+struct GifFrame {
+    uint8_t* pixels;    // RGB565, followed by an A8 plane if has_alpha, in PSRAM
+    uint32_t delay_ms;
+    bool has_alpha;
+};
+
+struct GifFrames {
+    uint16_t width = 0;
+    uint16_t height = 0;
+    int32_t loop_count = -1;
+    size_t bytes = 0;
+    std::vector<GifFrame> frames;
+
+    ~GifFrames() {
+        for (auto& frame : frames) {
+            heap_caps_free(frame.pixels);
+        }
+    }
+};
+
+#if CONFIG_GIF_FRAME_CACHE_SIZE > 0 && CONFIG_SPIRAM
+#define GIF_FRAME_CACHE_ENABLED 1
+// The cache takes at most 1/GIF_FRAME_CACHE_MAX_FREE_SHARE of the PSRAM free when it is first used
+#define GIF_FRAME_CACHE_MAX_FREE_SHARE 4
+
+namespace {
+
+// Assets are only unmapped after ClearFrameCache, so an address and size always name the same GIF
+struct GifFrameKey {
+    const void* data;
+    size_t size;
+
+    bool operator==(const GifFrameKey& other) const {
+        return data == other.data && size == other.size;
+    }
+};
+
+/**
+ * LRU cache of decoded GIFs. Entries are shared, so a GIF evicted while still being
+ * played stays alive until its player is destroyed. Only used from the LVGL task
+ * (under the display lock), so no locking is needed.
+ */
+class GifFrameCache {
+public:
+    static GifFrameCache& GetInstance() {
+        static GifFrameCache instance;
+        return instance;
+    }
+
+    size_t budget() const { return budget_; }
+
+    std::shared_ptr<GifFrames> Get(const GifFrameKey& key) {
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->first == key) {
+                entries_.splice(entries_.begin(), entries_, it);
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    void Put(const GifFrameKey& key, std::shared_ptr<GifFrames> frames) {
+        if (frames->bytes > budget_) {
+            return;
+        }
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->first == key) {
+                used_ -= it->second->bytes;
+                entries_.erase(it);
+                break;
+            }
+        }
+        while (!entries_.empty() && used_ + frames->bytes > budget_) {
+            used_ -= entries_.back().second->bytes;
+            ESP_LOGD(TAG, "Evict decoded GIF %p", entries_.back().first.data);
+            entries_.pop_back();
+        }
+        used_ += frames->bytes;
+        entries_.emplace_front(key, std::move(frames));
+    }
+
+    void Clear() {
+        entries_.clear();
+        used_ = 0;
+    }
+
+private:
+    std::list<std::pair<GifFrameKey, std::shared_ptr<GifFrames>>> entries_;
+    size_t used_ = 0;
+    size_t budget_;
+
+    GifFrameCache() {
+        budget_ = CONFIG_GIF_FRAME_CACHE_SIZE * 1024;
+        size_t free_share = heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / GIF_FRAME_CACHE_MAX_FREE_SHARE;
+        if (budget_ > free_share) {
+            ESP_LOGW(TAG, "GIF frame cache limited to %u KB by free PSRAM", (unsigned)(free_share / 1024));
+            budget_ = free_share;
+        }
+    }
+};
+
+// Convert the decoder canvas (ARGB8888) to RGB565, adding an A8 plane only if the frame has transparency
+uint8_t* ConvertFrame(const uint8_t* canvas, size_t pixels, bool& has_alpha, size_t& size) {
+    has_alpha = false;
+    for (size_t i = 0; i < pixels; i++) {
+        if (canvas[i * 4 + 3] != 0xFF) {
+            has_alpha = true;
+            break;
+        }
+    }
+
+    size = pixels * (has_alpha ? 3 : 2);
+    auto buffer = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    auto color = reinterpret_cast<uint16_t*>(buffer);
+    uint8_t* alpha = buffer + pixels * 2;
+    for (size_t i = 0; i < pixels; i++) {
+        const uint8_t* px = canvas + i * 4;
+        color[i] = ((px[2] & 0xF8) << 8) | ((px[1] & 0xFC) << 3) | (px[0] >> 3);
+        if (has_alpha) {
+            alpha[i] = px[3];
+        }
+    }
+    return buffer;
+}
+
+} // namespace
+#endif // CONFIG_GIF_FRAME_CACHE_SIZE > 0 && CONFIG_SPIRAM
+
+void LvglGif::ClearFrameCache() {
+#if GIF_FRAME_CACHE_ENABLED
+    GifFrameCache::GetInstance().Clear();
+#endif
+}
+
 LvglGif::LvglGif(const lv_img_dsc_t* img_dsc)
-    : gif_(nullptr), timer_(nullptr), last_call_(0), playing_(false), loaded_(false),
+    : gif_(nullptr), source_(nullptr), frame_index_(0), loop_count_(-1),
+      timer_(nullptr), last_call_(0), playing_(false), loaded_(false),
       loop_delay_ms_(0), loop_waiting_(false), loop_wait_start_(0) {
     if (!img_dsc || !img_dsc->data) {
         ESP_LOGE(TAG, "Invalid image descriptor");
         return;
     }
+    source_ = img_dsc->data;
+#if GIF_FRAME_CACHE_ENABLED
+    source_size_ = img_dsc->data_size;
+#endif
+
+    // Setup LVGL image descriptor
+    memset(&img_dsc_, 0, sizeof(img_dsc_));
+    img_dsc_.header.magic = LV_IMAGE_HEADER_MAGIC;
+    img_dsc_.header.flags = LV_IMAGE_FLAGS_MODIFIABLE;
+    img_dsc_.header.cf = LV_COLOR_FORMAT_ARGB8888;
+
+#if GIF_FRAME_CACHE_ENABLED
+    frames_ = GifFrameCache::GetInstance().Get({source_, source_size_});
+    if (frames_) {
+        img_dsc_.header.w = frames_->width;
+        img_dsc_.header.h = frames_->height;
+        loop_count_ = frames_->loop_count;
+        ShowCachedFrame(0);
+        loaded_ = true;
+        ESP_LOGD(TAG, "GIF loaded from frame cache: %dx%d, %u frames",
+            frames_->width, frames_->height, (unsigned)frames_->frames.size());
+        return;
+    }
+#endif
 
     gif_ = gd_open_gif_data(img_dsc->data);
     if (!gif_) {
@@ -18,17 +183,18 @@ LvglGif::LvglGif(const lv_img_dsc_t* img_dsc)
         return;
     }
 
-    // Setup LVGL image descriptor
-    memset(&img_dsc_, 0, sizeof(img_dsc_));
-    img_dsc_.header.magic = LV_IMAGE_HEADER_MAGIC;
-    img_dsc_.header.flags = LV_IMAGE_FLAGS_MODIFIABLE;
-    img_dsc_.header.cf = LV_COLOR_FORMAT_ARGB8888;
     img_dsc_.header.w = gif_->width;
     img_dsc_.header.h = gif_->height;
     img_dsc_.header.stride = gif_->width * 4;
     img_dsc_.data = gif_->canvas;
     img_dsc_.data_size = gif_->width * gif_->height * 4;
 
+#if GIF_FRAME_CACHE_ENABLED
+    recording_ = std::make_shared<GifFrames>();
+    recording_->width = gif_->width;
+    recording_->height = gif_->height;
+#endif
+
     // Render first frame
     if (gif_->canvas) {
         gd_render_frame(gif_, gif_->canvas);
@@ -53,7 +219,7 @@ const lv_img_dsc_t* LvglGif::image_dsc() const {
 
 // Animation control methods
 void LvglGif::Start() {
-    if (!loaded_ || !gif_) {
+    if (!loaded_) {
         ESP_LOGW(TAG, "GIF not loaded, cannot start");
         return;
     }
@@ -88,7 +254,7 @@ void LvglGif::Pause() {
 }
 
 void LvglGif::Resume() {
-    if (!loaded_ || !gif_) {
+    if (!loaded_) {
         ESP_LOGW(TAG, "GIF not loaded, cannot resume");
         return;
     }
@@ -109,8 +275,15 @@ void LvglGif::Stop() {
     // Reset loop waiting state
     loop_waiting_ = false;
 
-    if (gif_) {
+    if (frames_) {
+        // Same loop semantics as gd_rewind
+        loop_count_ = -1;
+        ShowCachedFrame(0);
+        ESP_LOGD(TAG, "GIF animation stopped and rewound");
+    } else if (gif_) {
         gd_rewind(gif_);
+        // The recording only holds a consecutive run of frames, start over
+        recording_.reset();
         // Render first frame without advancing
         if (gif_->canvas) {
             gd_render_frame(gif_, gif_->canvas);
@@ -128,18 +301,22 @@ bool LvglGif::IsLoaded() const {
 }
 
 int32_t LvglGif::GetLoopCount() const {
-    if (!loaded_ || !gif_) {
+    if (!loaded_) {
         return -1;
     }
-    return gif_->loop_count;
+    return gif_ ? gif_->loop_count : loop_count_;
 }
 
 void LvglGif::SetLoopCount(int32_t count) {
-    if (!loaded_ || !gif_) {
+    if (!loaded_) {
         ESP_LOGW(TAG, "GIF not loaded, cannot set loop count");
         return;
     }
-    gif_->loop_count = count;
+    if (gif_) {
+        gif_->loop_count = count;
+    } else {
+        loop_count_ = count;
+    }
 }
 
 uint32_t LvglGif::GetLoopDelay() const {
@@ -152,17 +329,17 @@ void LvglGif::SetLoopDelay(uint32_t delay_ms) {
 }
 
 uint16_t LvglGif::width() const {
-    if (!loaded_ || !gif_) {
+    if (!loaded_) {
         return 0;
     }
-    return gif_->width;
+    return img_dsc_.header.w;
 }
 
 uint16_t LvglGif::height() const {
-    if (!loaded_ || !gif_) {
+    if (!loaded_) {
         return 0;
     }
-    return gif_->height;
+    return img_dsc_.header.h;
 }
 
 void LvglGif::SetFrameCallback(std::function<void()> callback) {
@@ -170,7 +347,7 @@ void LvglGif::SetFrameCallback(std::function<void()> callback) {
 }
 
 void LvglGif::NextFrame() {
-    if (!loaded_ || !gif_ || !playing_) {
+    if (!loaded_ || !playing_) {
         return;
     }
 
@@ -188,19 +365,25 @@ void LvglGif::NextFrame() {
 
     // Check if enough time has passed for the next frame
     uint32_t elapsed = lv_tick_elaps(last_call_);
-    if (elapsed < gif_->gce.delay * 10) {
+    if (elapsed < CurrentFrameDelay()) {
         return;
     }
 
     last_call_ = lv_tick_get();
 
+    if (frames_) {
+        NextCachedFrame();
+        return;
+    }
+
     // Save file position before getting next frame to detect loop
     uint32_t pos_before = gif_->f_rw_p;
 
     // Get next frame
     int has_next = gd_get_frame(gif_);
     if (has_next == 0) {
-        // Animation truly finished (non-infinite loop)
+        // Animation truly finished (non-infinite loop), every frame has been seen
+        FinishRecording(false);
         playing_ = false;
         if (timer_) {
             lv_timer_pause(timer_);
@@ -209,9 +392,30 @@ void LvglGif::NextFrame() {
         return;
     }
 
+    if (has_next < 0) {
+        recording_.reset();
+    }
+
     // Detect loop by checking if file position jumped back (rewound to start)
     // This works for looping GIFs regardless of when loop_count is set
-    if (loop_delay_ms_ > 0 && gif_->f_rw_p < pos_before) {
+    bool looped = gif_->f_rw_p < pos_before;
+    if (looped && recording_) {
+        // The first loop is recorded, drop the decoder and replay the frames from now on
+        FinishRecording(true);
+        if (frames_) {
+            frame_index_ = SIZE_MAX;
+            if (loop_delay_ms_ > 0) {
+                loop_waiting_ = true;
+                loop_wait_start_ = lv_tick_get();
+                ESP_LOGD(TAG, "GIF completed one cycle, waiting %lu ms before next loop", loop_delay_ms_);
+            } else {
+                NextCachedFrame();
+            }
+            return;
+        }
+    }
+
+    if (loop_delay_ms_ > 0 && looped) {
         // File position decreased, meaning GIF looped back to beginning
         // Start waiting before rendering this frame
         loop_waiting_ = true;
@@ -223,6 +427,7 @@ void LvglGif::NextFrame() {
     // Render current frame
     if (gif_->canvas) {
         gd_render_frame(gif_, gif_->canvas);
+        RecordFrame();
         
         // Call frame callback if set
         if (frame_callback_) {
@@ -231,6 +436,115 @@ void LvglGif::NextFrame() {
     }
 }
 
+void LvglGif::NextCachedFrame() {
+    // frame_index_ is SIZE_MAX right after a loop wait, so the next frame is the first one
+    size_t next = frame_index_ + 1;
+    if (next >= frames_->frames.size()) {
+        // Same loop semantics as gd_get_frame
+        if (loop_count_ == 1 || loop_count_ < 0) {
+            playing_ = false;
+            if (timer_) {
+                lv_timer_pause(timer_);
+            }
+            ESP_LOGD(TAG, "GIF animation completed");
+            return;
+        } else if (loop_count_ > 1) {
+            loop_count_--;
+        }
+
+        if (loop_delay_ms_ > 0) {
+            frame_index_ = SIZE_MAX;
+            loop_waiting_ = true;
+            loop_wait_start_ = lv_tick_get();
+            ESP_LOGD(TAG, "GIF completed one cycle, waiting %lu ms before next loop", loop_delay_ms_);
+            return;
+        }
+        next = 0;
+    }
+
+    ShowCachedFrame(next);
+    if (frame_callback_) {
+        frame_callback_();
+    }
+}
+
+uint32_t LvglGif::CurrentFrameDelay() const {
+    if (frames_) {
+        return frame_index_ < frames_->frames.size() ? frames_->frames[frame_index_].delay_ms : 0;
+    }
+    return gif_->gce.delay * 10;
+}
+
+void LvglGif::RecordFrame() {
+#if GIF_FRAME_CACHE_ENABLED
+    if (!recording_) {
+        return;
+    }
+
+    // The smallest a frame can be, checked before converting it
+    size_t pixel_count = gif_->width * gif_->height;
+    size_t budget = GifFrameCache::GetInstance().budget();
+    if (recording_->bytes + pixel_count * 2 > budget) {
+        ESP_LOGD(TAG, "GIF is larger than the frame cache, not caching");
+        recording_.reset();
+        return;
+    }
+
+    bool has_alpha;
+    size_t size;
+    auto pixels = ConvertFrame(gif_->canvas, pixel_count, has_alpha, size);
+    if (pixels == nullptr) {
+        ESP_LOGW(TAG, "Failed to allocate %u bytes for GIF frame cache", (unsigned)(pixel_count * 3));
+        recording_.reset();
+        return;
+    }
+    if (recording_->frames.empty()) {
+        // The loop extension precedes the first image, keep the count before any loop consumes it
+        recording_->loop_count = gif_->loop_count;
+    }
+    recording_->frames.push_back({pixels, (uint32_t)gif_->gce.delay * 10, has_alpha});
+    recording_->bytes += size;
+    if (recording_->bytes > budget) {
+        ESP_LOGD(TAG, "GIF is larger than the frame cache, not caching");
+        recording_.reset();
+    }
+#endif
+}
+
+void LvglGif::FinishRecording(bool switch_to_frames) {
+#if GIF_FRAME_CACHE_ENABLED
+    if (!recording_ || recording_->frames.empty()) {
+        recording_.reset();
+        return;
+    }
+
+    GifFrameCache::GetInstance().Put({source_, source_size_}, recording_);
+    ESP_LOGD(TAG, "Cached %u decoded GIF frames (%u KB)",
+        (unsigned)recording_->frames.size(), (unsigned)(recording_->bytes / 1024));
+
+    if (switch_to_frames) {
+        frames_ = std::move(recording_);
+        loop_count_ = gif_->loop_count;
+        gd_close_gif(gif_);
+        gif_ = nullptr;
+        ShowCachedFrame(frames_->frames.size() - 1);
+    }
+    recording_.reset();
+#endif
+}
+
+void LvglGif::ShowCachedFrame(size_t index) {
+    frame_index_ = index;
+    auto& frame = frames_->frames[index];
+    size_t pixel_count = frames_->width * frames_->height;
+    img_dsc_.header.cf = frame.has_alpha ? LV_COLOR_FORMAT_RGB565A8 : LV_COLOR_FORMAT_RGB565;
+    img_dsc_.header.stride = frames_->width * 2;
+    img_dsc_.data_size = pixel_count * (frame.has_alpha ? 3 : 2);
+    img_dsc_.data = frame.pixels;
+    // LVGL may cache decoded images by descriptor, the pixels just moved
+    lv_image_cache_drop(&img_dsc_);
+}
+
 void LvglGif::Cleanup() {
     // Stop and delete timer
     if (timer_) {
@@ -243,6 +557,8 @@ void LvglGif::Cleanup() {
         gd_close_gif(gif_);
         gif_ = nullptr;
     }
+    frames_.reset();
+    recording_.reset();
 
     playing_ = false;
     loaded_ = false;
@@ -6,15 +6,29 @@
 #include <memory>
 #include <functional>
 
+// Fully decoded frames of one GIF, shared between the frame cache and players
+struct GifFrames;
+
 /**
  * C++ implementation of LVGL GIF widget
  * Provides GIF animation functionality using gifdec library
+ *
+ * With CONFIG_GIF_FRAME_CACHE_SIZE > 0 the frames rendered during the first loop are
+ * kept in PSRAM as RGB565 (RGB565A8 for frames with transparency), keyed by the GIF
+ * data pointer and size. Later loops and later players of the same GIF
+ * only swap the image data pointer and never touch the decoder.
  */
 class LvglGif {
 public:
     explicit LvglGif(const lv_img_dsc_t* img_dsc);
     virtual ~LvglGif();
 
+    /**
+     * Drop all cached GIF frames, called when the assets they were decoded from go away.
+     * Must be called with the display lock held.
+     */
+    static void ClearFrameCache();
+
     // LvglImage interface implementation
     virtual const lv_img_dsc_t* image_dsc() const;
 
@@ -81,8 +95,18 @@ public:
     void SetFrameCallback(std::function<void()> callback);
 
 private:
-    // GIF decoder instance
+    // GIF decoder instance, nullptr while playing from decoded frames
     gd_GIF* gif_;
+
+    // GIF source data, its address and size form the frame cache key
+    const void* source_;
+    size_t source_size_ = 0;
+
+    // Decoded frames being played, and frames being recorded during the first loop
+    std::shared_ptr<GifFrames> frames_;
+    std::shared_ptr<GifFrames> recording_;
+    size_t frame_index_;
+    int32_t loop_count_;
     
     // LVGL image descriptor
     lv_img_dsc_t img_dsc_;
@@ -109,6 +133,31 @@ private:
      * Update to next frame
      */
     void NextFrame();
+
+    /**
+     * Advance to the next decoded frame (frame cache playback)
+     */
+    void NextCachedFrame();
+
+    /**
+     * Delay of the frame currently shown, in milliseconds
+     */
+    uint32_t CurrentFrameDelay() const;
+
+    /**
+     * Copy the frame just rendered by the decoder into the recording
+     */
+    void RecordFrame();
+
+    /**
+     * Publish the recorded frames to the cache and play from them
+     */
+    void FinishRecording(bool switch_to_frames);
+
+    /**
+     * Point the image descriptor at a decoded frame
+     */
+    void ShowCachedFrame(size_t index);
     
     /**
      * Cleanup resources
@@ -0,0 +1,351 @@
+#include "image_kernels.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "esp_imgfx_color_convert.h"
+#include "esp_imgfx_rotate.h"
+
+#define TAG "image_kernels"
+
+// 一个 32 位字内两个 16 位像素同时交换字节
+static inline uint32_t swap_bytes16x2(uint32_t v) {
+    return ((v & 0x00FF00FFu) << 8) | ((v >> 8) & 0x00FF00FFu);
+}
+
+void image_swap_bytes16(void* dst, const void* src, size_t count) {
+    uint16_t* d16 = (uint16_t*)dst;
+    const uint16_t* s16 = (const uint16_t*)src;
+
+    // 源与目标的 4 字节对齐偏移一致时才能按字处理，先处理掉开头不对齐的一个像素
+    if ((((uintptr_t)d16 ^ (uintptr_t)s16) & 3) == 0) {
+        if (((uintptr_t)d16 & 3) != 0 && count > 0) {
+            *d16++ = __builtin_bswap16(*s16++);
+            count--;
+        }
+        uint32_t* d32 = (uint32_t*)d16;
+        const uint32_t* s32 = (const uint32_t*)s16;
+        size_t words = count / 2;
+        size_t i = 0;
+        for (; i + 4 <= words; i += 4) {
+            uint32_t a = s32[i + 0];
+            uint32_t b = s32[i + 1];
+            uint32_t c = s32[i + 2];
+            uint32_t e = s32[i + 3];
+            d32[i + 0] = swap_bytes16x2(a);
+            d32[i + 1] = swap_bytes16x2(b);
+            d32[i + 2] = swap_bytes16x2(c);
+            d32[i + 3] = swap_bytes16x2(e);
+        }
+        for (; i < words; i++) {
+            d32[i] = swap_bytes16x2(s32[i]);
+        }
+        d16 += words * 2;
+        s16 += words * 2;
+        count -= words * 2;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        d16[i] = __builtin_bswap16(s16[i]);
+    }
+}
+
+void image_yuv422p_to_yuyv(uint8_t* dst, const uint8_t* src, uint16_t width, uint16_t height) {
+    const uint8_t* y_plane = src;
+    const uint8_t* u_plane = y_plane + (size_t)width * height;
+    const uint8_t* v_plane = u_plane + (size_t)(width / 2) * height;
+    size_t pairs = (size_t)(width / 2) * height;
+
+    if (((uintptr_t)dst & 3) == 0) {
+        // 每两个像素正好组成一个字：Y0 Cb Y1 Cr（小端）
+        uint32_t* d32 = (uint32_t*)dst;
+        for (size_t i = 0; i < pairs; i++) {
+            d32[i] = (uint32_t)y_plane[2 * i] | ((uint32_t)u_plane[i] << 8) | ((uint32_t)y_plane[2 * i + 1] << 16) |
+                     ((uint32_t)v_plane[i] << 24);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < pairs; i++) {
+        dst[4 * i + 0] = y_plane[2 * i];
+        dst[4 * i + 1] = u_plane[i];
+        dst[4 * i + 2] = y_plane[2 * i + 1];
+        dst[4 * i + 3] = v_plane[i];
+    }
+}
+
+static esp_imgfx_pixel_fmt_t to_imgfx_format(v4l2_pix_fmt_t format) {
+    switch (format) {
+        case V4L2_PIX_FMT_RGB565:
+            return ESP_IMGFX_PIXEL_FMT_RGB565_LE;
+        case V4L2_PIX_FMT_RGB565X:
+            return ESP_IMGFX_PIXEL_FMT_RGB565_BE;
+        case V4L2_PIX_FMT_RGB24:
+            return ESP_IMGFX_PIXEL_FMT_RGB888;
+        case V4L2_PIX_FMT_YUYV:
+            return ESP_IMGFX_PIXEL_FMT_YUYV;
+        case V4L2_PIX_FMT_GREY:
+            return ESP_IMGFX_PIXEL_FMT_Y;
+        default:
+            // 其余格式的 esp_imgfx 编码与 V4L2 FourCC 相同
+            return static_cast<esp_imgfx_pixel_fmt_t>(format);
+    }
+}
+
+bool image_convert(uint8_t* dst, size_t dst_len, v4l2_pix_fmt_t dst_fmt, const uint8_t* src, size_t src_len,
+                   v4l2_pix_fmt_t src_fmt, uint16_t width, uint16_t height) {
+    if (src_fmt == dst_fmt) {
+        if (dst_len < src_len) {
+            return false;
+        }
+        memcpy(dst, src, src_len);
+        return true;
+    }
+    if ((src_fmt == V4L2_PIX_FMT_RGB565 && dst_fmt == V4L2_PIX_FMT_RGB565X) ||
+        (src_fmt == V4L2_PIX_FMT_RGB565X && dst_fmt == V4L2_PIX_FMT_RGB565) ||
+        (src_fmt == V4L2_PIX_FMT_UYVY && dst_fmt == V4L2_PIX_FMT_YUYV)) {
+        if (dst_len < src_len) {
+            return false;
+        }
+        image_swap_bytes16(dst, src, src_len / 2);
+        return true;
+    }
+
+    esp_imgfx_color_convert_cfg_t convert_cfg = {
+        .in_res = {.width = static_cast<int16_t>(width), .height = static_cast<int16_t>(height)},
+        .in_pixel_fmt = to_imgfx_format(src_fmt),
+        .out_pixel_fmt = to_imgfx_format(dst_fmt),
+        .color_space_std = ESP_IMGFX_COLOR_SPACE_STD_BT601,
+    };
+    esp_imgfx_color_convert_handle_t convert_handle = nullptr;
+    esp_imgfx_err_t err = esp_imgfx_color_convert_open(&convert_cfg, &convert_handle);
+    if (err != ESP_IMGFX_ERR_OK || convert_handle == nullptr) {
+        ESP_LOGE(TAG, "esp_imgfx_color_convert_open failed: 0x%08" PRIx32 " -> 0x%08" PRIx32, src_fmt, dst_fmt);
+        return false;
+    }
+    esp_imgfx_data_t convert_input_data = {
+        .data = const_cast<uint8_t*>(src),
+        .data_len = static_cast<uint32_t>(src_len),
+    };
+    esp_imgfx_data_t convert_output_data = {
+        .data = dst,
+        .data_len = static_cast<uint32_t>(dst_len),
+    };
+    err = esp_imgfx_color_convert_process(convert_handle, &convert_input_data, &convert_output_data);
+    esp_imgfx_color_convert_close(convert_handle);
+    if (err != ESP_IMGFX_ERR_OK) {
+        ESP_LOGE(TAG, "esp_imgfx_color_convert_process failed");
+        return false;
+    }
+    return true;
+}
+
+// 以像素中心对齐的源坐标（16.16 定点），缩放前后图像的边缘对齐
+static inline int32_t source_coord(int dst_pos, int32_t step) {
+    return (int32_t)(((int64_t)dst_pos * step) + step / 2 - 0x8000);
+}
+
+void image_scale_nearest(uint8_t* dst, uint16_t dst_w, uint16_t dst_h, size_t dst_stride, const uint8_t* src,
+                         uint16_t src_w, uint16_t src_h, size_t src_stride, int bpp) {
+    if (dst_w == 0 || dst_h == 0 || src_w == 0 || src_h == 0) {
+        return;
+    }
+
+    // 每列的源像素偏移只算一次，逐行复用
+    uint32_t* x_offsets = (uint32_t*)heap_caps_malloc(dst_w * sizeof(uint32_t), MALLOC_CAP_8BIT);
+    if (x_offsets == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate scale table");
+        return;
+    }
+    int32_t x_step = (int32_t)(((uint32_t)src_w << 16) / dst_w);
+    int32_t y_step = (int32_t)(((uint32_t)src_h << 16) / dst_h);
+    for (int x = 0; x < dst_w; x++) {
+        int32_t sx = (source_coord(x, x_step) + 0x8000) >> 16;
+        sx = sx < 0 ? 0 : (sx >= src_w ? src_w - 1 : sx);
+        x_offsets[x] = (uint32_t)sx * bpp;
+    }
+
+    int32_t last_sy = -1;
+    for (int y = 0; y < dst_h; y++) {
+        int32_t sy = (source_coord(y, y_step) + 0x8000) >> 16;
+        sy = sy < 0 ? 0 : (sy >= src_h ? src_h - 1 : sy);
+        uint8_t* d = dst + (size_t)y * dst_stride;
+        if (sy == last_sy) {
+            // 放大时相邻目标行来自同一源行
+            memcpy(d, d - dst_stride, (size_t)dst_w * bpp);
+            continue;
+        }
+        last_sy = sy;
+
+        const uint8_t* s = src + (size_t)sy * src_stride;
+        switch (bpp) {
+            case 1:
+                for (int x = 0; x < dst_w; x++) {
+                    d[x] = s[x_offsets[x]];
+                }
+                break;
+            case 2: {
+                uint16_t* d16 = (uint16_t*)d;
+                for (int x = 0; x < dst_w; x++) {
+                    d16[x] = *(const uint16_t*)(s + x_offsets[x]);
+                }
+                break;
+            }
+            default:
+                for (int x = 0; x < dst_w; x++) {
+                    memcpy(d + x * bpp, s + x_offsets[x], bpp);
+                }
+                break;
+        }
+    }
+    heap_caps_free(x_offsets);
+}
+
+// RGB565 展开为 0x07E0F81F 形式：G 放到高半字，R/B 留在低半字，各分量之间留出 5 位空隙，
+// 一次乘法即可同时完成三个分量的加权（权重 0..32）
+static inline uint32_t expand_rgb565(uint16_t c) {
+    return ((uint32_t)c | ((uint32_t)c << 16)) & 0x07E0F81Fu;
+}
+
+static inline uint16_t pack_rgb565(uint32_t v) {
+    return (uint16_t)((v & 0xF81Fu) | ((v >> 16) & 0x07E0u));
+}
+
+static inline uint32_t blend_rgb565(uint32_t a, uint32_t b, uint32_t w) {
+    return ((a * (32 - w) + b * w) >> 5) & 0x07E0F81Fu;
+}
+
+struct bilinear_tap {
+    uint16_t x0;
+    uint16_t x1;
+    uint16_t w;  // 0..256
+};
+
+static inline void bilinear_position(int dst_pos, int32_t step, uint16_t src_size, uint16_t* p0, uint16_t* p1,
+                                     uint16_t* w) {
+    int32_t s = source_coord(dst_pos, step);
+    if (s < 0) {
+        s = 0;
+    }
+    int32_t i = s >> 16;
+    if (i >= src_size - 1) {
+        *p0 = *p1 = src_size - 1;
+        *w = 0;
+        return;
+    }
+    *p0 = (uint16_t)i;
+    *p1 = (uint16_t)(i + 1);
+    *w = (uint16_t)((s >> 8) & 0xFF);
+}
+
+bool image_scale_bilinear(uint8_t* dst, uint16_t dst_w, uint16_t dst_h, size_t dst_stride, const uint8_t* src,
+                          uint16_t src_w, uint16_t src_h, size_t src_stride, v4l2_pix_fmt_t format) {
+    int bpp;
+    switch (format) {
+        case V4L2_PIX_FMT_GREY:
+            bpp = 1;
+            break;
+        case V4L2_PIX_FMT_RGB565:
+            bpp = 2;
+            break;
+        case V4L2_PIX_FMT_RGB24:
+            bpp = 3;
+            break;
+        default:
+            ESP_LOGE(TAG, "unsupported format for bilinear scale: 0x%08" PRIx32, format);
+            return false;
+    }
+    if (dst_w == 0 || dst_h == 0 || src_w == 0 || src_h == 0) {
+        return true;
+    }
+
+    auto taps = (bilinear_tap*)heap_caps_malloc(dst_w * sizeof(bilinear_tap), MALLOC_CAP_8BIT);
+    if (taps == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate scale table");
+        return false;
+    }
+    int32_t x_step = (int32_t)(((uint32_t)src_w << 16) / dst_w);
+    int32_t y_step = (int32_t)(((uint32_t)src_h << 16) / dst_h);
+    for (int x = 0; x < dst_w; x++) {
+        bilinear_position(x, x_step, src_w, &taps[x].x0, &taps[x].x1, &taps[x].w);
+    }
+
+    for (int y = 0; y < dst_h; y++) {
+        uint16_t y0, y1, wy;
+        bilinear_position(y, y_step, src_h, &y0, &y1, &wy);
+        const uint8_t* r0 = src + (size_t)y0 * src_stride;
+        const uint8_t* r1 = src + (size_t)y1 * src_stride;
+        uint8_t* d = dst + (size_t)y * dst_stride;
+
+        if (bpp == 2) {
+            const uint16_t* s0 = (const uint16_t*)r0;
+            const uint16_t* s1 = (const uint16_t*)r1;
+            uint16_t* d16 = (uint16_t*)d;
+            uint32_t wy5 = (wy + 4) >> 3;
+            for (int x = 0; x < dst_w; x++) {
+                const bilinear_tap& t = taps[x];
+                uint32_t wx5 = (t.w + 4) >> 3;
+                uint32_t top = blend_rgb565(expand_rgb565(s0[t.x0]), expand_rgb565(s0[t.x1]), wx5);
+                uint32_t bottom = blend_rgb565(expand_rgb565(s1[t.x0]), expand_rgb565(s1[t.x1]), wx5);
+                d16[x] = pack_rgb565(blend_rgb565(top, bottom, wy5));
+            }
+            continue;
+        }
+
+        for (int x = 0; x < dst_w; x++) {
+            const bilinear_tap& t = taps[x];
+            const uint8_t* p00 = r0 + t.x0 * bpp;
+            const uint8_t* p01 = r0 + t.x1 * bpp;
+            const uint8_t* p10 = r1 + t.x0 * bpp;
+            const uint8_t* p11 = r1 + t.x1 * bpp;
+            for (int c = 0; c < bpp; c++) {
+                uint32_t top = p00[c] * (256u - t.w) + p01[c] * t.w;
+                uint32_t bottom = p10[c] * (256u - t.w) + p11[c] * t.w;
+                d[x * bpp + c] = (uint8_t)((top * (256u - wy) + bottom * wy + 0x8000u) >> 16);
+            }
+        }
+    }
+    heap_caps_free(taps);
+    return true;
+}
+
+bool image_rotate(uint8_t* dst, const uint8_t* src, size_t src_len, uint16_t width, uint16_t height,
+                  v4l2_pix_fmt_t format, int degree) {
+    if (degree != 90 && degree != 180 && degree != 270) {
+        ESP_LOGE(TAG, "unsupported rotation: %d", degree);
+        return false;
+    }
+    if (format != V4L2_PIX_FMT_RGB565 && format != V4L2_PIX_FMT_RGB24 && format != V4L2_PIX_FMT_GREY) {
+        ESP_LOGE(TAG, "unsupported format for rotation: 0x%08" PRIx32, format);
+        return false;
+    }
+
+    esp_imgfx_rotate_cfg_t rotate_cfg = {
+        .in_res = {.width = static_cast<int16_t>(width), .height = static_cast<int16_t>(height)},
+    };
+    rotate_cfg.in_pixel_fmt = to_imgfx_format(format);
+    rotate_cfg.degree = degree;
+    esp_imgfx_rotate_handle_t rotate_handle = nullptr;
+    esp_imgfx_err_t err = esp_imgfx_rotate_open(&rotate_cfg, &rotate_handle);
+    if (err != ESP_IMGFX_ERR_OK || rotate_handle == nullptr) {
+        ESP_LOGE(TAG, "esp_imgfx_rotate_open failed");
+        return false;
+    }
+    esp_imgfx_data_t rotate_input_data = {
+        .data = const_cast<uint8_t*>(src),
+        .data_len = static_cast<uint32_t>(src_len),
+    };
+    esp_imgfx_data_t rotate_output_data = {
+        .data = dst,
+        .data_len = static_cast<uint32_t>(src_len),
+    };
+    err = esp_imgfx_rotate_process(rotate_handle, &rotate_input_data, &rotate_output_data);
+    esp_imgfx_rotate_close(rotate_handle);
+    if (err != ESP_IMGFX_ERR_OK) {
+        ESP_LOGE(TAG, "esp_imgfx_rotate_process failed");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,111 @@
+// image_kernels.h - 摄像头预览、截图与 JPEG 编码共用的像素处理函数
+// 字节交换与缩放按 32 位字处理（一次两个 RGB565 像素）；
+// 颜色转换与旋转交给 esp_imgfx，其在 ESP32-S3 / ESP32-P4 上有 SIMD 优化实现
+#pragma once
+#include "sdkconfig.h"
+#ifndef CONFIG_IDF_TARGET_ESP32
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "image_to_jpeg.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief 交换每个 16 位像素的高低字节
+     *
+     * 用于 RGB565 <-> RGB565X、UYVY <-> YUYV 等转换，dst 可以等于 src（原地交换）。
+     *
+     * @param dst       目标缓冲区
+     * @param src       源缓冲区
+     * @param count     16 位像素个数
+     */
+    void image_swap_bytes16(void *dst, const void *src, size_t count);
+
+    /**
+     * @brief YUV422 平面格式重排为 YUYV
+     *
+     * @param dst       目标缓冲区 (width * height * 2)
+     * @param src       源图像，Y、U、V 三个平面依次存放
+     * @param width     图像宽度（偶数）
+     * @param height    图像高度
+     */
+    void image_yuv422p_to_yuyv(uint8_t *dst, const uint8_t *src, uint16_t width, uint16_t height);
+
+    /**
+     * @brief 颜色格式转换
+     *
+     * 支持 esp_imgfx 能处理的组合，如 RGB565/RGB565X/RGB24/YUYV/YUV420/GREY 之间的转换。
+     * 输出 RGB565 时为小端（LVGL 原生格式）。
+     *
+     * @param dst       目标缓冲区
+     * @param dst_len   目标缓冲区长度
+     * @param dst_fmt   目标格式
+     * @param src       源图像
+     * @param src_len   源图像长度
+     * @param src_fmt   源图像格式
+     * @param width     图像宽度
+     * @param height    图像高度
+     *
+     * @return true 成功, false 不支持的格式或转换失败
+     */
+    bool image_convert(uint8_t *dst, size_t dst_len, v4l2_pix_fmt_t dst_fmt, const uint8_t *src, size_t src_len,
+                       v4l2_pix_fmt_t src_fmt, uint16_t width, uint16_t height);
+
+    /**
+     * @brief 最近邻缩放
+     *
+     * 源图像可以是更大图像中的一块区域（src 指向区域起点，src_stride 为原图行字节数），
+     * 因此同时可用于裁剪。
+     *
+     * @param dst        目标图像
+     * @param dst_w      目标宽度
+     * @param dst_h      目标高度
+     * @param dst_stride 目标行字节数
+     * @param src        源图像
+     * @param src_w      源宽度
+     * @param src_h      源高度
+     * @param src_stride 源行字节数
+     * @param bpp        每像素字节数 (1, 2, 3；YUYV 按两像素一组传 4，宽度减半)
+     */
+    void image_scale_nearest(uint8_t *dst, uint16_t dst_w, uint16_t dst_h, size_t dst_stride, const uint8_t *src,
+                             uint16_t src_w, uint16_t src_h, size_t src_stride, int bpp);
+
+    /**
+     * @brief 双线性缩放
+     *
+     * 参数同 image_scale_nearest，支持的格式为 GREY、RGB565（小端）与 RGB24。
+     *
+     * @return true 成功, false 不支持的格式
+     */
+    bool image_scale_bilinear(uint8_t *dst, uint16_t dst_w, uint16_t dst_h, size_t dst_stride, const uint8_t *src,
+                              uint16_t src_w, uint16_t src_h, size_t src_stride, v4l2_pix_fmt_t format);
+
+    /**
+     * @brief 顺时针旋转 90 / 180 / 270 度
+     *
+     * 旋转 90 / 270 度时目标图像宽高与源图像互换。
+     *
+     * @param dst       目标缓冲区（与源图像等长，不能与 src 重叠）
+     * @param src       源图像
+     * @param src_len   源图像长度
+     * @param width     源图像宽度
+     * @param height    源图像高度
+     * @param format    图像格式 (RGB565, RGB24, GREY)
+     * @param degree    旋转角度
+     *
+     * @return true 成功, false 不支持的格式或角度
+     */
+    bool image_rotate(uint8_t *dst, const uint8_t *src, size_t src_len, uint16_t width, uint16_t height,
+                      v4l2_pix_fmt_t format, int degree);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ndef CONFIG_IDF_TARGET_ESP32
@@ -1,9 +1,11 @@
 #include <esp_attr.h>
 #include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <string.h>
-#include <utility>
+
+#include <mutex>
 
 #include "esp_jpeg_common.h"
 #include "esp_jpeg_enc.h"
@@ -13,6 +15,7 @@
 #include "driver/jpeg_encode.h"
 #endif
 #include "image_to_jpeg.h"
+#include "image_kernels.h"
 
 #define TAG "image_to_jpeg"
 
@@ -27,14 +30,6 @@ static void* malloc_psram(size_t size) {
 #endif
 }
 
-static __always_inline uint8_t expand_5_to_8(uint8_t v) {
-    return (uint8_t)((v << 3) | (v >> 2));
-}
-
-static __always_inline uint8_t expand_6_to_8(uint8_t v) {
-    return (uint8_t)((v << 2) | (v >> 4));
-}
-
 static uint8_t* convert_input_to_encoder_buf(const uint8_t* src, uint16_t width, uint16_t height, v4l2_pix_fmt_t format,
                                              jpeg_pixel_format_t* out_fmt, int* out_size) {
     // GRAY 直接作为 JPEG_PIXEL_FORMAT_GRAY 输入
@@ -69,20 +64,11 @@ static uint8_t* convert_input_to_encoder_buf(const uint8_t* src, uint16_t width,
     // 当前版本暂时不会出现 UYVY 格式
     if (format == V4L2_PIX_FMT_UYVY) [[unlikely]] {
         int sz = (int)width * (int)height * 2;
-        const uint8_t* s = src;
         uint8_t* buf = (uint8_t*)jpeg_calloc_align(sz, 16);
         if (!buf)
             return NULL;
-        uint8_t* d = buf;
-        for (int i = 0; i < sz; i += 4) {
-            // src: Cb, Y0, Cr, Y1 -> dst: Y0, Cb, Y1, Cr
-            d[0] = s[1];
-            d[1] = s[0];
-            d[2] = s[3];
-            d[3] = s[2];
-            s += 4;
-            d += 4;
-        }
+        // src: Cb, Y0, Cr, Y1 -> dst: Y0, Cb, Y1, Cr，即逐 16 位交换字节
+        image_swap_bytes16(buf, src, sz / 2);
         if (out_fmt)
             *out_fmt = JPEG_PIXEL_FORMAT_YCbYCr;
         if (out_size)
@@ -94,29 +80,10 @@ static uint8_t* convert_input_to_encoder_buf(const uint8_t* src, uint16_t width,
     // 当前版本暂时不会出现 YUV422P 格式
     if (format == V4L2_PIX_FMT_YUV422P) [[unlikely]] {
         int sz = (int)width * (int)height * 2;
-        const uint8_t* y_plane = src;
-        const uint8_t* u_plane = y_plane + (int)width * (int)height;
-        const uint8_t* v_plane = u_plane + ((int)width / 2) * (int)height;
         uint8_t* buf = (uint8_t*)jpeg_calloc_align(sz, 16);
         if (!buf)
             return NULL;
-        uint8_t* dst = buf;
-        for (int y = 0; y < height; y++) {
-            const uint8_t* y_row = y_plane + y * (int)width;
-            const uint8_t* u_row = u_plane + y * ((int)width / 2);
-            const uint8_t* v_row = v_plane + y * ((int)width / 2);
-            for (int x = 0; x < width; x += 2) {
-                uint8_t y0 = y_row[x + 0];
-                uint8_t y1 = y_row[x + 1];
-                uint8_t cb = u_row[x / 2];
-                uint8_t cr = v_row[x / 2];
-                dst[0] = y0;
-                dst[1] = cb;
-                dst[2] = y1;
-                dst[3] = cr;
-                dst += 4;
-            }
-        }
+        image_yuv422p_to_yuyv(buf, src, width, height);
         if (out_fmt)
             *out_fmt = JPEG_PIXEL_FORMAT_YCbYCr;
         if (out_size)
@@ -127,73 +94,35 @@ static uint8_t* convert_input_to_encoder_buf(const uint8_t* src, uint16_t width,
     // RGB 转换为 YUV422 (YCbYCr) 再输入
     // 见 https://github.com/78/xiaozhi-esp32/issues/1380#issuecomment-3497156378
     else if (format == V4L2_PIX_FMT_RGB24 || format == V4L2_PIX_FMT_RGB565 || format == V4L2_PIX_FMT_RGB565X) {
-        esp_imgfx_pixel_fmt_t in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB888;
-        uint32_t src_len = 0;
-        switch (format) {
-            case V4L2_PIX_FMT_RGB24:
-                in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB888;
-                src_len = static_cast<uint32_t>(width * height * 3);
-                break;
-            case V4L2_PIX_FMT_RGB565:
-                in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB565_LE;
-                src_len = static_cast<uint32_t>(width * height * 2);
-                break;
-            [[unlikely]] case V4L2_PIX_FMT_RGB565X: // 当前版本暂时不会出现 RGB565X
-                in_pixel_fmt = ESP_IMGFX_PIXEL_FMT_RGB565_BE;
-                src_len = static_cast<uint32_t>(width * height * 2);
-                break;
-            [[unlikely]] default:
-                ESP_LOGE(TAG, "[Unreachable Case] unsupported format: 0x%08lx", format);
-                std::unreachable();
-        }
+        size_t src_len = (size_t)width * height * (format == V4L2_PIX_FMT_RGB24 ? 3 : 2);
         int sz = (int)width * (int)height * 2;
         uint8_t* buf = (uint8_t*)jpeg_calloc_align(sz, 16);
         if (!buf)
             return nullptr;
-        esp_imgfx_color_convert_cfg_t convert_cfg = {
-            .in_res = {.width = static_cast<int16_t>(width),
-                        .height = static_cast<int16_t>(height)},
-            .in_pixel_fmt = in_pixel_fmt,
-            .out_pixel_fmt = ESP_IMGFX_PIXEL_FMT_YUYV,
-            .color_space_std = ESP_IMGFX_COLOR_SPACE_STD_BT601,
-        };
-        esp_imgfx_color_convert_handle_t convert_handle = nullptr;
-        esp_imgfx_err_t err = esp_imgfx_color_convert_open(&convert_cfg, &convert_handle);
-        if (err != ESP_IMGFX_ERR_OK || convert_handle == nullptr) {
-            ESP_LOGE(TAG, "esp_imgfx_color_convert_open failed");
+        if (!image_convert(buf, sz, V4L2_PIX_FMT_YUYV, src, src_len, format, width, height)) {
             jpeg_free_align(buf);
             return nullptr;
         }
-        esp_imgfx_data_t convert_input_data = {
-            .data = const_cast<uint8_t*>(src),
-            .data_len = static_cast<uint32_t>(src_len),
-        };
-        esp_imgfx_data_t convert_output_data = {
-            .data = buf,
-            .data_len = static_cast<uint32_t>(sz),
-        };
-        err = esp_imgfx_color_convert_process(convert_handle, &convert_input_data, &convert_output_data);
-        if (err != ESP_IMGFX_ERR_OK) {
-            ESP_LOGE(TAG, "esp_imgfx_color_convert_process failed");
-            jpeg_free_align(buf);
-            return nullptr;
-        }
-        esp_imgfx_color_convert_close(convert_handle);
-        convert_handle = nullptr;
         if (out_fmt)
             *out_fmt = JPEG_PIXEL_FORMAT_YCbYCr;
         if (out_size)
             *out_size = sz;
         return buf;
     }
-    ESP_LOGE(TAG, "unsupported format: 0x%08lx", format);
+    ESP_LOGE(TAG, "unsupported format: 0x%08" PRIx32, format);
     if (out_size)
         *out_size = 0;
     return nullptr;
 }
 
 #if CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
+// 硬件编码器引擎与 DMA 输入/输出缓冲区在多次调用间复用，缓冲区只增不减
+static std::mutex s_hw_jpeg_mutex;
 static jpeg_encoder_handle_t s_hw_jpeg_handle = NULL;
+static uint8_t* s_hw_jpeg_in = NULL;
+static size_t s_hw_jpeg_in_cap = 0;
+static uint8_t* s_hw_jpeg_out = NULL;
+static size_t s_hw_jpeg_out_cap = 0;
 
 static bool hw_jpeg_ensure_inited(void) {
     if (s_hw_jpeg_handle) {
@@ -212,90 +141,106 @@ static bool hw_jpeg_ensure_inited(void) {
     return true;
 }
 
-static uint8_t* convert_input_to_hw_encoder_buf(const uint8_t* src, uint16_t width, uint16_t height, v4l2_pix_fmt_t format,
-                                                jpeg_enc_input_format_t* out_fmt, int* out_size) {
-    if (format == V4L2_PIX_FMT_GREY) {
-        int sz = (int)width * (int)height;
-        uint8_t* buf = (uint8_t*)malloc_psram(sz);
-        if (!buf)
-            return NULL;
-        memcpy(buf, src, sz);
-        if (out_fmt)
-            *out_fmt = JPEG_ENCODE_IN_FORMAT_GRAY;
-        if (out_size)
-            *out_size = sz;
-        return buf;
+// 确保复用缓冲区至少有 size 字节，不足时重新分配
+static bool hw_jpeg_ensure_buffer(uint8_t** buf, size_t* cap, size_t size, jpeg_enc_buffer_alloc_direction_t direction) {
+    if (*buf && *cap >= size) {
+        return true;
     }
-
-    if (format == V4L2_PIX_FMT_RGB24) {
-        int sz = (int)width * (int)height * 3;
-        uint8_t* buf = (uint8_t*)malloc_psram(sz);
-        if (!buf) {
-            ESP_LOGE(TAG, "malloc_psram failed");
-            return NULL;
-        }
-        memcpy(buf, src, sz);
-        if (out_fmt)
-            *out_fmt = JPEG_ENCODE_IN_FORMAT_RGB888;
-        if (out_size)
-            *out_size = sz;
-        return buf;
+    if (*buf) {
+        free(*buf);
+        *buf = NULL;
+        *cap = 0;
     }
-
-    if (format == V4L2_PIX_FMT_RGB565) {
-        int sz = (int)width * (int)height * 2;
-        uint8_t* buf = (uint8_t*)malloc_psram(sz);
-        if (!buf)
-            return NULL;
-        memcpy(buf, src, sz);
-        if (out_fmt)
-            *out_fmt = JPEG_ENCODE_IN_FORMAT_RGB565;
-        if (out_size)
-            *out_size = sz;
-        return buf;
+    jpeg_encode_memory_alloc_cfg_t mem_cfg = { .buffer_direction = direction };
+    size_t allocated = 0;
+    *buf = (uint8_t*)jpeg_alloc_encoder_mem(size, &mem_cfg, &allocated);
+    if (!*buf) {
+        ESP_LOGE(TAG, "jpeg_alloc_encoder_mem(%u) failed", (unsigned)size);
+        return false;
     }
+    *cap = allocated;
+    return true;
+}
 
-    if (format == V4L2_PIX_FMT_YUYV) {
-        // 硬件需要 | Y1 V Y0 U | 的“大端”格式，因此需要 bswap16
-        int sz = (int)width * (int)height * 2;
-        uint16_t* buf = (uint16_t*)malloc_psram(sz);
-        if (!buf)
-            return NULL;
-        const uint16_t* bsrc = (const uint16_t*)src;
-        for (int i = 0; i < sz / 2; i++) {
-            buf[i] = __builtin_bswap16(bsrc[i]);
-        }
-        if (out_fmt)
+// 将源图像转换为硬件编码器输入并写入 dst（可以等于 src），返回写入字节数，不支持的格式返回 0
+static size_t convert_input_to_hw_encoder_buf(uint8_t* dst, const uint8_t* src, uint16_t width, uint16_t height,
+                                              v4l2_pix_fmt_t format, jpeg_enc_input_format_t* out_fmt) {
+    size_t pixels = (size_t)width * height;
+    switch (format) {
+        case V4L2_PIX_FMT_GREY:
+            if (dst != src)
+                memcpy(dst, src, pixels);
+            *out_fmt = JPEG_ENCODE_IN_FORMAT_GRAY;
+            return pixels;
+        case V4L2_PIX_FMT_RGB24:
+            if (dst != src)
+                memcpy(dst, src, pixels * 3);
+            *out_fmt = JPEG_ENCODE_IN_FORMAT_RGB888;
+            return pixels * 3;
+        case V4L2_PIX_FMT_RGB565:
+            if (dst != src)
+                memcpy(dst, src, pixels * 2);
+            *out_fmt = JPEG_ENCODE_IN_FORMAT_RGB565;
+            return pixels * 2;
+        case V4L2_PIX_FMT_RGB565X:
+            // 与 RGB565 字节序相反，交换后按 RGB565 输入
+            image_swap_bytes16((uint16_t*)dst, src, pixels);
+            *out_fmt = JPEG_ENCODE_IN_FORMAT_RGB565;
+            return pixels * 2;
+        case V4L2_PIX_FMT_YUYV:
+            // 硬件需要 | Y1 V Y0 U | 的“大端”格式，因此需要 bswap16
+            image_swap_bytes16((uint16_t*)dst, src, pixels);
             *out_fmt = JPEG_ENCODE_IN_FORMAT_YUV422;
-        if (out_size)
-            *out_size = sz;
-        return (uint8_t*)buf;
+            return pixels * 2;
+        default:
+            return 0;
     }
+}
 
-    return NULL;
+static int hw_format_bytes_per_pixel(v4l2_pix_fmt_t format) {
+    switch (format) {
+        case V4L2_PIX_FMT_GREY:
+            return 1;
+        case V4L2_PIX_FMT_RGB565:
+        case V4L2_PIX_FMT_RGB565X:
+        case V4L2_PIX_FMT_YUYV:
+            return 2;
+        case V4L2_PIX_FMT_RGB24:
+            return 3;
+        default:
+            return 0;
+    }
 }
 
-static bool encode_with_hw_jpeg(const uint8_t* src, size_t src_len, uint16_t width, uint16_t height,
-                                v4l2_pix_fmt_t format, uint8_t quality, uint8_t** jpg_out, size_t* jpg_out_len,
-                                jpg_out_cb cb, void* cb_arg) {
+// 调用者需持有 s_hw_jpeg_mutex。编码结果直接留在输出缓冲区中，缓冲区从缓存中借出给调用者
+// （jpg_out/jpg_out_cap），这样回调可以在释放锁之后调用，慢速的上传不会阻塞其他编码，也无需复制结果
+static bool encode_with_hw_jpeg_locked(const uint8_t* src, uint16_t width, uint16_t height, v4l2_pix_fmt_t format,
+                                       uint8_t quality, uint8_t** jpg_out, size_t* jpg_out_len, size_t* jpg_out_cap) {
     if (quality < 1)
         quality = 1;
     if (quality > 100)
         quality = 100;
 
-    jpeg_enc_input_format_t enc_src_type = JPEG_ENCODE_IN_FORMAT_RGB888;
-    int enc_in_size = 0;
-    uint8_t* enc_in = convert_input_to_hw_encoder_buf(src, width, height, format, &enc_src_type, &enc_in_size);
-    if (!enc_in) {
+    int bpp = hw_format_bytes_per_pixel(format);
+    if (bpp == 0) {
         ESP_LOGW(TAG, "hw jpeg: unsupported format, fallback to sw");
         return false;
     }
 
-    if (!hw_jpeg_ensure_inited()) {
-        free(enc_in);
+    size_t in_size = (size_t)width * height * bpp;
+    size_t out_cap = (size_t)width * (size_t)height * 3 / 2 + 64 * 1024;
+    if (out_cap < 128 * 1024)
+        out_cap = 128 * 1024;
+
+    if (!hw_jpeg_ensure_inited() ||
+        !hw_jpeg_ensure_buffer(&s_hw_jpeg_in, &s_hw_jpeg_in_cap, in_size, JPEG_ENC_ALLOC_INPUT_BUFFER) ||
+        !hw_jpeg_ensure_buffer(&s_hw_jpeg_out, &s_hw_jpeg_out_cap, out_cap, JPEG_ENC_ALLOC_OUTPUT_BUFFER)) {
         return false;
     }
 
+    jpeg_enc_input_format_t enc_src_type = JPEG_ENCODE_IN_FORMAT_RGB888;
+    convert_input_to_hw_encoder_buf(s_hw_jpeg_in, src, width, height, format, &enc_src_type);
+
     jpeg_encode_cfg_t enc_cfg = {0};
     enc_cfg.width = width;
     enc_cfg.height = height;
@@ -303,50 +248,116 @@ static bool encode_with_hw_jpeg(const uint8_t* src, size_t src_len, uint16_t wid
     enc_cfg.image_quality = quality;
     enc_cfg.sub_sample = (enc_src_type == JPEG_ENCODE_IN_FORMAT_GRAY) ? JPEG_DOWN_SAMPLING_GRAY : JPEG_DOWN_SAMPLING_YUV422;
 
-    size_t out_cap = (size_t)width * (size_t)height * 3 / 2 + 64 * 1024;
-    if (out_cap < 128 * 1024)
-        out_cap = 128 * 1024;
-    jpeg_encode_memory_alloc_cfg_t jpeg_enc_output_mem_cfg = { .buffer_direction = JPEG_ENC_ALLOC_OUTPUT_BUFFER };
-    size_t out_cap_aligned = 0;
-    uint8_t* outbuf = (uint8_t*)jpeg_alloc_encoder_mem(out_cap, &jpeg_enc_output_mem_cfg, &out_cap_aligned);
-    if (!outbuf) {
-        free(enc_in);
-        ESP_LOGE(TAG, "alloc out buffer failed");
+    uint32_t out_len = 0;
+    esp_err_t er = jpeg_encoder_process(s_hw_jpeg_handle, &enc_cfg, s_hw_jpeg_in, (uint32_t)in_size, s_hw_jpeg_out,
+                                        (uint32_t)s_hw_jpeg_out_cap, &out_len);
+    if (er != ESP_OK) {
+        ESP_LOGE(TAG, "jpeg_encoder_process failed: %d", (int)er);
         return false;
     }
 
-    uint32_t out_len = 0;
-    esp_err_t er = jpeg_encoder_process(s_hw_jpeg_handle, &enc_cfg, enc_in, (uint32_t)enc_in_size, outbuf, (uint32_t)out_cap_aligned, &out_len);
-    free(enc_in);
+    // 借出输出缓冲区，用完后由 hw_jpeg_return_output 放回缓存
+    *jpg_out = s_hw_jpeg_out;
+    *jpg_out_len = (size_t)out_len;
+    *jpg_out_cap = s_hw_jpeg_out_cap;
+    s_hw_jpeg_out = NULL;
+    s_hw_jpeg_out_cap = 0;
+    return true;
+}
 
-    if (er != ESP_OK) {
+// 把借出的输出缓冲区放回缓存；借出期间其他编码已经分配了新的缓冲区时直接释放
+static void hw_jpeg_return_output(uint8_t* outbuf, size_t out_cap) {
+    std::lock_guard<std::mutex> lock(s_hw_jpeg_mutex);
+    if (s_hw_jpeg_out == NULL) {
+        s_hw_jpeg_out = outbuf;
+        s_hw_jpeg_out_cap = out_cap;
+    } else {
         free(outbuf);
-        ESP_LOGE(TAG, "jpeg_encoder_process failed: %d", (int)er);
-        return false;
     }
+}
 
+// 在锁外把编码结果交给回调后归还输出缓冲区，或者把缓冲区直接交给调用者
+static bool emit_hw_jpeg(uint8_t* outbuf, size_t out_len, size_t out_cap, uint8_t** jpg_out, size_t* jpg_out_len,
+                         jpg_out_cb cb, void* cb_arg) {
     if (cb) {
-        cb(cb_arg, 0, outbuf, (size_t)out_len);
+        cb(cb_arg, 0, outbuf, out_len);
         cb(cb_arg, 1, NULL, 0);
-        free(outbuf);
+        hw_jpeg_return_output(outbuf, out_cap);
         if (jpg_out)
             *jpg_out = NULL;
         if (jpg_out_len)
             *jpg_out_len = 0;
         return true;
     }
-
     if (jpg_out && jpg_out_len) {
+        // 调用者用 free() 释放，下次编码会重新分配输出缓冲区
         *jpg_out = outbuf;
-        *jpg_out_len = (size_t)out_len;
+        *jpg_out_len = out_len;
         return true;
     }
-
-    free(outbuf);
+    hw_jpeg_return_output(outbuf, out_cap);
     return true;
 }
+
+static bool encode_with_hw_jpeg(const uint8_t* src, size_t src_len, uint16_t width, uint16_t height,
+                                v4l2_pix_fmt_t format, uint8_t quality, uint8_t** jpg_out, size_t* jpg_out_len,
+                                jpg_out_cb cb, void* cb_arg) {
+    uint8_t* outbuf = NULL;
+    size_t out_len = 0;
+    size_t out_cap = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_hw_jpeg_mutex);
+        if (!encode_with_hw_jpeg_locked(src, width, height, format, quality, &outbuf, &out_len, &out_cap)) {
+            return false;
+        }
+    }
+    return emit_hw_jpeg(outbuf, out_len, out_cap, jpg_out, jpg_out_len, cb, cb_arg);
+}
 #endif // CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
 
+// 软件编码器句柄缓存：句柄内含按质量生成的量化表和霍夫曼表，参数不变时直接复用，
+// 避免每次编码都重新分配和初始化。取出期间缓存为空，并发调用会各自打开新句柄。
+static std::mutex s_sw_jpeg_mutex;
+static jpeg_enc_handle_t s_sw_jpeg_handle = NULL;
+static jpeg_enc_config_t s_sw_jpeg_cfg;
+
+static bool sw_jpeg_cfg_equal(const jpeg_enc_config_t* a, const jpeg_enc_config_t* b) {
+    return a->width == b->width && a->height == b->height && a->src_type == b->src_type &&
+           a->subsampling == b->subsampling && a->quality == b->quality && a->rotate == b->rotate &&
+           a->task_enable == b->task_enable;
+}
+
+static jpeg_error_t sw_jpeg_acquire(jpeg_enc_config_t* cfg, jpeg_enc_handle_t* handle) {
+    jpeg_enc_handle_t stale = NULL;
+    {
+        std::lock_guard<std::mutex> lock(s_sw_jpeg_mutex);
+        if (s_sw_jpeg_handle && sw_jpeg_cfg_equal(&s_sw_jpeg_cfg, cfg)) {
+            *handle = s_sw_jpeg_handle;
+            s_sw_jpeg_handle = NULL;
+            return JPEG_ERR_OK;
+        }
+        stale = s_sw_jpeg_handle;
+        s_sw_jpeg_handle = NULL;
+    }
+    if (stale) {
+        jpeg_enc_close(stale);
+    }
+    return jpeg_enc_open(cfg, handle);
+}
+
+// 编码成功后将句柄放回缓存，失败的句柄状态不确定，直接关闭
+static void sw_jpeg_release(const jpeg_enc_config_t* cfg, jpeg_enc_handle_t handle, bool reusable) {
+    if (reusable) {
+        std::lock_guard<std::mutex> lock(s_sw_jpeg_mutex);
+        if (!s_sw_jpeg_handle) {
+            s_sw_jpeg_handle = handle;
+            s_sw_jpeg_cfg = *cfg;
+            return;
+        }
+    }
+    jpeg_enc_close(handle);
+}
+
 static bool encode_with_esp_new_jpeg(const uint8_t* src, size_t src_len, uint16_t width, uint16_t height,
                                      v4l2_pix_fmt_t format, uint8_t quality, uint8_t** jpg_out, size_t* jpg_out_len,
                                      jpg_out_cb cb, void* cb_arg) {
@@ -373,7 +384,7 @@ static bool encode_with_esp_new_jpeg(const uint8_t* src, size_t src_len, uint16_
     cfg.task_enable = false;
 
     jpeg_enc_handle_t h = NULL;
-    jpeg_error_t ret = jpeg_enc_open(&cfg, &h);
+    jpeg_error_t ret = sw_jpeg_acquire(&cfg, &h);
     if (ret != JPEG_ERR_OK) {
         jpeg_free_align(enc_in);
         ESP_LOGE(TAG, "jpeg_enc_open failed: %d", (int)ret);
@@ -386,7 +397,7 @@ static bool encode_with_esp_new_jpeg(const uint8_t* src, size_t src_len, uint16_
         out_cap = 128 * 1024;
     uint8_t* outbuf = (uint8_t*)malloc_psram(out_cap);
     if (!outbuf) {
-        jpeg_enc_close(h);
+        sw_jpeg_release(&cfg, h, true);
         jpeg_free_align(enc_in);
         ESP_LOGE(TAG, "alloc out buffer failed");
         return false;
@@ -394,7 +405,7 @@ static bool encode_with_esp_new_jpeg(const uint8_t* src, size_t src_len, uint16_
 
     int out_len = 0;
     ret = jpeg_enc_process(h, enc_in, enc_in_size, outbuf, (int)out_cap, &out_len);
-    jpeg_enc_close(h);
+    sw_jpeg_release(&cfg, h, ret == JPEG_ERR_OK);
     jpeg_free_align(enc_in);
 
     if (ret != JPEG_ERR_OK) {
@@ -424,6 +435,203 @@ static bool encode_with_esp_new_jpeg(const uint8_t* src, size_t src_len, uint16_
     return true;
 }
 
+// 行带编码支持的源格式每像素字节数，不支持返回 0
+static int rows_format_bytes_per_pixel(v4l2_pix_fmt_t format) {
+    switch (format) {
+        case V4L2_PIX_FMT_GREY:
+            return 1;
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_RGB565:
+        case V4L2_PIX_FMT_RGB565X:
+            return 2;
+        case V4L2_PIX_FMT_RGB24:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+#if CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
+// 硬件编码器只能整帧编码，先把整帧读入复用的输入缓冲区，再原地转换并编码
+static bool encode_rows_with_hw_jpeg(uint16_t width, uint16_t height, v4l2_pix_fmt_t format, uint8_t quality,
+                                     jpg_rows_cb rows_cb, void* rows_arg, jpg_out_cb cb, void* arg) {
+    size_t size = (size_t)width * height * rows_format_bytes_per_pixel(format);
+    uint8_t* outbuf = NULL;
+    size_t out_len = 0;
+    size_t out_cap = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_hw_jpeg_mutex);
+        if (!hw_jpeg_ensure_buffer(&s_hw_jpeg_in, &s_hw_jpeg_in_cap, size, JPEG_ENC_ALLOC_INPUT_BUFFER)) {
+            ESP_LOGW(TAG, "hw jpeg: no memory for %ux%u frame, fallback to sw", width, height);
+            return false;
+        }
+        if (!rows_cb(rows_arg, 0, height, s_hw_jpeg_in) ||
+            !encode_with_hw_jpeg_locked(s_hw_jpeg_in, width, height, format, quality, &outbuf, &out_len, &out_cap)) {
+            return false;
+        }
+    }
+    return emit_hw_jpeg(outbuf, out_len, out_cap, NULL, NULL, cb, arg);
+}
+#endif // CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
+
+static bool encode_rows_with_esp_new_jpeg(uint16_t width, uint16_t height, v4l2_pix_fmt_t format, uint8_t quality,
+                                          jpg_rows_cb rows_cb, void* rows_arg, jpg_out_cb cb, void* arg) {
+    if (quality < 1)
+        quality = 1;
+    if (quality > 100)
+        quality = 100;
+
+    bool gray = format == V4L2_PIX_FMT_GREY;
+    bool need_convert = format != V4L2_PIX_FMT_GREY && format != V4L2_PIX_FMT_YUYV;
+    int src_bpp = rows_format_bytes_per_pixel(format);
+    int enc_bpp = gray ? 1 : 2;
+
+    jpeg_enc_config_t cfg = DEFAULT_JPEG_ENC_CONFIG();
+    cfg.width = width;
+    cfg.height = height;
+    cfg.src_type = gray ? JPEG_PIXEL_FORMAT_GRAY : JPEG_PIXEL_FORMAT_YCbYCr;
+    cfg.subsampling = gray ? JPEG_SUBSAMPLE_GRAY : JPEG_SUBSAMPLE_420;
+    cfg.quality = quality;
+    cfg.rotate = JPEG_ROTATE_0D;
+    cfg.task_enable = false;
+
+    jpeg_enc_handle_t h = NULL;
+    jpeg_error_t ret = jpeg_enc_open(&cfg, &h);
+    if (ret != JPEG_ERR_OK) {
+        ESP_LOGE(TAG, "jpeg_enc_open failed: %d", (int)ret);
+        return false;
+    }
+
+    // 每次编码一个 MCU 行带（YUV420 为 16 行）
+    int block_size = 0;
+    ret = jpeg_enc_get_block_size(h, &block_size);
+    int block_rows = block_size / ((int)width * enc_bpp);
+    if (ret != JPEG_ERR_OK || block_rows <= 0) {
+        ESP_LOGE(TAG, "jpeg_enc_get_block_size failed: %d", (int)ret);
+        jpeg_enc_close(h);
+        return false;
+    }
+
+    // 单个行带的压缩数据一般远小于原始数据，按两倍加文件头预留
+    int out_cap = block_size * 2 + 2048;
+    size_t row_bytes = (size_t)width * src_bpp;
+    uint8_t* block = (uint8_t*)jpeg_calloc_align(block_size, 16);
+    uint8_t* rows = need_convert ? (uint8_t*)jpeg_calloc_align(row_bytes * block_rows, 16) : block;
+    uint8_t* outbuf = (uint8_t*)malloc_psram(out_cap);
+    esp_imgfx_color_convert_handle_t convert_handle = nullptr;
+    bool ok = block != nullptr && rows != nullptr && outbuf != nullptr;
+    if (!ok) {
+        ESP_LOGE(TAG, "alloc block buffers failed");
+    }
+
+    if (ok && need_convert) {
+        esp_imgfx_color_convert_cfg_t convert_cfg = {
+            .in_res = {.width = static_cast<int16_t>(width),
+                        .height = static_cast<int16_t>(block_rows)},
+            .in_pixel_fmt = format == V4L2_PIX_FMT_RGB24 ? ESP_IMGFX_PIXEL_FMT_RGB888 :
+                            format == V4L2_PIX_FMT_RGB565X ? ESP_IMGFX_PIXEL_FMT_RGB565_BE : ESP_IMGFX_PIXEL_FMT_RGB565_LE,
+            .out_pixel_fmt = ESP_IMGFX_PIXEL_FMT_YUYV,
+            .color_space_std = ESP_IMGFX_COLOR_SPACE_STD_BT601,
+        };
+        if (esp_imgfx_color_convert_open(&convert_cfg, &convert_handle) != ESP_IMGFX_ERR_OK || convert_handle == nullptr) {
+            ESP_LOGE(TAG, "esp_imgfx_color_convert_open failed");
+            ok = false;
+        }
+    }
+
+    for (int y = 0; ok && y < height; y += block_rows) {
+        int n = (height - y < block_rows) ? height - y : block_rows;
+        if (!rows_cb(rows_arg, (uint16_t)y, (uint16_t)n, rows)) {
+            ESP_LOGW(TAG, "rows callback aborted at row %d", y);
+            ok = false;
+            break;
+        }
+        // 最后一个行带不足时重复最后一行补齐
+        for (int r = n; r < block_rows; r++) {
+            memcpy(rows + r * row_bytes, rows + (n - 1) * row_bytes, row_bytes);
+        }
+        if (need_convert) {
+            esp_imgfx_data_t convert_input_data = {
+                .data = rows,
+                .data_len = static_cast<uint32_t>(row_bytes * block_rows),
+            };
+            esp_imgfx_data_t convert_output_data = {
+                .data = block,
+                .data_len = static_cast<uint32_t>(block_size),
+            };
+            if (esp_imgfx_color_convert_process(convert_handle, &convert_input_data, &convert_output_data) != ESP_IMGFX_ERR_OK) {
+                ESP_LOGE(TAG, "esp_imgfx_color_convert_process failed");
+                ok = false;
+                break;
+            }
+        }
+        int out_len = 0;
+        ret = jpeg_enc_process_with_block(h, block, block_size, outbuf, out_cap, &out_len);
+        if (ret < JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "jpeg_enc_process_with_block failed: %d", (int)ret);
+            ok = false;
+            break;
+        }
+        if (out_len > 0) {
+            cb(arg, 0, outbuf, (size_t)out_len);
+        }
+    }
+
+    if (ok) {
+        cb(arg, 1, NULL, 0);  // 结束信号
+    }
+    if (convert_handle) {
+        esp_imgfx_color_convert_close(convert_handle);
+    }
+    jpeg_enc_close(h);
+    if (rows != block) {
+        jpeg_free_align(rows);
+    }
+    jpeg_free_align(block);
+    free(outbuf);
+    return ok;
+}
+
+void image_to_jpeg_release_cache(void) {
+    jpeg_enc_handle_t sw_handle = NULL;
+    {
+        std::lock_guard<std::mutex> lock(s_sw_jpeg_mutex);
+        sw_handle = s_sw_jpeg_handle;
+        s_sw_jpeg_handle = NULL;
+    }
+    if (sw_handle) {
+        jpeg_enc_close(sw_handle);
+    }
+#if CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
+    std::lock_guard<std::mutex> lock(s_hw_jpeg_mutex);
+    free(s_hw_jpeg_in);
+    s_hw_jpeg_in = NULL;
+    s_hw_jpeg_in_cap = 0;
+    free(s_hw_jpeg_out);
+    s_hw_jpeg_out = NULL;
+    s_hw_jpeg_out_cap = 0;
+    if (s_hw_jpeg_handle) {
+        jpeg_del_encoder_engine(s_hw_jpeg_handle);
+        s_hw_jpeg_handle = NULL;
+    }
+#endif
+}
+
+bool image_rows_to_jpeg_cb(uint16_t width, uint16_t height, v4l2_pix_fmt_t format, uint8_t quality,
+                           jpg_rows_cb rows_cb, void* rows_arg, jpg_out_cb cb, void* arg) {
+    if (rows_format_bytes_per_pixel(format) == 0) {
+        ESP_LOGE(TAG, "unsupported format: 0x%08" PRIx32, format);
+        return false;
+    }
+#if CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
+    if (encode_rows_with_hw_jpeg(width, height, format, quality, rows_cb, rows_arg, cb, arg)) {
+        return true;
+    }
+    // Fallback to esp_new_jpeg
+#endif
+    return encode_rows_with_esp_new_jpeg(width, height, format, quality, rows_cb, rows_arg, cb, arg);
+}
+
 bool image_to_jpeg(uint8_t* src, size_t src_len, uint16_t width, uint16_t height, v4l2_pix_fmt_t format,
                    uint8_t quality, uint8_t** out, size_t* out_len) {
 #ifdef CONFIG_XIAOZHI_CAMERA_ALLOW_JPEG_INPUT
@@ -42,6 +42,8 @@ extern "C"
      * - 节省约8KB的SRAM使用（静态变量改为堆分配）
      * - 支持多种图像格式输入
      * - 高质量JPEG输出
+     * - 启用硬件编码器时（ESP32-P4）优先硬件编码，失败回退软件编码
+     * - 软件编码器句柄（含量化表和霍夫曼表）在参数不变时跨调用复用
      *
      * @param src       源图像数据
      * @param src_len   源图像数据长度
@@ -79,6 +81,41 @@ extern "C"
     bool image_to_jpeg_cb(uint8_t *src, size_t src_len, uint16_t width, uint16_t height,
                           v4l2_pix_fmt_t format, uint8_t quality, jpg_out_cb cb, void *arg);
 
+    // 源图像行读取回调函数类型
+    // arg: 用户自定义参数, y: 起始行, rows: 行数, dst: 目标缓冲区（行间距 = width * 每像素字节数）
+    // 返回: true 成功, false 中止编码
+    typedef bool (*jpg_rows_cb)(void *arg, uint16_t y, uint16_t rows, uint8_t *dst);
+
+    /**
+     * @brief 按行带流式编码 JPEG（回调版本）
+     *
+     * 源图像不需要整帧存在于内存中，编码器按 MCU 行向 rows_cb 逐带请求像素：
+     * - 软件编码只占用一个 MCU 行带的输入和输出缓冲区
+     * - 每个行带编码完成后立即通过 cb 输出，无需整帧输出缓冲区
+     * - 启用硬件编码器时（ESP32-P4）一次请求整帧，再由硬件编码
+     *
+     * @param width     图像宽度
+     * @param height    图像高度
+     * @param format    图像格式 (RGB565, RGB565X, RGB24, YUYV, GREY)
+     * @param quality   JPEG质量 (1-100)
+     * @param rows_cb   源图像行读取回调函数
+     * @param rows_arg  传递给行读取回调函数的用户参数
+     * @param cb        输出回调函数
+     * @param arg       传递给输出回调函数的用户参数
+     *
+     * @return true 成功, false 失败
+     */
+    bool image_rows_to_jpeg_cb(uint16_t width, uint16_t height, v4l2_pix_fmt_t format, uint8_t quality,
+                               jpg_rows_cb rows_cb, void *rows_arg, jpg_out_cb cb, void *arg);
+
+    /**
+     * @brief 释放编码器跨调用缓存的资源
+     *
+     * 包括缓存的软件编码器句柄，以及启用硬件编码器时的编码引擎和 DMA 输入/输出缓冲区。
+     * 下次编码时按需重新创建。推流结束等短时间内不再编码时调用。
+     */
+    void image_to_jpeg_release_cache(void);
+
 #ifdef __cplusplus
 }
 #endif
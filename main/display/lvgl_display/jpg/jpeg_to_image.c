@@ -20,12 +20,38 @@
 
 #define TAG "jpeg_to_image"
 
-static esp_err_t decode_with_new_jpeg(const uint8_t* src, size_t src_len, uint8_t** out, size_t* out_len, size_t* width,
-                                      size_t* height, size_t* stride) {
+// Largest 1/2^n reduction (n <= 3) that keeps the output at least target_width x target_height.
+// 0 means no limit on that side. The decoder wants the scaled size in multiples of 8.
+static int pick_scale_shift(int width, int height, size_t target_width, size_t target_height) {
+    if (target_width == 0 && target_height == 0) {
+        return 0;
+    }
+    int shift = 0;
+    while (shift < 3) {
+        int w = width >> (shift + 1);
+        int h = height >> (shift + 1);
+        if ((target_width > 0 && (size_t)w < target_width) || (target_height > 0 && (size_t)h < target_height) ||
+            (w & 7) != 0 || (h & 7) != 0) {
+            break;
+        }
+        shift++;
+    }
+    return shift;
+}
+
+// When out_cap is NULL a new buffer is always allocated. Otherwise *out (of *out_cap bytes, may be
+// NULL) is reused if large enough and reallocated if not; it stays owned by the caller on failure.
+static esp_err_t decode_with_new_jpeg(const uint8_t* src, size_t src_len, size_t target_width,
+                                      size_t target_height, uint8_t** out, size_t* out_cap, size_t* out_len,
+                                      size_t* width, size_t* height, size_t* stride) {
     ESP_LOGD(TAG, "Decoding JPEG with software decoder");
     esp_err_t ret = ESP_OK;
     jpeg_error_t jpeg_ret = JPEG_ERR_OK;
     uint8_t* out_buf = NULL;
+    size_t out_buf_len = 0;
+    int shift = 0;
+    int out_width = 0;
+    int out_height = 0;
     jpeg_dec_io_t jpeg_io = {0};
     jpeg_dec_header_info_t out_info = {0};
 
@@ -52,12 +78,45 @@ static esp_err_t decode_with_new_jpeg(const uint8_t* src, size_t src_len, uint8_
     }
 
     ESP_LOGD(TAG, "JPEG header info: width=%d, height=%d", out_info.width, out_info.height);
+    out_width = out_info.width;
+    out_height = out_info.height;
+
+    // The scale is part of the decoder config, reopen with it once the picture size is known
+    shift = pick_scale_shift(out_info.width, out_info.height, target_width, target_height);
+    if (shift > 0) {
+        out_width = out_info.width >> shift;
+        out_height = out_info.height >> shift;
+        jpeg_dec_close(jpeg_dec);
+        jpeg_dec = NULL;
+        config.scale.width = out_width;
+        config.scale.height = out_height;
+        jpeg_ret = jpeg_dec_open(&config, &jpeg_dec);
+        if (jpeg_ret != JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "Failed to open scaled JPEG decoder");
+            ret = ESP_FAIL;
+            goto jpeg_dec_failed;
+        }
+        jpeg_io.inbuf = (uint8_t*)src;
+        jpeg_io.inbuf_len = (int)src_len;
+        jpeg_ret = jpeg_dec_parse_header(jpeg_dec, &jpeg_io, &out_info);
+        if (jpeg_ret != JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "Failed to parse JPEG header");
+            ret = ESP_ERR_INVALID_ARG;
+            goto jpeg_dec_failed;
+        }
+        ESP_LOGD(TAG, "Decoding at 1/%d scale: %dx%d", 1 << shift, out_width, out_height);
+    }
 
-    out_buf = jpeg_calloc_align(out_info.width * out_info.height * 2, 16);
-    if (out_buf == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for JPEG output buffer");
-        ret = ESP_ERR_NO_MEM;
-        goto jpeg_dec_failed;
+    out_buf_len = (size_t)out_width * out_height * 2;
+    if (out_cap != NULL && *out != NULL && *out_cap >= out_buf_len) {
+        out_buf = *out;
+    } else {
+        out_buf = jpeg_calloc_align(out_buf_len, 16);
+        if (out_buf == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate memory for JPEG output buffer");
+            ret = ESP_ERR_NO_MEM;
+            goto jpeg_dec_failed;
+        }
     }
 
     jpeg_io.outbuf = out_buf;
@@ -68,14 +127,20 @@ static esp_err_t decode_with_new_jpeg(const uint8_t* src, size_t src_len, uint8_
         goto jpeg_dec_failed;
     }
 
-    ESP_LOG_BUFFER_HEXDUMP(TAG, out_buf, MIN(out_info.width * out_info.height * 2, 256), ESP_LOG_DEBUG);
+    ESP_LOG_BUFFER_HEXDUMP(TAG, out_buf, MIN(out_buf_len, 256), ESP_LOG_DEBUG);
 
+    if (out_cap != NULL && out_buf != *out) {
+        if (*out) {
+            heap_caps_free(*out);
+        }
+        *out_cap = out_buf_len;
+    }
     *out = out_buf;
     out_buf = NULL;
-    *out_len = (size_t)(out_info.width * out_info.height * 2);
-    *width = (size_t)out_info.width;
-    *height = (size_t)out_info.height;
-    *stride = (size_t)out_info.width * 2;
+    *out_len = out_buf_len;
+    *width = (size_t)out_width;
+    *height = (size_t)out_height;
+    *stride = (size_t)out_width * 2;
     jpeg_dec_close(jpeg_dec);
     jpeg_dec = NULL;
 
@@ -86,12 +151,19 @@ jpeg_dec_failed:
         jpeg_dec_close(jpeg_dec);
         jpeg_dec = NULL;
     }
-    if (out_buf) {
-        jpeg_free_align(out_buf);
-        out_buf = NULL;
+    if (out_cap != NULL) {
+        // The reusable buffer stays with the caller
+        if (out_buf && out_buf != *out) {
+            jpeg_free_align(out_buf);
+        }
+    } else {
+        if (out_buf) {
+            jpeg_free_align(out_buf);
+        }
+        *out = NULL;
     }
+    out_buf = NULL;
 
-    *out = NULL;
     *out_len = 0;
     *width = 0;
     *height = 0;
@@ -260,5 +332,31 @@ esp_err_t jpeg_to_image(const uint8_t* src, size_t src_len, uint8_t** out, size_
     ESP_LOGW(TAG, "Failed to decode with hardware JPEG, fallback to software decoder");
     // Fallback to esp_new_jpeg
 #endif
-    return decode_with_new_jpeg(src, src_len, out, out_len, width, height, stride);
+    return decode_with_new_jpeg(src, src_len, 0, 0, out, NULL, out_len, width, height, stride);
+}
+
+esp_err_t jpeg_to_image_scaled(const uint8_t* src, size_t src_len, size_t target_width, size_t target_height,
+                               uint8_t** out, size_t* out_cap, size_t* out_len, size_t* width, size_t* height,
+                               size_t* stride) {
+    if (src == NULL || src_len == 0 || out == NULL || out_cap == NULL || out_len == NULL || width == NULL ||
+        height == NULL || stride == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+#ifdef CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_DECODER
+    // The hardware decoder can't scale but is fast enough to decode the full picture
+    uint8_t* hw_out = NULL;
+    esp_err_t ret = decode_with_hardware_jpeg(src, src_len, &hw_out, out_len, width, height, stride);
+    if (ret == ESP_OK) {
+        if (*out) {
+            heap_caps_free(*out);
+        }
+        *out = hw_out;
+        *out_cap = *out_len;
+        return ret;
+    }
+    ESP_LOGW(TAG, "Failed to decode with hardware JPEG, fallback to software decoder");
+#endif
+    return decode_with_new_jpeg(src, src_len, target_width, target_height, out, out_cap, out_len, width, height,
+                                stride);
 }
@@ -55,6 +55,31 @@ extern "C" {
 esp_err_t jpeg_to_image(const uint8_t* src, size_t src_len, uint8_t** out, size_t* out_len, size_t* width,
                         size_t* height, size_t* stride);
 
+/**
+ * @brief Decodes a JPEG image to RGB565, scaled down to about the given size, into a reusable buffer
+ *
+ * The software decoder picks the largest 1/2, 1/4 or 1/8 reduction that keeps the output at least
+ * target_width x target_height; scaling happens inside the decoder, so the full-size picture is never held
+ * in memory. The hardware decoder (if enabled) always decodes at full size.
+ *
+ * @param[in] src Pointer to the JPEG bitstream in memory
+ * @param[in] src_len Length of the JPEG bitstream in bytes
+ * @param[in] target_width Minimum output width to keep (e.g. the display width), 0 for no limit
+ * @param[in] target_height Minimum output height to keep, 0 for no limit
+ * @param[in,out] out Output buffer, may point to NULL. It is reused when *out_cap is large enough, otherwise
+ *                freed and replaced. The buffer always stays owned by the caller, free it with heap_caps_free().
+ * @param[in,out] out_cap Size of *out in bytes, updated when the buffer is replaced
+ * @param[out] out_len Size of the decoded image data in bytes
+ * @param[out] width Decoded image width in pixels
+ * @param[out] height Decoded image height in pixels
+ * @param[out] stride Decoded image stride in bytes
+ *
+ * @return ESP_OK on success, an error code from jpeg_to_image() otherwise
+ */
+esp_err_t jpeg_to_image_scaled(const uint8_t* src, size_t src_len, size_t target_width, size_t target_height,
+                               uint8_t** out, size_t* out_cap, size_t* out_len, size_t* width, size_t* height,
+                               size_t* stride);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,290 @@
+#include "lvgl_animation.h"
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+
+#define TAG "LvglAnimation"
+
+#define ANIM_MAGIC "XZAN"
+#define ANIM_VERSION 1
+#define ANIM_COLOR_RGB565 0
+#define ANIM_COLOR_RGB565A8 1
+#define ANIM_FRAME_KEYFRAME 0x01
+
+// All fields are naturally aligned, the file layout is the in-memory layout
+struct LvglAnimation::Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t color_format;
+    uint16_t width;
+    uint16_t height;
+    uint16_t frame_count;
+    uint16_t reserved0;
+    int32_t loop_count;     // 0: forever, n: play n times
+    uint32_t reserved1;
+};
+
+// Frame data: h rows of w RGB565 pixels, followed by h rows of w A8 pixels for RGB565A8
+struct LvglAnimation::Frame {
+    uint32_t offset;        // From the start of the file, 4 byte aligned
+    uint16_t x, y, w, h;    // Dirty rectangle, the whole image for keyframes, empty to hold the last frame
+    uint16_t delay_ms;
+    uint16_t flags;
+};
+
+bool LvglAnimation::IsAnimation(const void* data, size_t size) {
+    static_assert(sizeof(Header) == 24, "Animation header must be 24 bytes");
+    static_assert(sizeof(Frame) == 16, "Animation frame entry must be 16 bytes");
+    return data != nullptr && size >= sizeof(Header) && memcmp(data, ANIM_MAGIC, 4) == 0;
+}
+
+LvglAnimation::LvglAnimation(const lv_img_dsc_t* img_dsc) {
+    memset(&img_dsc_, 0, sizeof(img_dsc_));
+    if (!img_dsc || !IsAnimation(img_dsc->data, img_dsc->data_size)) {
+        ESP_LOGE(TAG, "Invalid animation data");
+        return;
+    }
+
+    if (reinterpret_cast<uintptr_t>(img_dsc->data) % 4 != 0) {
+        // The build script pads .anim assets, unaligned data would fault on word loads
+        ESP_LOGE(TAG, "Animation data %p is not 4 byte aligned", img_dsc->data);
+        return;
+    }
+
+    data_ = img_dsc->data;
+    header_ = reinterpret_cast<const Header*>(data_);
+    frames_ = reinterpret_cast<const Frame*>(data_ + sizeof(Header));
+    if (!Validate(img_dsc->data_size)) {
+        return;
+    }
+
+    bool has_alpha = header_->color_format == ANIM_COLOR_RGB565A8;
+    size_t frame_size = header_->width * header_->height * (has_alpha ? 3 : 2);
+    img_dsc_.header.magic = LV_IMAGE_HEADER_MAGIC;
+    img_dsc_.header.cf = has_alpha ? LV_COLOR_FORMAT_RGB565A8 : LV_COLOR_FORMAT_RGB565;
+    img_dsc_.header.w = header_->width;
+    img_dsc_.header.h = header_->height;
+    img_dsc_.header.stride = header_->width * 2;
+    img_dsc_.data_size = frame_size;
+
+    // Keyframes can be shown in place, only delta frames need somewhere to be composed
+    bool has_delta = false;
+    for (int i = 0; i < header_->frame_count; i++) {
+        if (!(frames_[i].flags & ANIM_FRAME_KEYFRAME) && frames_[i].w > 0 && frames_[i].h > 0) {
+            has_delta = true;
+            break;
+        }
+    }
+    if (has_delta) {
+        canvas_ = (uint8_t*)heap_caps_malloc_prefer(frame_size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+        if (canvas_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate %u bytes for animation canvas", (unsigned)frame_size);
+            return;
+        }
+        img_dsc_.header.flags = LV_IMAGE_FLAGS_MODIFIABLE;
+        img_dsc_.data = canvas_;
+    }
+
+    loop_count_ = header_->loop_count;
+    ShowFrame(0);
+    loaded_ = true;
+    ESP_LOGD(TAG, "Animation loaded: %dx%d, %d frames%s", header_->width, header_->height,
+        header_->frame_count, canvas_ ? "" : ", in place");
+}
+
+LvglAnimation::~LvglAnimation() {
+    if (timer_) {
+        lv_timer_delete(timer_);
+        timer_ = nullptr;
+    }
+    if (canvas_) {
+        heap_caps_free(canvas_);
+        canvas_ = nullptr;
+    }
+}
+
+bool LvglAnimation::Validate(size_t size) const {
+    if (header_->version != ANIM_VERSION || header_->color_format > ANIM_COLOR_RGB565A8 ||
+        header_->width == 0 || header_->height == 0 || header_->frame_count == 0) {
+        ESP_LOGE(TAG, "Unsupported animation: version %u, format %u, %ux%u, %u frames", header_->version,
+            header_->color_format, header_->width, header_->height, header_->frame_count);
+        return false;
+    }
+    if (sizeof(Header) + header_->frame_count * sizeof(Frame) > size) {
+        ESP_LOGE(TAG, "Animation frame table is truncated");
+        return false;
+    }
+
+    size_t bytes_per_pixel = header_->color_format == ANIM_COLOR_RGB565A8 ? 3 : 2;
+    for (int i = 0; i < header_->frame_count; i++) {
+        auto& frame = frames_[i];
+        bool keyframe = frame.flags & ANIM_FRAME_KEYFRAME;
+        if (keyframe && (frame.x != 0 || frame.y != 0 || frame.w != header_->width || frame.h != header_->height)) {
+            ESP_LOGE(TAG, "Keyframe %d does not cover the whole image", i);
+            return false;
+        }
+        if (i == 0 && !keyframe) {
+            ESP_LOGE(TAG, "The first frame must be a keyframe");
+            return false;
+        }
+        if (frame.x + frame.w > header_->width || frame.y + frame.h > header_->height ||
+            frame.offset + (size_t)frame.w * frame.h * bytes_per_pixel > size) {
+            ESP_LOGE(TAG, "Frame %d is out of bounds", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+const lv_img_dsc_t* LvglAnimation::image_dsc() const {
+    if (!loaded_) {
+        return nullptr;
+    }
+    return &img_dsc_;
+}
+
+void LvglAnimation::Start() {
+    if (!loaded_) {
+        ESP_LOGW(TAG, "Animation not loaded, cannot start");
+        return;
+    }
+
+    if (!timer_) {
+        timer_ = lv_timer_create([](lv_timer_t* timer) {
+            auto animation = static_cast<LvglAnimation*>(lv_timer_get_user_data(timer));
+            animation->NextFrame();
+        }, 10, this);
+    }
+
+    if (timer_) {
+        playing_ = true;
+        loop_waiting_ = false;
+        last_call_ = lv_tick_get();
+        lv_timer_resume(timer_);
+        lv_timer_reset(timer_);
+    }
+}
+
+void LvglAnimation::Stop() {
+    if (timer_) {
+        playing_ = false;
+        lv_timer_pause(timer_);
+    }
+
+    loop_waiting_ = false;
+    if (loaded_) {
+        loop_count_ = header_->loop_count;
+        ShowFrame(0);
+    }
+}
+
+bool LvglAnimation::IsPlaying() const {
+    return playing_;
+}
+
+bool LvglAnimation::IsLoaded() const {
+    return loaded_;
+}
+
+void LvglAnimation::SetLoopDelay(uint32_t delay_ms) {
+    loop_delay_ms_ = delay_ms;
+}
+
+uint16_t LvglAnimation::width() const {
+    return loaded_ ? header_->width : 0;
+}
+
+uint16_t LvglAnimation::height() const {
+    return loaded_ ? header_->height : 0;
+}
+
+void LvglAnimation::SetFrameCallback(std::function<void()> callback) {
+    frame_callback_ = callback;
+}
+
+void LvglAnimation::NextFrame() {
+    if (!loaded_ || !playing_) {
+        return;
+    }
+
+    if (loop_waiting_) {
+        if (lv_tick_elaps(loop_wait_start_) < loop_delay_ms_) {
+            return;
+        }
+        loop_waiting_ = false;
+        last_call_ = lv_tick_get();
+        ShowFrame(0);
+        if (frame_callback_) {
+            frame_callback_();
+        }
+        return;
+    }
+
+    if (lv_tick_elaps(last_call_) < frames_[frame_index_].delay_ms) {
+        return;
+    }
+    last_call_ = lv_tick_get();
+
+    size_t next = frame_index_ + 1;
+    if (next >= header_->frame_count) {
+        if (loop_count_ > 0 && --loop_count_ == 0) {
+            playing_ = false;
+            lv_timer_pause(timer_);
+            ESP_LOGD(TAG, "Animation completed");
+            return;
+        }
+        if (header_->frame_count == 1) {
+            return;
+        }
+        if (loop_delay_ms_ > 0) {
+            loop_waiting_ = true;
+            loop_wait_start_ = lv_tick_get();
+            return;
+        }
+        next = 0;
+    }
+
+    ShowFrame(next);
+    if (frame_callback_) {
+        frame_callback_();
+    }
+}
+
+void LvglAnimation::ShowFrame(size_t index) {
+    frame_index_ = index;
+    auto& frame = frames_[index];
+    if (frame.w == 0 || frame.h == 0) {
+        return;
+    }
+
+    const uint8_t* src = data_ + frame.offset;
+    if (canvas_ == nullptr) {
+        // Keyframes only, point LVGL straight at the mmapped frame
+        img_dsc_.data = src;
+        lv_image_cache_drop(&img_dsc_);
+        return;
+    }
+
+    if (frame.flags & ANIM_FRAME_KEYFRAME) {
+        memcpy(canvas_, src, img_dsc_.data_size);
+        return;
+    }
+
+    // Copy the dirty rectangle row by row, the alpha plane follows the color plane
+    size_t stride = header_->width * 2;
+    size_t row_bytes = frame.w * 2;
+    uint8_t* dst = canvas_ + frame.y * stride + frame.x * 2;
+    for (int row = 0; row < frame.h; row++) {
+        memcpy(dst, src, row_bytes);
+        dst += stride;
+        src += row_bytes;
+    }
+    if (header_->color_format == ANIM_COLOR_RGB565A8) {
+        uint8_t* alpha = canvas_ + stride * header_->height + frame.y * header_->width + frame.x;
+        for (int row = 0; row < frame.h; row++) {
+            memcpy(alpha, src, frame.w);
+            alpha += header_->width;
+            src += frame.w;
+        }
+    }
+}
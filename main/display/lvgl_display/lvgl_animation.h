@@ -0,0 +1,74 @@
+#pragma once
+
+#include "lvgl_image.h"
+#include <lvgl.h>
+#include <functional>
+
+/**
+ * Player for pre-rendered animations (.anim assets, see scripts/Image_Converter/anim_converter.py)
+ *
+ * The animation is stored as RGB565 (or RGB565A8) keyframes and dirty-rectangle deltas
+ * with per-frame timing. Playing a frame is a row-by-row memcpy out of the mmapped
+ * partition into a small canvas, no decoding at all. Animations made of keyframes only
+ * are shown straight from flash without any canvas.
+ *
+ * The control interface mirrors LvglGif.
+ */
+class LvglAnimation : public LvglImage {
+public:
+    // Check the file magic
+    static bool IsAnimation(const void* data, size_t size);
+
+    explicit LvglAnimation(const lv_img_dsc_t* img_dsc);
+    virtual ~LvglAnimation();
+
+    virtual const lv_img_dsc_t* image_dsc() const override;
+
+    void Start();
+    void Stop();
+    bool IsPlaying() const;
+    bool IsLoaded() const;
+
+    /**
+     * Set loop delay in milliseconds (delay between loops)
+     * @param delay_ms Delay in milliseconds before starting next loop. 0 means no delay.
+     */
+    void SetLoopDelay(uint32_t delay_ms);
+
+    uint16_t width() const;
+    uint16_t height() const;
+
+    /**
+     * Set frame update callback
+     */
+    void SetFrameCallback(std::function<void()> callback);
+
+private:
+    struct Header;
+    struct Frame;
+
+    const uint8_t* data_ = nullptr;
+    const Header* header_ = nullptr;
+    const Frame* frames_ = nullptr;
+
+    // Composition canvas, nullptr when every frame is a keyframe
+    uint8_t* canvas_ = nullptr;
+    lv_img_dsc_t img_dsc_;
+
+    lv_timer_t* timer_ = nullptr;
+    size_t frame_index_ = 0;
+    int32_t loop_count_ = 0;
+    uint32_t last_call_ = 0;
+    bool playing_ = false;
+    bool loaded_ = false;
+
+    uint32_t loop_delay_ms_ = 0;
+    bool loop_waiting_ = false;
+    uint32_t loop_wait_start_ = 0;
+
+    std::function<void()> frame_callback_;
+
+    bool Validate(size_t size) const;
+    void NextFrame();
+    void ShowFrame(size_t index);
+};
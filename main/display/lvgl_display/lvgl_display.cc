@@ -3,7 +3,9 @@
 #include <string>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <font_awesome.h>
+#include <esp_lvgl_port.h>
 
 #include "lvgl_display.h"
 #include "board.h"
@@ -13,8 +15,21 @@
 #include "assets/lang_config.h"
 #include "jpg/image_to_jpeg.h"
 
+#if CONFIG_LV_USE_SNAPSHOT
+#include <src/core/lv_refr_private.h>
+#include <src/display/lv_display_private.h>
+#include <src/draw/lv_draw_private.h>
+#endif
+
 #define TAG "Display"
 
+// Refresh period of the LVGL display while idle or dimmed
+#define IDLE_REFRESH_PERIOD_MS CONFIG_DISPLAY_IDLE_REFRESH_PERIOD_MS
+
+// Battery level buckets and network state change slowly, poll them less often than the clock tick
+#define BATTERY_POLL_TICKS 5
+#define NETWORK_POLL_TICKS 10
+
 LvglDisplay::LvglDisplay() {
     // Notification timer
     esp_timer_create_args_t notification_timer_args = {
@@ -74,7 +89,10 @@ void LvglDisplay::SetStatus(const char* status) {
     if (status_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(status_label_, status);
+    // Setting the same text still invalidates the label
+    if (strcmp(lv_label_get_text(status_label_), status) != 0) {
+        lv_label_set_text(status_label_, status);
+    }
     lv_obj_remove_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
     lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
 
@@ -128,21 +146,34 @@ void LvglDisplay::UpdateStatusBar(bool update_all) {
             struct tm* tm = localtime(&now);
             // Check if the we have already set the time
             if (tm->tm_year >= 2025 - 1900) {
-                char time_str[16];
-                strftime(time_str, sizeof(time_str), "%H:%M", tm);
-                SetStatus(time_str);
+                // Only touch the label when the minute changes or another status replaced the clock
+                int minute = tm->tm_hour * 60 + tm->tm_min;
+                if (minute != clock_minute_ || last_status_update_time_ != clock_status_time_) {
+                    char time_str[16];
+                    strftime(time_str, sizeof(time_str), "%H:%M", tm);
+                    SetStatus(time_str);
+                    clock_minute_ = minute;
+                    clock_status_time_ = last_status_update_time_;
+                }
             } else {
                 ESP_LOGW(TAG, "System time is not set, tm_year: %d", tm->tm_year);
             }
         }
     }
 
+    bool poll_battery = update_all || status_bar_ticks_ % BATTERY_POLL_TICKS == 0;
+    bool poll_network = update_all || status_bar_ticks_ % NETWORK_POLL_TICKS == 0;
+    status_bar_ticks_++;
+    if (!poll_battery && !poll_network) {
+        return;
+    }
+
     esp_pm_lock_acquire(pm_lock_);
     // Update battery icon
     int battery_level;
     bool charging, discharging;
     const char* icon = nullptr;
-    if (board.GetBatteryLevel(battery_level, charging, discharging)) {
+    if (poll_battery && board.GetBatteryLevel(battery_level, charging, discharging)) {
         if (charging) {
             icon = FONT_AWESOME_BATTERY_BOLT;
         } else {
@@ -178,8 +209,7 @@ void LvglDisplay::UpdateStatusBar(bool update_all) {
     }
 
     // Update network icon every 10 seconds
-    static int seconds_counter = 0;
-    if (update_all || seconds_counter++ % 10 == 0) {
+    if (poll_network) {
         // Don't read 4G network status during firmware upgrade to avoid occupying UART resources
         auto device_state = Application::GetInstance().GetDeviceState();
         static const std::vector<DeviceState> allowed_states = {
@@ -213,44 +243,297 @@ void LvglDisplay::SetPowerSaveMode(bool on) {
         SetChatMessage("system", "");
         SetEmotion("neutral");
     }
+
+    std::lock_guard<std::mutex> lock(governor_mutex_);
+    power_save_ = on;
+    ScheduleGovernor();
 }
 
-bool LvglDisplay::SnapshotToJpeg(std::string& jpeg_data, int quality) {
-#if CONFIG_LV_USE_SNAPSHOT
+void LvglDisplay::SetActivity(DisplayActivity activity) {
+    std::lock_guard<std::mutex> lock(governor_mutex_);
+    activity_ = activity;
+    ScheduleGovernor();
+}
+
+void LvglDisplay::SetScreenOn(bool on) {
+    std::lock_guard<std::mutex> lock(governor_mutex_);
+    screen_on_ = on;
+    ScheduleGovernor();
+}
+
+// Called with governor_mutex_ held. Inputs come from timer tasks, starting and stopping the
+// LVGL task may block, so the change is applied on the main task and bursts are coalesced.
+void LvglDisplay::ScheduleGovernor() {
+    if (governor_pending_) {
+        return;
+    }
+    governor_pending_ = true;
+    Application::GetInstance().Schedule([this]() {
+        ApplyGovernor();
+    });
+}
+
+void LvglDisplay::ApplyGovernor() {
+    RefreshLevel level;
+    {
+        std::lock_guard<std::mutex> lock(governor_mutex_);
+        governor_pending_ = false;
+        if (!screen_on_) {
+            level = RefreshLevel::kSuspended;
+        } else if (power_save_) {
+            level = RefreshLevel::kPaused;
+        } else if (activity_ == DisplayActivity::kIdle) {
+            level = RefreshLevel::kReduced;
+        } else {
+            level = RefreshLevel::kFull;
+        }
+    }
+    if (display_ == nullptr || (governor_started_ && level == refresh_level_)) {
+        return;
+    }
+
+    if (refresh_level_ == RefreshLevel::kSuspended && level != RefreshLevel::kSuspended) {
+        ResumeRendering();
+    }
+
+    {
+        DisplayLockGuard lock(this);
+        lv_timer_t* refr_timer = lv_display_get_refr_timer(display_);
+        if (!governor_started_) {
+            governor_started_ = true;
+            full_refresh_period_ms_ = LV_DEF_REFR_PERIOD;
+            refresh_period_ms_ = full_refresh_period_ms_;
+            stats_frames_ = refresh_stats_.frames;
+            stats_refresh_us_ = refresh_stats_.total_render_us + refresh_stats_.total_wait_us;
+            stats_time_us_ = esp_timer_get_time();
+            HookRefreshEvents();
+        }
+
+        uint32_t period = level == RefreshLevel::kFull ? full_refresh_period_ms_
+            : std::max<uint32_t>(IDLE_REFRESH_PERIOD_MS, full_refresh_period_ms_);
+        if (refr_timer != nullptr && period != refresh_period_ms_) {
+            lv_timer_set_period(refr_timer, period);
+            refresh_period_ms_ = period;
+        }
+
+        bool paused = level >= RefreshLevel::kPaused;
+        if (paused != animations_paused_) {
+            animations_paused_ = paused;
+            PauseAnimations(paused);
+        }
+        refresh_level_ = level;
+    }
+
+    if (level == RefreshLevel::kSuspended) {
+        SuspendRendering();
+    }
+    ESP_LOGI(TAG, "Refresh governor: level %d, period %lu ms", (int)level, refresh_period_ms_);
+}
+
+void LvglDisplay::SuspendRendering() {
+    std::lock_guard<std::mutex> lock(suspend_mutex_);
+    if (suspend_count_++ == 0) {
+        lvgl_port_stop();
+        suspended_since_us_ = esp_timer_get_time();
+    }
+}
+
+void LvglDisplay::ResumeRendering() {
+    std::lock_guard<std::mutex> lock(suspend_mutex_);
+    if (suspend_count_ == 0) {
+        return;
+    }
+    if (--suspend_count_ == 0) {
+        suspended_us_ += esp_timer_get_time() - suspended_since_us_;
+        lvgl_port_resume();
+    }
+}
+
+void LvglDisplay::HookRefreshEvents() {
+    if (refresh_hooked_ || display_ == nullptr) {
+        return;
+    }
+    refresh_hooked_ = true;
+    lv_display_add_event_cb(display_, RefreshEventCallback, LV_EVENT_REFR_START, this);
+    lv_display_add_event_cb(display_, RefreshEventCallback, LV_EVENT_REFR_READY, this);
+    lv_display_add_event_cb(display_, RefreshEventCallback, LV_EVENT_FLUSH_START, this);
+    lv_display_add_event_cb(display_, RefreshEventCallback, LV_EVENT_FLUSH_WAIT_START, this);
+    lv_display_add_event_cb(display_, RefreshEventCallback, LV_EVENT_FLUSH_WAIT_FINISH, this);
+}
+
+void LvglDisplay::RefreshEventCallback(lv_event_t* e) {
+    auto self = static_cast<LvglDisplay*>(lv_event_get_user_data(e));
+    int64_t now = esp_timer_get_time();
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_REFR_START:
+            self->refresh_start_us_ = now;
+            self->refresh_wait_us_ = 0;
+            self->refresh_flushes_ = 0;
+            break;
+        case LV_EVENT_FLUSH_START:
+            self->refresh_flushes_++;
+            break;
+        case LV_EVENT_FLUSH_WAIT_START:
+            self->wait_start_us_ = now;
+            break;
+        case LV_EVENT_FLUSH_WAIT_FINISH:
+            self->refresh_wait_us_ += now - self->wait_start_us_;
+            break;
+        case LV_EVENT_REFR_READY: {
+            // Most refresh timer runs find nothing to redraw, only count the ones that flushed
+            if (self->refresh_flushes_ == 0) {
+                break;
+            }
+            auto& stats = self->refresh_stats_;
+            uint32_t wait_us = self->refresh_wait_us_;
+            uint32_t render_us = now - self->refresh_start_us_ - wait_us;
+            stats.frames++;
+            stats.last_render_us = render_us;
+            stats.last_wait_us = wait_us;
+            stats.max_render_us = std::max(stats.max_render_us, render_us);
+            stats.max_wait_us = std::max(stats.max_wait_us, wait_us);
+            stats.total_render_us += render_us;
+            stats.total_wait_us += wait_us;
+            if (stats.frames % 256 == 0) {
+                ESP_LOGD(TAG, "Refresh: %lu frames, avg render %llu us, avg wait %llu us, max %lu/%lu us",
+                    stats.frames, stats.total_render_us / stats.frames, stats.total_wait_us / stats.frames,
+                    stats.max_render_us, stats.max_wait_us);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+LvglDisplay::RefreshStats LvglDisplay::GetRefreshStats() {
+    DisplayLockGuard lock(this);
+    return refresh_stats_;
+}
+
+LvglDisplay::GovernorStats LvglDisplay::GetGovernorStats() {
+    static const char* const level_names[] = {"full", "reduced", "paused", "suspended"};
+    GovernorStats stats;
+    {
+        // Not nested with the display lock: stopping the LVGL task waits for it to release the display
+        std::lock_guard<std::mutex> lock(suspend_mutex_);
+        uint64_t suspended_us = suspended_us_;
+        if (suspend_count_ > 0) {
+            suspended_us += esp_timer_get_time() - suspended_since_us_;
+        }
+        stats.suspended_ms = suspended_us / 1000;
+    }
+
     DisplayLockGuard lock(this);
+    int64_t now = esp_timer_get_time();
+    stats.level = level_names[(int)refresh_level_];
+    stats.refresh_period_ms = refresh_period_ms_;
+    // Rendering plus waiting for the panel, both keep the LVGL task busy
+    uint64_t refresh_us = refresh_stats_.total_render_us + refresh_stats_.total_wait_us;
+    stats.frames = refresh_stats_.frames;
+    if (governor_started_ && now > stats_time_us_) {
+        float elapsed_us = now - stats_time_us_;
+        stats.fps = (refresh_stats_.frames - stats_frames_) * 1000000.0f / elapsed_us;
+        stats.render_load = (refresh_us - stats_refresh_us_) * 100.0f / elapsed_us;
+    }
+    stats_frames_ = refresh_stats_.frames;
+    stats_refresh_us_ = refresh_us;
+    stats_time_us_ = now;
+    return stats;
+}
 
-    lv_obj_t* screen = lv_screen_active();
-    lv_draw_buf_t* draw_buffer = lv_snapshot_take(screen, LV_COLOR_FORMAT_RGB565);
-    if (draw_buffer == nullptr) {
-        ESP_LOGE(TAG, "Failed to take snapshot, draw_buffer is nullptr");
+#if CONFIG_LV_USE_SNAPSHOT
+// Render rows [y, y + rows) of a screen into dst, the same way lv_snapshot renders a whole object
+static bool RenderScreenRows(lv_obj_t* screen, int32_t y, int32_t rows, uint8_t* dst) {
+    int32_t width = lv_obj_get_width(screen);
+    uint32_t stride = width * 2;
+    if (lv_draw_buf_width_to_stride(width, LV_COLOR_FORMAT_RGB565) != stride) {
+        ESP_LOGE(TAG, "Draw buffer stride alignment is not supported by the snapshot encoder");
+        return false;
+    }
+    lv_draw_buf_t draw_buf;
+    if (lv_draw_buf_init(&draw_buf, width, rows, LV_COLOR_FORMAT_RGB565, stride, dst, stride * rows) != LV_RESULT_OK) {
         return false;
     }
+    lv_draw_buf_clear(&draw_buf, nullptr);
+
+    lv_area_t area;
+    lv_obj_get_coords(screen, &area);
+    area.y1 += y;
+    area.y2 = area.y1 + rows - 1;
+
+    lv_layer_t layer;
+    lv_layer_init(&layer);
+    layer.draw_buf = &draw_buf;
+    layer.buf_area = area;
+    layer.color_format = LV_COLOR_FORMAT_RGB565;
+    layer._clip_area = area;
+    layer.phy_clip_area = area;
 
-    // swap bytes
-    uint16_t* data = (uint16_t*)draw_buffer->data;
-    size_t pixel_count = draw_buffer->data_size / 2;
-    for (size_t i = 0; i < pixel_count; i++) {
-        data[i] = __builtin_bswap16(data[i]);
+    lv_display_t* disp_old = lv_refr_get_disp_refreshing();
+    lv_display_t* disp = lv_obj_get_display(screen);
+    lv_layer_t* layer_old = disp->layer_head;
+    disp->layer_head = &layer;
+    lv_refr_set_disp_refreshing(disp);
+    lv_obj_redraw(&layer, screen);
+    while (layer.draw_task_head) {
+        lv_draw_dispatch_wait_for_request();
+        lv_draw_dispatch();
     }
+    disp->layer_head = layer_old;
+    lv_refr_set_disp_refreshing(disp_old);
+    return true;
+}
+#endif
 
-    // Clear output string and use callback version to avoid pre-allocating large memory blocks
+bool LvglDisplay::SnapshotToJpeg(std::string& jpeg_data, int quality) {
     jpeg_data.clear();
+    return SnapshotToJpeg([&jpeg_data](const void* data, size_t len) {
+        jpeg_data.append(static_cast<const char*>(data), len);
+    }, quality);
+}
+
+bool LvglDisplay::SnapshotToJpeg(const std::function<void(const void* data, size_t len)>& output, int quality) {
+#if CONFIG_LV_USE_SNAPSHOT
+    struct SnapshotContext {
+        lv_obj_t* screen;
+        std::string jpeg;
+    } context = { nullptr, {} };
 
-    // Use callback-based JPEG encoder to further save memory
-    bool ret = image_to_jpeg_cb((uint8_t*)draw_buffer->data, draw_buffer->data_size, draw_buffer->header.w, draw_buffer->header.h, V4L2_PIX_FMT_RGB565, quality,
-        [](void *arg, size_t index, const void *data, size_t len) -> size_t {
-        std::string* output = static_cast<std::string*>(arg);
-        if (data && len > 0) {
-            output->append(static_cast<const char*>(data), len);
+    // Render and encode band by band under one display lock, so the image is consistent and no
+    // full frame copy is needed. Only the much smaller JPEG is kept, and written out after the
+    // lock is released
+    int64_t start_time = esp_timer_get_time();
+    uint16_t width, height;
+    {
+        DisplayLockGuard lock(this);
+        context.screen = lv_screen_active();
+        width = lv_obj_get_width(context.screen);
+        height = lv_obj_get_height(context.screen);
+
+        // LVGL renders native RGB565, which the encoder takes as RGB565X
+        bool ret = image_rows_to_jpeg_cb(width, height, V4L2_PIX_FMT_RGB565X, quality,
+            [](void* arg, uint16_t y, uint16_t rows, uint8_t* dst) -> bool {
+                auto context = static_cast<SnapshotContext*>(arg);
+                return RenderScreenRows(context->screen, y, rows, dst);
+            }, &context,
+            [](void* arg, size_t index, const void* data, size_t len) -> size_t {
+                auto context = static_cast<SnapshotContext*>(arg);
+                if (data && len > 0) {
+                    context->jpeg.append(static_cast<const char*>(data), len);
+                }
+                return len;
+            }, &context);
+        if (!ret) {
+            ESP_LOGE(TAG, "Failed to convert image to JPEG");
+            return false;
         }
-        return len;
-    }, &jpeg_data);
-    if (!ret) {
-        ESP_LOGE(TAG, "Failed to convert image to JPEG");
     }
 
-    lv_draw_buf_destroy(draw_buffer);
-    return ret;
+    output(context.jpeg.data(), context.jpeg.size());
+    ESP_LOGI(TAG, "Snapshot %ux%u encoded to %u bytes in %d ms", width, height, (unsigned)context.jpeg.size(),
+        int((esp_timer_get_time() - start_time) / 1000));
+    return true;
 #else
     ESP_LOGE(TAG, "LV_USE_SNAPSHOT is not enabled");
     return false;
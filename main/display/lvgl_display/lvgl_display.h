@@ -11,6 +11,8 @@
 
 #include <string>
 #include <chrono>
+#include <functional>
+#include <mutex>
 
 class LvglDisplay : public Display {
 public:
@@ -23,7 +25,38 @@ public:
     virtual void SetPreviewImage(std::unique_ptr<LvglImage> image);
     virtual void UpdateStatusBar(bool update_all = false);
     virtual void SetPowerSaveMode(bool on);
+    virtual void SetActivity(DisplayActivity activity) override;
+    virtual void SetScreenOn(bool on) override;
     virtual bool SnapshotToJpeg(std::string& jpeg_data, int quality = 80);
+    // Copy the screen under the display lock, then encode it handing the JPEG to output as it is produced
+    virtual bool SnapshotToJpeg(const std::function<void(const void* data, size_t len)>& output, int quality = 80);
+
+    // Stop the LVGL task and its tick timer until ResumeRendering, calls nest
+    void SuspendRendering();
+    void ResumeRendering();
+
+    // Timings of the LVGL refreshes that actually flushed something, in microseconds
+    struct RefreshStats {
+        uint32_t frames = 0;
+        uint32_t last_render_us = 0;    // Time spent rendering, excluding waits for the panel to take a band
+        uint32_t last_wait_us = 0;      // Time spent waiting for the previous band to be sent
+        uint32_t max_render_us = 0;
+        uint32_t max_wait_us = 0;
+        uint64_t total_render_us = 0;
+        uint64_t total_wait_us = 0;
+    };
+    RefreshStats GetRefreshStats();
+
+    // Refresh governor state, rates are measured since the previous call
+    struct GovernorStats {
+        const char* level = "";
+        uint32_t refresh_period_ms = 0;
+        uint32_t frames = 0;            // Refreshes that flushed something, since boot
+        float fps = 0;
+        float render_load = 0;          // Percent of the time the LVGL task spent refreshing
+        uint32_t suspended_ms = 0;      // Total time with the LVGL task stopped
+    };
+    GovernorStats GetGovernorStats();
 
 protected:
     esp_pm_lock_handle_t pm_lock_ = nullptr;
@@ -41,12 +74,67 @@ protected:
     const char* network_icon_ = nullptr;
     bool muted_ = false;
 
+    // Status bar polling, each field is diffed so unchanged labels are never invalidated
+    uint32_t status_bar_ticks_ = 0;
+    int clock_minute_ = -1;
+    std::chrono::system_clock::time_point clock_status_time_;
+
     std::chrono::system_clock::time_point last_status_update_time_;
     esp_timer_handle_t notification_timer_ = nullptr;
 
+    // Set by the governor when the screen is dimmed or off, emoji animations must not be started
+    bool animations_paused_ = false;
+    // Called with the display locked when animations_paused_ changes
+    virtual void PauseAnimations(bool paused) {}
+
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
+
+    // Registers the refresh event callback that feeds RefreshStats, once per display. Call with
+    // the display locked, or before the LVGL task runs
+    void HookRefreshEvents();
+
+private:
+    enum class RefreshLevel {
+        kFull,          // LVGL default refresh period
+        kReduced,       // Idle refresh period
+        kPaused,        // Idle refresh period, animations stopped
+        kSuspended,     // LVGL task stopped
+    };
+
+    // Governor inputs, written from any task and applied on the main task
+    std::mutex governor_mutex_;
+    DisplayActivity activity_ = DisplayActivity::kActive;
+    bool power_save_ = false;
+    bool screen_on_ = true;
+    bool governor_pending_ = false;
+
+    RefreshLevel refresh_level_ = RefreshLevel::kFull;
+    bool governor_started_ = false;
+    uint32_t full_refresh_period_ms_ = 0;
+    uint32_t refresh_period_ms_ = 0;
+
+    std::mutex suspend_mutex_;
+    int suspend_count_ = 0;
+    int64_t suspended_since_us_ = 0;
+    uint64_t suspended_us_ = 0;
+
+    // Refresh statistics, updated from the LVGL task
+    bool refresh_hooked_ = false;
+    RefreshStats refresh_stats_;
+    int64_t refresh_start_us_ = 0;
+    int64_t wait_start_us_ = 0;
+    int64_t refresh_wait_us_ = 0;
+    int refresh_flushes_ = 0;
+    // Snapshot taken by the previous GetGovernorStats call
+    uint32_t stats_frames_ = 0;
+    uint64_t stats_refresh_us_ = 0;
+    int64_t stats_time_us_ = 0;
+
+    void ScheduleGovernor();
+    void ApplyGovernor();
+    static void RefreshEventCallback(lv_event_t* e);
 };
 
 
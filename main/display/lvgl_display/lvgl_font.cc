@@ -1,13 +1,138 @@
 #include "lvgl_font.h"
 #include <cbin_font.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+#include <vector>
+
+#define TAG "LvglFont"
+
+#if CONFIG_FONT_GLYPH_CACHE_SIZE > 0
+#define FONT_GLYPH_CACHE_ENABLED 1
+#define FONT_GLYPH_CACHE_BUDGET (CONFIG_FONT_GLYPH_CACHE_SIZE * 1024)
+#endif
 
 
 LvglCBinFont::LvglCBinFont(void* data) {
     font_ = cbin_font_create(static_cast<uint8_t*>(data));
+#if FONT_GLYPH_CACHE_ENABLED
+    if (font_ != nullptr && font_->get_glyph_bitmap != nullptr) {
+        cached_font_.font = *font_;
+        cached_font_.font.get_glyph_bitmap = GetGlyphBitmap;
+        cached_font_.owner = this;
+        get_glyph_bitmap_ = font_->get_glyph_bitmap;
+    }
+#endif
 }
 
 LvglCBinFont::~LvglCBinFont() {
+    for (auto& glyph : glyphs_) {
+        heap_caps_free(glyph.data);
+    }
     if (font_ != nullptr) {
         cbin_font_delete(font_);
     }
-}
\ No newline at end of file
+}
+
+const lv_font_t* LvglCBinFont::font() const {
+    if (font_ == nullptr || get_glyph_bitmap_ == nullptr) {
+        return font_;
+    }
+    return &cached_font_.font;
+}
+
+const void* LvglCBinFont::GetGlyphBitmap(lv_font_glyph_dsc_t* g_dsc, lv_draw_buf_t* draw_buf) {
+    // LVGL asks the resolved font for the bitmap, which is always our copy here
+    auto self = reinterpret_cast<const CachedFont*>(g_dsc->resolved_font)->owner;
+    if (draw_buf == nullptr || g_dsc->req_raw_bitmap) {
+        return self->get_glyph_bitmap_(g_dsc, draw_buf);
+    }
+
+    // The draw buffer has already been shaped for the glyph box
+    uint32_t stride = draw_buf->header.stride;
+    uint32_t size = stride * g_dsc->box_h;
+    if (size == 0 || size > draw_buf->data_size) {
+        return self->get_glyph_bitmap_(g_dsc, draw_buf);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(self->cache_mutex_);
+        auto it = self->glyph_map_.find(g_dsc->gid.index);
+        if (it != self->glyph_map_.end() && it->second->stride == stride && it->second->size == size) {
+            self->glyphs_.splice(self->glyphs_.begin(), self->glyphs_, it->second);
+            memcpy(draw_buf->data, it->second->data, size);
+            return draw_buf;
+        }
+    }
+
+    const void* bitmap = self->get_glyph_bitmap_(g_dsc, draw_buf);
+    if (bitmap == draw_buf) {
+        self->AddGlyph(g_dsc->gid.index, stride, size, draw_buf->data);
+    }
+    return bitmap;
+}
+
+void LvglCBinFont::AddGlyph(uint32_t index, uint32_t stride, uint32_t size, const uint8_t* data) {
+#if FONT_GLYPH_CACHE_ENABLED
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = glyph_map_.find(index);
+    if (it != glyph_map_.end()) {
+        // Another draw unit got here first, or the glyph was drawn with another stride
+        cache_used_ -= it->second->size;
+        heap_caps_free(it->second->data);
+        glyphs_.erase(it->second);
+        glyph_map_.erase(it);
+    }
+
+    while (!glyphs_.empty() && cache_used_ + size > FONT_GLYPH_CACHE_BUDGET) {
+        auto& oldest = glyphs_.back();
+        cache_used_ -= oldest.size;
+        heap_caps_free(oldest.data);
+        glyph_map_.erase(oldest.index);
+        glyphs_.pop_back();
+    }
+
+    auto copy = (uint8_t*)heap_caps_malloc_prefer(size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+    if (copy == nullptr) {
+        return;
+    }
+    memcpy(copy, data, size);
+    glyphs_.push_front({index, stride, size, copy});
+    glyph_map_[index] = glyphs_.begin();
+    cache_used_ += size;
+#endif
+}
+
+void LvglCBinFont::WarmUp(const char* text) {
+    if (get_glyph_bitmap_ == nullptr || text == nullptr) {
+        return;
+    }
+
+    const lv_font_t* font = &cached_font_.font;
+    std::vector<uint8_t> buffer;
+    lv_draw_buf_t draw_buf;
+    int count = 0;
+    uint32_t i = 0;
+    uint32_t letter;
+    while ((letter = lv_text_encoded_next(text, &i)) != 0) {
+        lv_font_glyph_dsc_t g_dsc = {};
+        if (!lv_font_get_glyph_dsc(font, &g_dsc, letter, 0) || g_dsc.resolved_font != font) {
+            continue;
+        }
+        // Only bitmap glyphs are cached, the same check LVGL uses before drawing a letter
+        if (g_dsc.format <= LV_FONT_GLYPH_FORMAT_NONE || g_dsc.format >= LV_FONT_GLYPH_FORMAT_IMAGE || g_dsc.box_w == 0) {
+            continue;
+        }
+        uint32_t stride = lv_draw_buf_width_to_stride(g_dsc.box_w, LV_COLOR_FORMAT_A8);
+        if (buffer.size() < stride * g_dsc.box_h) {
+            buffer.resize(stride * g_dsc.box_h);
+        }
+        if (lv_draw_buf_init(&draw_buf, g_dsc.box_w, g_dsc.box_h, LV_COLOR_FORMAT_A8, stride,
+                buffer.data(), buffer.size()) != LV_RESULT_OK) {
+            continue;
+        }
+        lv_font_get_glyph_bitmap(&g_dsc, &draw_buf);
+        count++;
+    }
+    ESP_LOGI(TAG, "Warmed up %d glyphs, glyph cache uses %u KB", count, (unsigned)(cache_used_ / 1024));
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <lvgl.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 
 class LvglFont {
@@ -20,12 +23,46 @@ private:
 };
 
 
+/**
+ * Font from a cbin file in the assets partition
+ *
+ * Glyph bitmaps are read from the mmapped flash and expanded to A8 on every draw. With
+ * CONFIG_FONT_GLYPH_CACHE_SIZE the expanded bitmaps of recently drawn glyphs are kept in
+ * an LRU cache, so redrawing CJK text does not keep missing the flash cache.
+ */
 class LvglCBinFont : public LvglFont {
 public:
     LvglCBinFont(void* data);
     virtual ~LvglCBinFont();
-    virtual const lv_font_t* font() const override { return font_; }
+    virtual const lv_font_t* font() const override;
+
+    // Render the glyphs of a UTF-8 string into the glyph cache, the display must be locked
+    void WarmUp(const char* text);
 
 private:
+    // Copy of the cbin font with the bitmap callback replaced, the callback finds the owner from it
+    struct CachedFont {
+        lv_font_t font;
+        LvglCBinFont* owner;
+    };
+
+    struct CachedGlyph {
+        uint32_t index;
+        uint32_t stride;
+        uint32_t size;
+        uint8_t* data;
+    };
+
     lv_font_t* font_;
+    CachedFont cached_font_ = {};
+    const void* (*get_glyph_bitmap_)(lv_font_glyph_dsc_t*, lv_draw_buf_t*) = nullptr;
+
+    // Glyphs may be drawn by several draw units at once
+    std::mutex cache_mutex_;
+    std::list<CachedGlyph> glyphs_;     // Most recently used first
+    std::unordered_map<uint32_t, std::list<CachedGlyph>::iterator> glyph_map_;
+    size_t cache_used_ = 0;
+
+    static const void* GetGlyphBitmap(lv_font_glyph_dsc_t* g_dsc, lv_draw_buf_t* draw_buf);
+    void AddGlyph(uint32_t index, uint32_t stride, uint32_t size, const uint8_t* data);
 };
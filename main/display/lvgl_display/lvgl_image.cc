@@ -1,4 +1,5 @@
 #include "lvgl_image.h"
+#include "lvgl_animation.h"
 #include <cbin_font.h>
 
 #include <esp_log.h>
@@ -24,6 +25,10 @@ bool LvglRawImage::IsGif() const {
     return ptr[0] == 'G' && ptr[1] == 'I' && ptr[2] == 'F';
 }
 
+bool LvglRawImage::IsAnimation() const {
+    return LvglAnimation::IsAnimation(image_dsc_.data, image_dsc_.data_size);
+}
+
 LvglCBinImage::LvglCBinImage(void* data) {
     image_dsc_ = cbin_img_dsc_create(static_cast<uint8_t*>(data));
 }
@@ -61,4 +66,26 @@ LvglAllocatedImage::~LvglAllocatedImage() {
         heap_caps_free((void*)image_dsc_.data);
         image_dsc_.data = nullptr;
     }
-}
\ No newline at end of file
+}
+LvglSharedImage::LvglSharedImage(std::shared_ptr<const void> owner, const void* data, size_t size, int width, int height, int stride, int color_format)
+    : owner_(std::move(owner)) {
+    bzero(&image_dsc_, sizeof(image_dsc_));
+    image_dsc_.data_size = size;
+    image_dsc_.data = static_cast<const uint8_t*>(data);
+    image_dsc_.header.magic = LV_IMAGE_HEADER_MAGIC;
+    image_dsc_.header.cf = color_format;
+    image_dsc_.header.w = width;
+    image_dsc_.header.h = height;
+    image_dsc_.header.stride = stride;
+}
+
+std::unique_ptr<LvglImage> LvglSharedImage::Copy() const {
+    void* data = heap_caps_malloc(image_dsc_.data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (data == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %lu bytes for image copy", image_dsc_.data_size);
+        return nullptr;
+    }
+    memcpy(data, image_dsc_.data, image_dsc_.data_size);
+    return std::make_unique<LvglAllocatedImage>(data, image_dsc_.data_size, image_dsc_.header.w, image_dsc_.header.h,
+        image_dsc_.header.stride, image_dsc_.header.cf);
+}
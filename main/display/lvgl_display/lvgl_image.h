@@ -1,6 +1,7 @@
 #pragma once
 
 #include <lvgl.h>
+#include <memory>
 
 
 // Wrap around lv_img_dsc_t
@@ -8,6 +9,7 @@ class LvglImage {
 public:
     virtual const lv_img_dsc_t* image_dsc() const = 0;
     virtual bool IsGif() const { return false; }
+    virtual bool IsAnimation() const { return false; }
     virtual ~LvglImage() = default;
 };
 
@@ -17,6 +19,7 @@ public:
     LvglRawImage(void* data, size_t size);
     virtual const lv_img_dsc_t* image_dsc() const override { return &image_dsc_; }
     virtual bool IsGif() const;
+    virtual bool IsAnimation() const;
 
 private:
     lv_img_dsc_t image_dsc_;
@@ -50,4 +53,16 @@ public:
 
 private:
     lv_img_dsc_t image_dsc_;
-};
\ No newline at end of file
+};
+// Borrows pixels owned by another object (e.g. a camera frame) and keeps that owner alive
+class LvglSharedImage : public LvglImage {
+public:
+    LvglSharedImage(std::shared_ptr<const void> owner, const void* data, size_t size, int width, int height, int stride, int color_format);
+    virtual const lv_img_dsc_t* image_dsc() const override { return &image_dsc_; }
+    // Private copy for holders that keep the image indefinitely, nullptr if out of memory
+    std::unique_ptr<LvglImage> Copy() const;
+
+private:
+    std::shared_ptr<const void> owner_;
+    lv_img_dsc_t image_dsc_;
+};
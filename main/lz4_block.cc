@@ -0,0 +1,63 @@
+#include "lz4_block.h"
+
+#include <cstring>
+
+bool Lz4DecompressBlock(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + src_size;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dst_size;
+
+    auto read_length = [&ip, iend](size_t& length) -> bool {
+        uint8_t b;
+        do {
+            if (ip >= iend) {
+                return false;
+            }
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(literal_length)) {
+            return false;
+        }
+        if (literal_length > (size_t)(iend - ip) || literal_length > (size_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // The last sequence only carries literals
+        if (ip >= iend) {
+            break;
+        }
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return false;
+        }
+        size_t match_length = token & 0x0F;
+        if (match_length == 15 && !read_length(match_length)) {
+            return false;
+        }
+        match_length += 4;
+        if (match_length > (size_t)(oend - op)) {
+            return false;
+        }
+        // Matches may overlap the output, copy byte by byte
+        const uint8_t* match = op - offset;
+        while (match_length--) {
+            *op++ = *match++;
+        }
+    }
+    return op == oend;
+}
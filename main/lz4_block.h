@@ -0,0 +1,11 @@
+#ifndef _LZ4_BLOCK_H_
+#define _LZ4_BLOCK_H_
+
+#include <cstdint>
+#include <cstddef>
+
+// Decode a raw LZ4 block (no frame header), every copy is bounds checked against both buffers.
+// Returns true only if the block decodes to exactly dst_size bytes.
+bool Lz4DecompressBlock(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size);
+
+#endif // _LZ4_BLOCK_H_
@@ -15,11 +15,44 @@
 #include "oled_display.h"
 #include "board.h"
 #include "settings.h"
+#include "trace.h"
 #include "lvgl_theme.h"
 #include "lvgl_display.h"
+#include "lcd_display.h"
 
 #define TAG "MCP"
 
+#define BACKGROUND_TOOL_STACK_SIZE (4096 * 2)
+#define BACKGROUND_TOOL_PRIORITY 2
+
+// Collects the replies of a JSON-RPC batch request. Every pending call holds a reference, so the
+// array is sent once, when the last call of the batch has replied.
+class McpBatchReply {
+public:
+    ~McpBatchReply() {
+        // A batch of notifications gets no reply at all
+        if (replies_.empty()) {
+            return;
+        }
+        std::string payload = "[";
+        for (auto& reply : replies_) {
+            payload += reply;
+            payload += ",";
+        }
+        payload.back() = ']';
+        Application::GetInstance().SendMcpMessage(payload);
+    }
+
+    void Add(std::string payload) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        replies_.push_back(std::move(payload));
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> replies_;
+};
+
 McpServer::McpServer() {
 }
 
@@ -28,6 +61,7 @@ McpServer::~McpServer() {
         delete tool;
     }
     tools_.clear();
+    tools_by_name_.clear();
 }
 
 void McpServer::AddCommonTools() {
@@ -52,27 +86,32 @@ void McpServer::AddCommonTools() {
             return board.GetDeviceStatusJson();
         });
 
-    AddTool("self.audio_speaker.set_volume", 
+    struct VolumeArgs {
+        int volume;
+    };
+    AddTool<VolumeArgs>("self.audio_speaker.set_volume", 
         "Set the volume of the audio speaker. If the current volume is unknown, you must call `self.get_device_status` tool first and then call this tool.",
-        PropertyList({
-            Property("volume", kPropertyTypeInteger, 0, 100)
-        }), 
-        [&board](const PropertyList& properties) -> ReturnValue {
+        {
+            McpArgument("volume", &VolumeArgs::volume, 0, 100)
+        }, 
+        [&board](const VolumeArgs& args) -> ReturnValue {
             auto codec = board.GetAudioCodec();
-            codec->SetOutputVolume(properties["volume"].value<int>());
+            codec->SetOutputVolume(args.volume);
             return true;
         });
     
     auto backlight = board.GetBacklight();
     if (backlight) {
-        AddTool("self.screen.set_brightness",
+        struct BrightnessArgs {
+            int brightness;
+        };
+        AddTool<BrightnessArgs>("self.screen.set_brightness",
             "Set the brightness of the screen.",
-            PropertyList({
-                Property("brightness", kPropertyTypeInteger, 0, 100)
-            }),
-            [backlight](const PropertyList& properties) -> ReturnValue {
-                uint8_t brightness = static_cast<uint8_t>(properties["brightness"].value<int>());
-                backlight->SetBrightness(brightness, true);
+            {
+                McpArgument("brightness", &BrightnessArgs::brightness, 0, 100)
+            },
+            [backlight](const BrightnessArgs& args) -> ReturnValue {
+                backlight->SetBrightness(static_cast<uint8_t>(args.brightness), true);
                 return true;
             });
     }
@@ -99,14 +138,24 @@ void McpServer::AddCommonTools() {
 
     auto camera = board.GetCamera();
     if (camera) {
+        CameraExplainOptions default_options;
         AddTool("self.camera.take_photo",
             "Always remember you have a camera. If the user asks you to see something, use this tool to take a photo and then explain it.\n"
             "Args:\n"
             "  `question`: The question that you want to ask about the photo.\n"
+            "  `quality`: JPEG quality of the uploaded photo.\n"
+            "  `max_size`: Long edge of the uploaded photo in pixels, 0 for the full camera resolution.\n"
+            "  `roi_x`, `roi_y`, `roi_width`, `roi_height`: Only upload this region, in percent of the photo.\n"
             "Return:\n"
             "  A JSON object that provides the photo information.",
             PropertyList({
-                Property("question", kPropertyTypeString)
+                Property("question", kPropertyTypeString),
+                Property("quality", kPropertyTypeInteger, default_options.quality, 10, 95),
+                Property("max_size", kPropertyTypeInteger, default_options.max_size, 0, 4096),
+                Property("roi_x", kPropertyTypeInteger, 0, 0, 99),
+                Property("roi_y", kPropertyTypeInteger, 0, 0, 99),
+                Property("roi_width", kPropertyTypeInteger, 100, 1, 100),
+                Property("roi_height", kPropertyTypeInteger, 100, 1, 100)
             }),
             [camera](const PropertyList& properties) -> ReturnValue {
                 // Lower the priority to do the camera capture
@@ -116,7 +165,45 @@ void McpServer::AddCommonTools() {
                     throw std::runtime_error("Failed to capture photo");
                 }
                 auto question = properties["question"].value<std::string>();
-                return camera->Explain(question);
+                CameraExplainOptions options;
+                options.quality = properties["quality"].value<int>();
+                options.max_size = properties["max_size"].value<int>();
+                options.roi_x = properties["roi_x"].value<int>();
+                options.roi_y = properties["roi_y"].value<int>();
+                options.roi_width = properties["roi_width"].value<int>();
+                options.roi_height = properties["roi_height"].value<int>();
+                return camera->Explain(question, options);
+            })->set_execution(kMcpToolBackground);
+
+        AddTool("self.camera.start_stream",
+            "Start streaming camera frames as JPEG over the current conversation channel. Use it when the user needs live vision, "
+            "for example asking what they are holding. The stream stops when the conversation ends.\n"
+            "Args:\n"
+            "  `fps`: Target frame rate, frames are skipped when the network can't keep up.\n"
+            "  `quality`: JPEG quality, lowered automatically under congestion.\n"
+            "  `bitrate_kbps`: Target bitrate, 0 keeps the quality fixed.",
+            PropertyList({
+                Property("fps", kPropertyTypeInteger, 2, 1, 15),
+                Property("quality", kPropertyTypeInteger, 60, 10, 95),
+                Property("bitrate_kbps", kPropertyTypeInteger, 0, 0, 4000)
+            }),
+            [](const PropertyList& properties) -> ReturnValue {
+                CameraStreamConfig config;
+                config.fps = properties["fps"].value<int>();
+                config.quality = properties["quality"].value<int>();
+                config.bitrate_kbps = properties["bitrate_kbps"].value<int>();
+                if (!Application::GetInstance().StartCameraStream(config)) {
+                    throw std::runtime_error("Failed to start camera stream");
+                }
+                return true;
+            });
+
+        AddTool("self.camera.stop_stream",
+            "Stop streaming camera frames.",
+            PropertyList(),
+            [](const PropertyList& properties) -> ReturnValue {
+                Application::GetInstance().StopCameraStream();
+                return true;
             });
     }
 #endif
@@ -135,6 +222,28 @@ void McpServer::AddUserOnlyTools() {
             return board.GetSystemInfoJson();
         });
 
+    AddUserOnlyTool("self.trace.dump",
+        "Export the boot and latency trace in Chrome trace format (open in chrome://tracing or Perfetto).\n"
+        "Args:\n"
+        "  `serial`: Print the trace to the serial console instead of returning it\n"
+        "  `clear`: Clear the trace buffer after exporting",
+        PropertyList({
+            Property("serial", kPropertyTypeBoolean, false),
+            Property("clear", kPropertyTypeBoolean, false)
+        }),
+        [](const PropertyList& properties) -> ReturnValue {
+            ReturnValue result = true;
+            if (properties["serial"].value<bool>()) {
+                Trace::DumpToSerial();
+            } else {
+                result = Trace::ToChromeJson();
+            }
+            if (properties["clear"].value<bool>()) {
+                Trace::Clear();
+            }
+            return result;
+        });
+
     AddUserOnlyTool("self.reboot", "Reboot the system",
         PropertyList(),
         [this](const PropertyList& properties) -> ReturnValue {
@@ -151,20 +260,37 @@ void McpServer::AddUserOnlyTools() {
     // Firmware upgrade
     AddUserOnlyTool("self.upgrade_firmware", "Upgrade firmware from a specific URL. This will download and install the firmware, then reboot the device.",
         PropertyList({
-            Property("url", kPropertyTypeString, "The URL of the firmware binary file to download and install")
+            Property("url", kPropertyTypeString, "The URL of the firmware binary file to download and install"),
+            Property("sha256", kPropertyTypeString, std::string(""))
         }),
         [this](const PropertyList& properties) -> ReturnValue {
             auto url = properties["url"].value<std::string>();
+            auto sha256 = properties["sha256"].value<std::string>();
             ESP_LOGI(TAG, "User requested firmware upgrade from URL: %s", url.c_str());
-            
-            auto& app = Application::GetInstance();
-            app.Schedule([url, &app]() {
-                bool success = app.UpgradeFirmware(url);
+
+            bool expected = false;
+            if (!upgrading_.compare_exchange_strong(expected, true)) {
+                throw std::runtime_error("A firmware upgrade is already in progress");
+            }
+
+            // Upgrade on its own task like the activation task does, the main loop keeps
+            // running to show the progress and the call is answered right away
+            auto args = new std::pair<std::string, std::string>(url, sha256);
+            BaseType_t ret = xTaskCreate([](void* arg) {
+                auto args = static_cast<std::pair<std::string, std::string>*>(arg);
+                bool success = Application::GetInstance().UpgradeFirmware(args->first, "", args->second);
                 if (!success) {
                     ESP_LOGE(TAG, "Firmware upgrade failed");
+                    McpServer::GetInstance().upgrading_ = false;
                 }
-            });
-            
+                delete args;
+                vTaskDelete(NULL);
+            }, "upgrade", 4096 * 2, args, 2, nullptr);
+            if (ret != pdPASS) {
+                delete args;
+                upgrading_ = false;
+                throw std::runtime_error("Failed to start firmware upgrade");
+            }
             return true;
         });
 
@@ -172,7 +298,7 @@ void McpServer::AddUserOnlyTools() {
 #ifdef HAVE_LVGL
     auto display = dynamic_cast<LvglDisplay*>(Board::GetInstance().GetDisplay());
     if (display) {
-        AddUserOnlyTool("self.screen.get_info", "Information about the screen, including width, height, etc.",
+        AddUserOnlyTool("self.screen.get_info", "Information about the screen, including width, height, refresh statistics since the previous call, and the draw buffer timings of SPI LCDs.",
             PropertyList(),
             [display](const PropertyList& properties) -> ReturnValue {
                 cJSON *json = cJSON_CreateObject();
@@ -183,6 +309,30 @@ void McpServer::AddUserOnlyTools() {
                 } else {
                     cJSON_AddBoolToObject(json, "monochrome", false);
                 }
+                auto stats = display->GetGovernorStats();
+                cJSON *refresh = cJSON_CreateObject();
+                cJSON_AddStringToObject(refresh, "level", stats.level);
+                cJSON_AddNumberToObject(refresh, "period_ms", stats.refresh_period_ms);
+                cJSON_AddNumberToObject(refresh, "frames", stats.frames);
+                cJSON_AddNumberToObject(refresh, "fps", stats.fps);
+                cJSON_AddNumberToObject(refresh, "render_load", stats.render_load);
+                cJSON_AddNumberToObject(refresh, "suspended_ms", stats.suspended_ms);
+                cJSON_AddItemToObject(json, "refresh", refresh);
+                auto spi_display = dynamic_cast<SpiLcdDisplay*>(display);
+                if (spi_display) {
+                    auto draw = spi_display->GetRefreshStats();
+                    cJSON *draw_buffers = cJSON_CreateObject();
+                    cJSON_AddNumberToObject(draw_buffers, "lines", spi_display->buffer_lines());
+                    cJSON_AddBoolToObject(draw_buffers, "double_buffered", spi_display->double_buffered());
+                    cJSON_AddNumberToObject(draw_buffers, "frames", draw.frames);
+                    if (draw.frames > 0) {
+                        cJSON_AddNumberToObject(draw_buffers, "avg_render_us", draw.total_render_us / draw.frames);
+                        cJSON_AddNumberToObject(draw_buffers, "avg_wait_us", draw.total_wait_us / draw.frames);
+                    }
+                    cJSON_AddNumberToObject(draw_buffers, "max_render_us", draw.max_render_us);
+                    cJSON_AddNumberToObject(draw_buffers, "max_wait_us", draw.max_wait_us);
+                    cJSON_AddItemToObject(json, "draw_buffers", draw_buffers);
+                }
                 return json;
             });
 
@@ -196,13 +346,6 @@ void McpServer::AddUserOnlyTools() {
                 auto url = properties["url"].value<std::string>();
                 auto quality = properties["quality"].value<int>();
 
-                std::string jpeg_data;
-                if (!display->SnapshotToJpeg(jpeg_data, quality)) {
-                    throw std::runtime_error("Failed to snapshot screen");
-                }
-
-                ESP_LOGI(TAG, "Upload snapshot %u bytes to %s", jpeg_data.size(), url.c_str());
-                
                 // 构造multipart/form-data请求体
                 std::string boundary = "----ESP32_SCREEN_SNAPSHOT_BOUNDARY";
                 
@@ -221,8 +364,18 @@ void McpServer::AddUserOnlyTools() {
                     http->Write(file_header.c_str(), file_header.size());
                 }
 
-                // JPEG数据
-                http->Write((const char*)jpeg_data.data(), jpeg_data.size());
+                // JPEG数据，在显示锁内分带编码完成后上传
+                size_t jpeg_size = 0;
+                bool encoded = display->SnapshotToJpeg([&http, &jpeg_size](const void* data, size_t len) {
+                    http->Write(static_cast<const char*>(data), len);
+                    jpeg_size += len;
+                }, quality);
+                if (!encoded) {
+                    // 不发送尾部和结束块，直接断开，服务器不会把不完整的图片当作上传成功
+                    http->Close();
+                    throw std::runtime_error("Failed to snapshot screen");
+                }
+                ESP_LOGI(TAG, "Uploaded snapshot %u bytes to %s", jpeg_size, url.c_str());
 
                 {
                     // multipart尾部
@@ -239,7 +392,7 @@ void McpServer::AddUserOnlyTools() {
                 http->Close();
                 ESP_LOGI(TAG, "Snapshot screen result: %s", result.c_str());
                 return true;
-            });
+            })->set_execution(kMcpToolBackground);
         
         AddUserOnlyTool("self.screen.preview_image", "Preview an image on the screen",
             PropertyList({
@@ -279,7 +432,7 @@ void McpServer::AddUserOnlyTools() {
                 auto image = std::make_unique<LvglAllocatedImage>(data, content_length);
                 display->SetPreviewImage(std::move(image));
                 return true;
-            });
+            })->set_execution(kMcpToolBackground);
 #endif // CONFIG_LV_USE_SNAPSHOT
     }
 #endif // HAVE_LVGL
@@ -287,38 +440,60 @@ void McpServer::AddUserOnlyTools() {
     // Assets download url
     auto& assets = Assets::GetInstance();
     if (assets.partition_valid()) {
-        AddUserOnlyTool("self.assets.set_download_url", "Set the download url for the assets",
+        AddUserOnlyTool("self.assets.set_download_url", "Set the download url for the assets, optionally with the expected SHA-256 of the file",
             PropertyList({
-                Property("url", kPropertyTypeString)
+                Property("url", kPropertyTypeString),
+                Property("sha256", kPropertyTypeString, std::string(""))
             }),
             [](const PropertyList& properties) -> ReturnValue {
                 auto url = properties["url"].value<std::string>();
+                auto sha256 = properties["sha256"].value<std::string>();
                 Settings settings("assets", true);
                 settings.SetString("download_url", url);
+                settings.SetString("download_sha256", sha256);
                 return true;
             });
+
+        if (assets.ab_layout()) {
+            AddUserOnlyTool("self.assets.switch_bank", "Switch to the assets in the other A/B bank without downloading them again",
+                PropertyList(),
+                [&assets](const PropertyList& properties) -> ReturnValue {
+                    // SwitchBank applies the new bank and rebuilds the emoji under the display lock
+                    // before the old bank is unmapped
+                    return assets.SwitchBank();
+                });
+        }
     }
 }
 
-void McpServer::AddTool(McpTool* tool) {
+McpTool* McpServer::AddTool(McpTool* tool) {
     // Prevent adding duplicate tools
-    if (std::find_if(tools_.begin(), tools_.end(), [tool](const McpTool* t) { return t->name() == tool->name(); }) != tools_.end()) {
+    auto [it, added] = tools_by_name_.emplace(tool->name(), tool);
+    if (!added) {
         ESP_LOGW(TAG, "Tool %s already added", tool->name().c_str());
-        return;
+        delete tool;
+        return it->second;
     }
 
     ESP_LOGI(TAG, "Add tool: %s%s", tool->name().c_str(), tool->user_only() ? " [user]" : "");
     tools_.push_back(tool);
+    return tool;
 }
 
-void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
-    AddTool(new McpTool(name, description, properties, callback));
+McpTool* McpServer::FindTool(const std::string& name) const {
+    auto it = tools_by_name_.find(name);
+    return it != tools_by_name_.end() ? it->second : nullptr;
 }
 
-void McpServer::AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
+McpTool* McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
+    auto tool = new McpTool(name, description, properties, callback);
+    return AddTool(tool);
+}
+
+McpTool* McpServer::AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
     auto tool = new McpTool(name, description, properties, callback);
     tool->set_user_only(true);
-    AddTool(tool);
+    return AddTool(tool);
 }
 
 void McpServer::ParseMessage(const std::string& message) {
@@ -351,10 +526,35 @@ void McpServer::ParseCapabilities(const cJSON* capabilities) {
 }
 
 void McpServer::ParseMessage(const cJSON* json) {
+    if (!cJSON_IsArray(json)) {
+        ParseRequest(json, nullptr);
+        return;
+    }
+
+    // Batch request, the calls run concurrently according to their execution class and the
+    // replies are sent back together in one array
+    if (cJSON_GetArraySize(json) == 0) {
+        ESP_LOGE(TAG, "Empty batch request");
+        return;
+    }
+    auto batch = std::make_shared<McpBatchReply>();
+    const cJSON* item;
+    cJSON_ArrayForEach(item, json) {
+        if (!cJSON_IsObject(item)) {
+            ESP_LOGE(TAG, "Invalid request in batch");
+            ReplyInvalidRequest(nullptr, batch);
+            continue;
+        }
+        ParseRequest(item, batch);
+    }
+}
+
+void McpServer::ParseRequest(const cJSON* json, const std::shared_ptr<McpBatchReply>& batch) {
     // Check JSONRPC version
     auto version = cJSON_GetObjectItem(json, "jsonrpc");
     if (version == nullptr || !cJSON_IsString(version) || strcmp(version->valuestring, "2.0") != 0) {
-        ESP_LOGE(TAG, "Invalid JSONRPC version: %s", version ? version->valuestring : "null");
+        ESP_LOGE(TAG, "Invalid JSONRPC version: %s", cJSON_IsString(version) ? version->valuestring : "null");
+        ReplyInvalidRequest(cJSON_GetObjectItem(json, "id"), batch);
         return;
     }
     
@@ -362,6 +562,7 @@ void McpServer::ParseMessage(const cJSON* json) {
     auto method = cJSON_GetObjectItem(json, "method");
     if (method == nullptr || !cJSON_IsString(method)) {
         ESP_LOGE(TAG, "Missing method");
+        ReplyInvalidRequest(cJSON_GetObjectItem(json, "id"), batch);
         return;
     }
     
@@ -395,7 +596,7 @@ void McpServer::ParseMessage(const cJSON* json) {
         std::string message = "{\"protocolVersion\":\"2024-11-05\",\"capabilities\":{\"tools\":{}},\"serverInfo\":{\"name\":\"" BOARD_NAME "\",\"version\":\"";
         message += app_desc->version;
         message += "\"}}";
-        ReplyResult(id_int, message);
+        ReplyResult(id_int, message, batch);
     } else if (method_str == "tools/list") {
         std::string cursor_str = "";
         bool list_user_only_tools = false;
@@ -409,83 +610,95 @@ void McpServer::ParseMessage(const cJSON* json) {
                 list_user_only_tools = with_user_tools->valueint == 1;
             }
         }
-        GetToolsList(id_int, cursor_str, list_user_only_tools);
+        GetToolsList(id_int, cursor_str, list_user_only_tools, batch);
     } else if (method_str == "tools/call") {
         if (!cJSON_IsObject(params)) {
             ESP_LOGE(TAG, "tools/call: Missing params");
-            ReplyError(id_int, "Missing params");
+            ReplyError(id_int, "Missing params", batch);
             return;
         }
         auto tool_name = cJSON_GetObjectItem(params, "name");
         if (!cJSON_IsString(tool_name)) {
             ESP_LOGE(TAG, "tools/call: Missing name");
-            ReplyError(id_int, "Missing name");
+            ReplyError(id_int, "Missing name", batch);
             return;
         }
         auto tool_arguments = cJSON_GetObjectItem(params, "arguments");
         if (tool_arguments != nullptr && !cJSON_IsObject(tool_arguments)) {
             ESP_LOGE(TAG, "tools/call: Invalid arguments");
-            ReplyError(id_int, "Invalid arguments");
+            ReplyError(id_int, "Invalid arguments", batch);
             return;
         }
-        DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments);
+        DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments, batch);
     } else {
         ESP_LOGE(TAG, "Method not implemented: %s", method_str.c_str());
-        ReplyError(id_int, "Method not implemented: " + method_str);
+        ReplyError(id_int, "Method not implemented: " + method_str, batch);
     }
 }
 
-void McpServer::ReplyResult(int id, const std::string& result) {
+void McpServer::ReplyResult(int id, const std::string& result, const std::shared_ptr<McpBatchReply>& batch) {
     std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
     payload += std::to_string(id) + ",\"result\":";
     payload += result;
     payload += "}";
-    Application::GetInstance().SendMcpMessage(payload);
+    SendReply(std::move(payload), batch);
 }
 
-void McpServer::ReplyError(int id, const std::string& message) {
+void McpServer::ReplyError(int id, const std::string& message, const std::shared_ptr<McpBatchReply>& batch) {
     std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
     payload += std::to_string(id);
     payload += ",\"error\":{\"message\":\"";
     payload += message;
     payload += "\"}}";
-    Application::GetInstance().SendMcpMessage(payload);
+    SendReply(std::move(payload), batch);
+}
+
+// JSON-RPC "Invalid Request" error, the id is null when the request has no usable one
+void McpServer::ReplyInvalidRequest(const cJSON* id, const std::shared_ptr<McpBatchReply>& batch) {
+    std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
+    payload += cJSON_IsNumber(id) ? std::to_string(id->valueint) : "null";
+    payload += ",\"error\":{\"code\":-32600,\"message\":\"Invalid Request\"}}";
+    SendReply(std::move(payload), batch);
 }
 
-void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_only_tools) {
+void McpServer::SendReply(std::string payload, const std::shared_ptr<McpBatchReply>& batch) {
+    if (batch) {
+        batch->Add(std::move(payload));
+    } else {
+        Application::GetInstance().SendMcpMessage(payload);
+    }
+}
+
+void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_only_tools, const std::shared_ptr<McpBatchReply>& batch) {
     const int max_payload_size = 8000;
-    std::string json = "{\"tools\":[";
-    
-    bool found_cursor = cursor.empty();
+    std::string json;
+    json.reserve(max_payload_size);
+    json = "{\"tools\":[";
+
+    // The tool JSON is cached on first use, later lists only copy strings
+    std::lock_guard<std::mutex> lock(tools_list_mutex_);
     auto it = tools_.begin();
+    if (!cursor.empty()) {
+        // 从游标指向的工具开始
+        it = std::find(tools_.begin(), tools_.end(), FindTool(cursor));
+    }
     std::string next_cursor = "";
     
-    while (it != tools_.end()) {
-        // 如果我们还没有找到起始位置，继续搜索
-        if (!found_cursor) {
-            if ((*it)->name() == cursor) {
-                found_cursor = true;
-            } else {
-                ++it;
-                continue;
-            }
-        }
-
+    for (; it != tools_.end(); ++it) {
         if (!list_user_only_tools && (*it)->user_only()) {
-            ++it;
             continue;
         }
         
         // 添加tool前检查大小
-        std::string tool_json = (*it)->to_json() + ",";
-        if (json.length() + tool_json.length() + 30 > max_payload_size) {
+        const std::string& tool_json = (*it)->json();
+        if (json.length() + tool_json.length() + 1 + 30 > max_payload_size) {
             // 如果添加这个tool会超出大小限制，设置next_cursor并退出循环
             next_cursor = (*it)->name();
             break;
         }
         
         json += tool_json;
-        ++it;
+        json += ',';
     }
     
     if (json.back() == ',') {
@@ -495,7 +708,7 @@ void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_o
     if (json.back() == '[' && !tools_.empty()) {
         // 如果没有添加任何tool，返回错误
         ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
-        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
+        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit", batch);
         return;
     }
 
@@ -505,59 +718,96 @@ void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_o
         json += "],\"nextCursor\":\"" + next_cursor + "\"}";
     }
     
-    ReplyResult(id, json);
+    ReplyResult(id, json, batch);
 }
 
-void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments) {
-    auto tool_iter = std::find_if(tools_.begin(), tools_.end(), 
-                                 [&tool_name](const McpTool* tool) { 
-                                     return tool->name() == tool_name; 
-                                 });
-    
-    if (tool_iter == tools_.end()) {
+void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, const std::shared_ptr<McpBatchReply>& batch) {
+    McpTool* tool = FindTool(tool_name);
+    if (tool == nullptr) {
         ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
-        ReplyError(id, "Unknown tool: " + tool_name);
+        ReplyError(id, "Unknown tool: " + tool_name, batch);
         return;
     }
 
-    PropertyList arguments = (*tool_iter)->properties();
+    // Arguments are decoded before the call is queued, so bad arguments are answered right away
+    std::function<ReturnValue()> bound_call;
     try {
-        for (auto& argument : arguments) {
-            bool found = false;
-            if (cJSON_IsObject(tool_arguments)) {
-                auto value = cJSON_GetObjectItem(tool_arguments, argument.name().c_str());
-                if (argument.type() == kPropertyTypeBoolean && cJSON_IsBool(value)) {
-                    argument.set_value<bool>(value->valueint == 1);
-                    found = true;
-                } else if (argument.type() == kPropertyTypeInteger && cJSON_IsNumber(value)) {
-                    argument.set_value<int>(value->valueint);
-                    found = true;
-                } else if (argument.type() == kPropertyTypeString && cJSON_IsString(value)) {
-                    argument.set_value<std::string>(value->valuestring);
-                    found = true;
-                }
-            }
-
-            if (!argument.has_default_value() && !found) {
-                ESP_LOGE(TAG, "tools/call: Missing valid argument: %s", argument.name().c_str());
-                ReplyError(id, "Missing valid argument: " + argument.name());
-                return;
-            }
-        }
+        bound_call = tool->Bind(tool_arguments);
     } catch (const std::exception& e) {
         ESP_LOGE(TAG, "tools/call: %s", e.what());
-        ReplyError(id, e.what());
+        ReplyError(id, e.what(), batch);
         return;
     }
 
-    // Use main thread to call the tool
-    auto& app = Application::GetInstance();
-    app.Schedule([this, id, tool_iter, arguments = std::move(arguments)]() {
+    auto call = [this, id, tool, batch, bound_call = std::move(bound_call)]() {
         try {
-            ReplyResult(id, (*tool_iter)->Call(arguments));
+            ReplyResult(id, tool->Call(bound_call), batch);
         } catch (const std::exception& e) {
             ESP_LOGE(TAG, "tools/call: %s", e.what());
-            ReplyError(id, e.what());
+            ReplyError(id, e.what(), batch);
         }
-    });
+    };
+
+    switch (tool->execution()) {
+    case kMcpToolInline:
+        call();
+        break;
+    case kMcpToolBackground:
+        RunInBackground(tool, std::move(call));
+        break;
+    default:
+        // Use main thread to call the tool
+        Application::GetInstance().Schedule(std::move(call));
+        break;
+    }
+}
+
+void McpServer::RunInBackground(const McpTool* tool, std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(workers_mutex_);
+        auto& workers = tool_workers_[tool];
+        if (workers.running >= tool->max_concurrency()) {
+            // The worker that finishes first picks it up, calls of one tool start in order
+            workers.pending.push_back(std::move(job));
+            ESP_LOGI(TAG, "tools/call: %s busy, %d call(s) waiting", tool->name().c_str(), (int)workers.pending.size());
+            return;
+        }
+        workers.running++;
+    }
+
+    struct WorkerArgs {
+        McpServer* server;
+        const McpTool* tool;
+        std::function<void()> job;
+    };
+    auto args = new WorkerArgs{this, tool, std::move(job)};
+    BaseType_t ret = xTaskCreate([](void* arg) {
+        auto args = static_cast<WorkerArgs*>(arg);
+        args->server->BackgroundWorker(args->tool, std::move(args->job));
+        delete args;
+        vTaskDelete(NULL);
+    }, "mcp_tool", BACKGROUND_TOOL_STACK_SIZE, args, BACKGROUND_TOOL_PRIORITY, nullptr);
+    if (ret != pdPASS) {
+        ESP_LOGW(TAG, "tools/call: Failed to create worker for %s, running it on the main task", tool->name().c_str());
+        {
+            std::lock_guard<std::mutex> lock(workers_mutex_);
+            tool_workers_[tool].running--;
+        }
+        Application::GetInstance().Schedule(std::move(args->job));
+        delete args;
+    }
+}
+
+void McpServer::BackgroundWorker(const McpTool* tool, std::function<void()> job) {
+    while (true) {
+        job();
+        std::lock_guard<std::mutex> lock(workers_mutex_);
+        auto& workers = tool_workers_[tool];
+        if (workers.pending.empty()) {
+            workers.running--;
+            return;
+        }
+        job = std::move(workers.pending.front());
+        workers.pending.pop_front();
+    }
 }
@@ -4,11 +4,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <functional>
 #include <variant>
 #include <optional>
+#include <atomic>
 #include <stdexcept>
 #include <thread>
+#include <type_traits>
 #include <mbedtls/base64.h>
 
 #include <cJSON.h>
@@ -106,21 +112,27 @@ public:
         return std::get<T>(value_);
     }
 
+    // 整数范围检查，超出范围时抛出 std::invalid_argument
+    inline void check_range(int value) const {
+        if (min_value_.has_value() && value < min_value_.value()) {
+            throw std::invalid_argument("Value is below minimum allowed: " + std::to_string(min_value_.value()));
+        }
+        if (max_value_.has_value() && value > max_value_.value()) {
+            throw std::invalid_argument("Value exceeds maximum allowed: " + std::to_string(max_value_.value()));
+        }
+    }
+
     template<typename T>
     inline void set_value(const T& value) {
         // 添加对设置的整数值进行范围检查
         if constexpr (std::is_same_v<T, int>) {
-            if (min_value_.has_value() && value < min_value_.value()) {
-                throw std::invalid_argument("Value is below minimum allowed: " + std::to_string(min_value_.value()));
-            }
-            if (max_value_.has_value() && value > max_value_.value()) {
-                throw std::invalid_argument("Value exceeds maximum allowed: " + std::to_string(max_value_.value()));
-            }
+            check_range(value);
         }
         value_ = value;
     }
 
-    std::string to_json() const {
+    // Schema of this property, the caller owns the returned object
+    cJSON* to_cjson() const {
         cJSON *json = cJSON_CreateObject();
         
         if (type_ == kPropertyTypeBoolean) {
@@ -145,7 +157,11 @@ public:
                 cJSON_AddStringToObject(json, "default", value<std::string>().c_str());
             }
         }
-        
+        return json;
+    }
+
+    std::string to_json() const {
+        cJSON *json = to_cjson();
         char *json_str = cJSON_PrintUnformatted(json);
         std::string result(json_str);
         cJSON_free(json_str);
@@ -188,14 +204,17 @@ public:
         return required;
     }
 
-    std::string to_json() const {
+    // Schema of all properties keyed by name, the caller owns the returned object
+    cJSON* to_cjson() const {
         cJSON *json = cJSON_CreateObject();
-        
         for (const auto& property : properties_) {
-            cJSON *prop_json = cJSON_Parse(property.to_json().c_str());
-            cJSON_AddItemToObject(json, property.name().c_str(), prop_json);
+            cJSON_AddItemToObject(json, property.name().c_str(), property.to_cjson());
         }
-        
+        return json;
+    }
+
+    std::string to_json() const {
+        cJSON *json = to_cjson();
         char *json_str = cJSON_PrintUnformatted(json);
         std::string result(json_str);
         cJSON_free(json_str);
@@ -205,6 +224,79 @@ public:
     }
 };
 
+// Binds one argument of a typed tool to a member of its argument struct. The constructors mirror
+// Property, with the member pointer in place of the type:
+//   McpArgument("volume", &VolumeArgs::volume, 0, 100)
+template<typename Args>
+class McpArgument {
+private:
+    Property property_;
+    std::variant<bool Args::*, int Args::*, std::string Args::*> member_;
+
+public:
+    // Required arguments
+    McpArgument(const char* name, bool Args::* member) : property_(name, kPropertyTypeBoolean), member_(member) {}
+    McpArgument(const char* name, int Args::* member) : property_(name, kPropertyTypeInteger), member_(member) {}
+    McpArgument(const char* name, std::string Args::* member) : property_(name, kPropertyTypeString), member_(member) {}
+    McpArgument(const char* name, int Args::* member, int min_value, int max_value)
+        : property_(name, kPropertyTypeInteger, min_value, max_value), member_(member) {}
+
+    // Optional arguments with a default value
+    McpArgument(const char* name, bool Args::* member, bool default_value)
+        : property_(name, kPropertyTypeBoolean, default_value), member_(member) {}
+    McpArgument(const char* name, int Args::* member, int default_value)
+        : property_(name, kPropertyTypeInteger, default_value), member_(member) {}
+    McpArgument(const char* name, std::string Args::* member, const std::string& default_value)
+        : property_(name, kPropertyTypeString, default_value), member_(member) {}
+    McpArgument(const char* name, int Args::* member, int default_value, int min_value, int max_value)
+        : property_(name, kPropertyTypeInteger, default_value, min_value, max_value), member_(member) {}
+
+    inline const Property& property() const { return property_; }
+
+    // Reads the argument from the call arguments into args, throws std::invalid_argument if it is
+    // missing without a default value or out of range
+    void Decode(const cJSON* arguments, Args& args) const {
+        const cJSON* value = cJSON_IsObject(arguments) ? cJSON_GetObjectItem(arguments, property_.name().c_str()) : nullptr;
+        if (auto member = std::get_if<bool Args::*>(&member_)) {
+            if (cJSON_IsBool(value)) {
+                args.**member = cJSON_IsTrue(value);
+                return;
+            }
+            if (property_.has_default_value()) {
+                args.**member = property_.value<bool>();
+                return;
+            }
+        } else if (auto member = std::get_if<int Args::*>(&member_)) {
+            if (cJSON_IsNumber(value)) {
+                property_.check_range(value->valueint);
+                args.**member = value->valueint;
+                return;
+            }
+            if (property_.has_default_value()) {
+                args.**member = property_.value<int>();
+                return;
+            }
+        } else if (auto member = std::get_if<std::string Args::*>(&member_)) {
+            if (cJSON_IsString(value)) {
+                args.**member = value->valuestring;
+                return;
+            }
+            if (property_.has_default_value()) {
+                args.**member = property_.value<std::string>();
+                return;
+            }
+        }
+        throw std::invalid_argument("Missing valid argument: " + property_.name());
+    }
+};
+
+// Where a tool call runs
+enum McpToolExecution {
+    kMcpToolMainTask,    // Scheduled on the main task (default), safe to touch application state
+    kMcpToolInline,      // Run directly on the thread that received the message, only for quick thread-safe tools
+    kMcpToolBackground   // Run on a worker task, for tools that block on the network, camera or motors
+};
+
 class McpTool {
 private:
     std::string name_;
@@ -212,6 +304,11 @@ private:
     PropertyList properties_;
     std::function<ReturnValue(const PropertyList&)> callback_;
     bool user_only_ = false;
+    McpToolExecution execution_ = kMcpToolMainTask;
+    int max_concurrency_ = 1;
+    mutable std::string json_;  // Cached to_json() output, the tool doesn't change once registered
+    // Typed tools decode their arguments here, properties_ then only describes the schema
+    std::function<std::function<ReturnValue()>(const cJSON*)> binder_;
 
 public:
     McpTool(const std::string& name, 
@@ -223,11 +320,49 @@ public:
         properties_(properties), 
         callback_(callback) {}
 
-    void set_user_only(bool user_only) { user_only_ = user_only; }
+    // Typed tool, the arguments are checked here once instead of on every call
+    template<typename Args>
+    McpTool(const std::string& name,
+            const std::string& description,
+            const std::vector<McpArgument<Args>>& arguments,
+            std::function<ReturnValue(const Args&)> callback)
+        : name_(name),
+        description_(description) {
+        static_assert(std::is_default_constructible_v<Args> && std::is_copy_constructible_v<Args>,
+                      "Tool arguments must be a plain struct");
+        for (size_t i = 0; i < arguments.size(); i++) {
+            for (size_t j = 0; j < i; j++) {
+                if (arguments[j].property().name() == arguments[i].property().name()) {
+                    throw std::invalid_argument("Duplicate argument " + arguments[i].property().name() + " in tool " + name);
+                }
+            }
+            properties_.AddProperty(arguments[i].property());
+        }
+        binder_ = [arguments, callback = std::move(callback)](const cJSON* json) -> std::function<ReturnValue()> {
+            Args args{};
+            for (const auto& argument : arguments) {
+                argument.Decode(json, args);
+            }
+            // The tool outlives its calls, so the callback is referenced instead of copied
+            return [&callback, args]() { return callback(args); };
+        };
+    }
+
+    void set_user_only(bool user_only) {
+        user_only_ = user_only;
+        json_.clear();
+    }
+    // max_concurrency only applies to background tools, further calls wait for a free worker in order
+    void set_execution(McpToolExecution execution, int max_concurrency = 1) {
+        execution_ = execution;
+        max_concurrency_ = max_concurrency > 0 ? max_concurrency : 1;
+    }
     inline const std::string& name() const { return name_; }
     inline const std::string& description() const { return description_; }
     inline const PropertyList& properties() const { return properties_; }
     inline bool user_only() const { return user_only_; }
+    inline McpToolExecution execution() const { return execution_; }
+    inline int max_concurrency() const { return max_concurrency_; }
 
     std::string to_json() const {
         std::vector<std::string> required = properties_.GetRequired();
@@ -239,8 +374,7 @@ public:
         cJSON *input_schema = cJSON_CreateObject();
         cJSON_AddStringToObject(input_schema, "type", "object");
         
-        cJSON *properties = cJSON_Parse(properties_.to_json().c_str());
-        cJSON_AddItemToObject(input_schema, "properties", properties);
+        cJSON_AddItemToObject(input_schema, "properties", properties_.to_cjson());
         
         if (!required.empty()) {
             cJSON *required_array = cJSON_CreateArray();
@@ -269,8 +403,47 @@ public:
         return result;
     }
 
-    std::string Call(const PropertyList& properties) {
-        ReturnValue return_value = callback_(properties);
+    // Serialized once on first use, tools/list only concatenates these
+    const std::string& json() const {
+        if (json_.empty()) {
+            json_ = to_json();
+        }
+        return json_;
+    }
+
+    // Checks the call arguments and returns the call to run, throws std::invalid_argument if an
+    // argument is missing or out of range
+    std::function<ReturnValue()> Bind(const cJSON* tool_arguments) const {
+        if (binder_) {
+            return binder_(tool_arguments);
+        }
+
+        PropertyList arguments = properties_;
+        for (auto& argument : arguments) {
+            bool found = false;
+            if (cJSON_IsObject(tool_arguments)) {
+                auto value = cJSON_GetObjectItem(tool_arguments, argument.name().c_str());
+                if (argument.type() == kPropertyTypeBoolean && cJSON_IsBool(value)) {
+                    argument.set_value<bool>(cJSON_IsTrue(value));
+                    found = true;
+                } else if (argument.type() == kPropertyTypeInteger && cJSON_IsNumber(value)) {
+                    argument.set_value<int>(value->valueint);
+                    found = true;
+                } else if (argument.type() == kPropertyTypeString && cJSON_IsString(value)) {
+                    argument.set_value<std::string>(value->valuestring);
+                    found = true;
+                }
+            }
+
+            if (!argument.has_default_value() && !found) {
+                throw std::invalid_argument("Missing valid argument: " + argument.name());
+            }
+        }
+        return [this, arguments = std::move(arguments)]() { return callback_(arguments); };
+    }
+
+    std::string Call(const std::function<ReturnValue()>& bound_call) const {
+        ReturnValue return_value = bound_call();
         // 返回结果
         cJSON* result = cJSON_CreateObject();
         cJSON* content = cJSON_CreateArray();
@@ -311,6 +484,8 @@ public:
     }
 };
 
+class McpBatchReply;
+
 class McpServer {
 public:
     static McpServer& GetInstance() {
@@ -320,9 +495,34 @@ public:
 
     void AddCommonTools();
     void AddUserOnlyTools();
-    void AddTool(McpTool* tool);
-    void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
-    void AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    // Takes ownership of tool. A tool with a name already registered is deleted, and the
+    // registered one is returned instead
+    McpTool* AddTool(McpTool* tool);
+    McpTool* AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    McpTool* AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+
+    // Typed tools, the tool body gets its arguments as a struct. Arguments are decoded straight into
+    // the struct, so tools the LLM calls often avoid copying a PropertyList on every call:
+    //   struct VolumeArgs { int volume; };
+    //   AddTool<VolumeArgs>("self.audio_speaker.set_volume", "...",
+    //       {McpArgument("volume", &VolumeArgs::volume, 0, 100)},
+    //       [](const VolumeArgs& args) -> ReturnValue { ... });
+    template<typename Args>
+    McpTool* AddTool(const std::string& name, const std::string& description,
+                     const std::vector<McpArgument<std::type_identity_t<Args>>>& arguments,
+                     std::function<ReturnValue(const std::type_identity_t<Args>&)> callback) {
+        auto tool = new McpTool(name, description, arguments, std::move(callback));
+        return AddTool(tool);
+    }
+    template<typename Args>
+    McpTool* AddUserOnlyTool(const std::string& name, const std::string& description,
+                             const std::vector<McpArgument<std::type_identity_t<Args>>>& arguments,
+                             std::function<ReturnValue(const std::type_identity_t<Args>&)> callback) {
+        auto tool = new McpTool(name, description, arguments, std::move(callback));
+        tool->set_user_only(true);
+        return AddTool(tool);
+    }
+    // Accepts a single request or a JSON-RPC batch array
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
 
@@ -330,15 +530,33 @@ private:
     McpServer();
     ~McpServer();
 
+    // Pending calls of a background tool and the number of workers running it
+    struct ToolWorkers {
+        int running = 0;
+        std::deque<std::function<void()>> pending;
+    };
+
     void ParseCapabilities(const cJSON* capabilities);
+    void ParseRequest(const cJSON* json, const std::shared_ptr<McpBatchReply>& batch);
 
-    void ReplyResult(int id, const std::string& result);
-    void ReplyError(int id, const std::string& message);
+    void ReplyResult(int id, const std::string& result, const std::shared_ptr<McpBatchReply>& batch = nullptr);
+    void ReplyError(int id, const std::string& message, const std::shared_ptr<McpBatchReply>& batch = nullptr);
+    void ReplyInvalidRequest(const cJSON* id, const std::shared_ptr<McpBatchReply>& batch);
+    void SendReply(std::string payload, const std::shared_ptr<McpBatchReply>& batch);
 
-    void GetToolsList(int id, const std::string& cursor, bool list_user_only_tools);
-    void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments);
+    McpTool* FindTool(const std::string& name) const;
+    void GetToolsList(int id, const std::string& cursor, bool list_user_only_tools, const std::shared_ptr<McpBatchReply>& batch);
+    void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, const std::shared_ptr<McpBatchReply>& batch);
+    void RunInBackground(const McpTool* tool, std::function<void()> job);
+    void BackgroundWorker(const McpTool* tool, std::function<void()> job);
 
     std::vector<McpTool*> tools_;
+    std::unordered_map<std::string, McpTool*> tools_by_name_;
+    std::mutex tools_list_mutex_;
+    std::mutex workers_mutex_;
+    std::map<const McpTool*, ToolWorkers> tool_workers_;
+    // Set while self.upgrade_firmware runs, a second call is rejected instead of racing on the OTA partition
+    std::atomic<bool> upgrading_{false};
 };
 
 #endif // MCP_SERVER_H
@@ -1,6 +1,7 @@
 #include "ota.h"
 #include "system_info.h"
 #include "settings.h"
+#include "checksum.h"
 #include "assets/lang_config.h"
 
 #include <freertos/FreeRTOS.h>
@@ -221,6 +222,8 @@ esp_err_t Ota::CheckVersion() {
         if (cJSON_IsString(url)) {
             firmware_url_ = url->valuestring;
         }
+        cJSON *sha256 = cJSON_GetObjectItem(firmware, "sha256");
+        firmware_sha256_ = cJSON_IsString(sha256) ? sha256->valuestring : "";
 
         if (cJSON_IsString(version) && cJSON_IsString(url)) {
             // Check if the version is newer, for example, 0.1.0 is newer than 0.0.1
@@ -264,7 +267,8 @@ void Ota::MarkCurrentVersionValid() {
     }
 }
 
-bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progress, size_t speed)> callback) {
+bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progress, size_t speed)> callback,
+    const std::string& expected_sha256) {
     ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
     esp_ota_handle_t update_handle = 0;
     auto update_partition = esp_ota_get_next_update_partition(NULL);
@@ -302,6 +306,8 @@ bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progre
         return false;
     }
 
+    // Hash the image while streaming, so it can be checked before switching the boot partition
+    Sha256 sha256;
     size_t buffer_offset = 0;  // Current data size in buffer
     size_t total_read = 0, recent_read = 0;
     auto last_calc_time = esp_timer_get_time();
@@ -313,6 +319,8 @@ bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progre
             return false;
         }
 
+        sha256.Update(buffer + buffer_offset, ret);
+
         // Calculate speed and progress every second
         recent_read += ret;
         total_read += ret;
@@ -366,6 +374,20 @@ bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progre
     http->Close();
     heap_caps_free(buffer);
 
+    if (total_read != content_length) {
+        ESP_LOGE(TAG, "Downloaded size (%u) does not match expected size (%u)", total_read, content_length);
+        esp_ota_abort(update_handle);
+        return false;
+    }
+
+    std::string digest = sha256.FinishHex();
+    ESP_LOGI(TAG, "Firmware SHA-256: %s", digest.c_str());
+    if (!Sha256::Matches(digest, expected_sha256)) {
+        ESP_LOGE(TAG, "Firmware SHA-256 does not match the expected %s", expected_sha256.c_str());
+        esp_ota_abort(update_handle);
+        return false;
+    }
+
     esp_err_t err = esp_ota_end(update_handle);
     if (err != ESP_OK) {
         if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
@@ -387,7 +409,7 @@ bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progre
 }
 
 bool Ota::StartUpgrade(std::function<void(int progress, size_t speed)> callback) {
-    return Upgrade(firmware_url_, callback);
+    return Upgrade(firmware_url_, callback, firmware_sha256_);
 }
 
 
@@ -14,9 +14,16 @@ struct AudioStreamPacket {
     std::vector<uint8_t> payload;
 };
 
+struct VideoStreamPacket {
+    uint32_t timestamp = 0;  // Capture time in milliseconds (esp_timer clock)
+    uint16_t width = 0;
+    uint16_t height = 0;
+    std::vector<uint8_t> payload;  // JPEG image
+};
+
 struct BinaryProtocol2 {
     uint16_t version;
-    uint16_t type;          // Message type (0: OPUS, 1: JSON)
+    uint16_t type;          // Message type (0: OPUS, 1: JSON, 2: JPEG)
     uint32_t reserved;      // Reserved for future use
     uint32_t timestamp;     // Timestamp in milliseconds (used for server-side AEC)
     uint32_t payload_size;  // Payload size in bytes
@@ -68,6 +75,7 @@ public:
     virtual void CloseAudioChannel(bool send_goodbye = true) = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) = 0;
+    virtual bool SendVideo(std::unique_ptr<VideoStreamPacket> packet) { return false; }
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
@@ -7,6 +7,7 @@
 #include <cstring>
 #include <cJSON.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <arpa/inet.h>
 #include "assets/lang_config.h"
 
@@ -57,6 +58,44 @@ bool WebsocketProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
     }
 }
 
+bool WebsocketProtocol::SendVideo(std::unique_ptr<VideoStreamPacket> packet) {
+    if (websocket_ == nullptr || !websocket_->IsConnected()) {
+        return false;
+    }
+
+    if (version_ == 2) {
+        std::string serialized;
+        serialized.resize(sizeof(BinaryProtocol2) + packet->payload.size());
+        auto bp2 = (BinaryProtocol2*)serialized.data();
+        bp2->version = htons(version_);
+        bp2->type = htons(2);
+        bp2->reserved = 0;
+        // Milliseconds since the channel was opened on the device clock. Not comparable with the
+        // audio timestamps, which echo the server's downlink timestamps for AEC
+        bp2->timestamp = htonl(packet->timestamp - channel_opened_time_);
+        bp2->payload_size = htonl(packet->payload.size());
+        memcpy(bp2->payload, packet->payload.data(), packet->payload.size());
+
+        return websocket_->Send(serialized.data(), serialized.size(), true);
+    } else if (version_ == 3) {
+        if (packet->payload.size() > UINT16_MAX) {
+            ESP_LOGW(TAG, "Video frame too large for protocol version 3: %u bytes", packet->payload.size());
+            return false;
+        }
+        std::string serialized;
+        serialized.resize(sizeof(BinaryProtocol3) + packet->payload.size());
+        auto bp3 = (BinaryProtocol3*)serialized.data();
+        bp3->type = 2;
+        bp3->reserved = 0;
+        bp3->payload_size = htons(packet->payload.size());
+        memcpy(bp3->payload, packet->payload.data(), packet->payload.size());
+
+        return websocket_->Send(serialized.data(), serialized.size(), true);
+    }
+    // Version 1 binary frames are always audio
+    return false;
+}
+
 bool WebsocketProtocol::SendText(const std::string& text) {
     if (websocket_ == nullptr || !websocket_->IsConnected()) {
         return false;
@@ -193,6 +232,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
         return false;
     }
 
+    channel_opened_time_ = esp_timer_get_time() / 1000;
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
     }
@@ -17,6 +17,7 @@ public:
 
     bool Start() override;
     bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override;
+    bool SendVideo(std::unique_ptr<VideoStreamPacket> packet) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel(bool send_goodbye = true) override;
     bool IsAudioChannelOpened() const override;
@@ -25,6 +26,7 @@ private:
     EventGroupHandle_t event_group_handle_;
     std::unique_ptr<WebSocket> websocket_;
     int version_ = 1;
+    uint32_t channel_opened_time_ = 0;
 
     void ParseServerHello(const cJSON* root);
     bool SendText(const std::string& text) override;
@@ -1,88 +1,300 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_system.h>
 #include <nvs_flash.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <variant>
+#include <optional>
 
 #define TAG "Settings"
 
-Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
-}
+// Writes within this window are coalesced into a single commit
+#define COMMIT_DELAY_MS 1000
 
-Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
+namespace {
+
+using SettingValue = std::variant<int32_t, uint8_t, std::string>;
+
+struct Namespace {
+    std::map<std::string, SettingValue> values;
+    // Keys written since the last commit, std::nullopt marks an erased key
+    std::map<std::string, std::optional<SettingValue>> pending;
+    bool erase_all = false;
+};
+
+struct ChangeListener {
+    int id;
+    std::string ns;
+    std::function<void(const std::string& key)> callback;
+};
+
+class SettingsCache {
+public:
+    static SettingsCache& GetInstance() {
+        static SettingsCache instance;
+        return instance;
+    }
+
+    template<typename T>
+    std::optional<T> Get(const std::string& ns, const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& space = Load(ns);
+        auto it = space.values.find(key);
+        if (it == space.values.end() || !std::holds_alternative<T>(it->second)) {
+            return std::nullopt;
         }
-        nvs_close(nvs_handle_);
+        return std::get<T>(it->second);
     }
-}
 
-std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
+    template<typename T>
+    void Set(const std::string& ns, const std::string& key, const T& value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& space = Load(ns);
+            auto it = space.values.find(key);
+            if (it != space.values.end() && std::holds_alternative<T>(it->second) && std::get<T>(it->second) == value) {
+                return;
+            }
+            space.values[key] = value;
+            space.pending[key] = SettingValue(value);
+            ScheduleCommit();
+        }
+        NotifyChange(ns, key);
+    }
+
+    void Erase(const std::string& ns, const std::string& key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& space = Load(ns);
+            if (space.values.erase(key) == 0) {
+                return;
+            }
+            space.pending[key] = std::nullopt;
+            ScheduleCommit();
+        }
+        NotifyChange(ns, key);
+    }
+
+    void EraseAll(const std::string& ns) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& space = Load(ns);
+            space.values.clear();
+            space.pending.clear();
+            space.erase_all = true;
+            ScheduleCommit();
+        }
+        NotifyChange(ns, "");
     }
 
-    size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
-        return default_value;
+    void Flush() {
+        // Serialize flushes so batches reach the flash in the order they were taken
+        std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+        std::map<std::string, Namespace> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& [ns, space] : namespaces_) {
+                if (space.pending.empty() && !space.erase_all) {
+                    continue;
+                }
+                auto& entry = batch[ns];
+                entry.pending.swap(space.pending);
+                entry.erase_all = space.erase_all;
+                space.erase_all = false;
+            }
+        }
+
+        for (auto& [ns, space] : batch) {
+            nvs_handle_t handle;
+            esp_err_t err = nvs_open(ns.c_str(), NVS_READWRITE, &handle);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to open namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+                continue;
+            }
+            if (space.erase_all) {
+                ESP_ERROR_CHECK(nvs_erase_all(handle));
+            }
+            for (auto& [key, value] : space.pending) {
+                if (!value.has_value()) {
+                    err = nvs_erase_key(handle, key.c_str());
+                    if (err != ESP_ERR_NVS_NOT_FOUND) {
+                        ESP_ERROR_CHECK(err);
+                    }
+                } else if (std::holds_alternative<std::string>(*value)) {
+                    ESP_ERROR_CHECK(nvs_set_str(handle, key.c_str(), std::get<std::string>(*value).c_str()));
+                } else if (std::holds_alternative<int32_t>(*value)) {
+                    ESP_ERROR_CHECK(nvs_set_i32(handle, key.c_str(), std::get<int32_t>(*value)));
+                } else {
+                    ESP_ERROR_CHECK(nvs_set_u8(handle, key.c_str(), std::get<uint8_t>(*value)));
+                }
+            }
+            ESP_ERROR_CHECK(nvs_commit(handle));
+            nvs_close(handle);
+            ESP_LOGI(TAG, "Committed %u change(s) to namespace %s", space.pending.size(), ns.c_str());
+        }
     }
 
-    std::string value;
-    value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
-    while (!value.empty() && value.back() == '\0') {
-        value.pop_back();
+    int AddChangeListener(const std::string& ns, std::function<void(const std::string& key)> callback) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        int id = ++last_listener_id_;
+        listeners_.push_back({id, ns, std::move(callback)});
+        return id;
     }
-    return value;
+
+    void RemoveChangeListener(int id) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        std::erase_if(listeners_, [id](const ChangeListener& listener) { return listener.id == id; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::mutex flush_mutex_;
+    std::map<std::string, Namespace> namespaces_;
+    TaskHandle_t commit_task_ = nullptr;
+
+    std::mutex listeners_mutex_;
+    std::vector<ChangeListener> listeners_;
+    int last_listener_id_ = 0;
+
+    SettingsCache() {
+        // Commits run on their own task, NVS writes block for tens of ms and would stall the
+        // shared esp_timer task
+        xTaskCreate([](void* arg) {
+            static_cast<SettingsCache*>(arg)->CommitTask();
+        }, "settings", 4096, this, 1, &commit_task_);
+
+        // Do not lose pending writes on esp_restart(). Deep sleep and power off paths call
+        // Settings::Flush() themselves, sleep hooks must not touch the flash.
+        esp_register_shutdown_handler([]() {
+            SettingsCache::GetInstance().Flush();
+        });
+    }
+
+    void CommitTask() {
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            // Every further write restarts the debounce window
+            while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(COMMIT_DELAY_MS)) > 0) {
+            }
+            Flush();
+        }
+    }
+
+    // Must be called with mutex_ held
+    Namespace& Load(const std::string& ns) {
+        auto it = namespaces_.find(ns);
+        if (it != namespaces_.end()) {
+            return it->second;
+        }
+
+        auto& space = namespaces_[ns];
+        nvs_handle_t handle;
+        if (nvs_open(ns.c_str(), NVS_READONLY, &handle) != ESP_OK) {
+            // The namespace does not exist yet
+            return space;
+        }
+
+        nvs_iterator_t iterator = nullptr;
+        esp_err_t err = nvs_entry_find_in_handle(handle, NVS_TYPE_ANY, &iterator);
+        while (err == ESP_OK) {
+            nvs_entry_info_t info;
+            nvs_entry_info(iterator, &info);
+            if (info.type == NVS_TYPE_STR) {
+                size_t length = 0;
+                if (nvs_get_str(handle, info.key, nullptr, &length) == ESP_OK) {
+                    std::string value(length, '\0');
+                    nvs_get_str(handle, info.key, value.data(), &length);
+                    while (!value.empty() && value.back() == '\0') {
+                        value.pop_back();
+                    }
+                    space.values[info.key] = std::move(value);
+                }
+            } else if (info.type == NVS_TYPE_I32) {
+                int32_t value;
+                if (nvs_get_i32(handle, info.key, &value) == ESP_OK) {
+                    space.values[info.key] = value;
+                }
+            } else if (info.type == NVS_TYPE_U8) {
+                uint8_t value;
+                if (nvs_get_u8(handle, info.key, &value) == ESP_OK) {
+                    space.values[info.key] = value;
+                }
+            }
+            err = nvs_entry_next(&iterator);
+        }
+        nvs_release_iterator(iterator);
+        nvs_close(handle);
+        ESP_LOGD(TAG, "Loaded %u key(s) from namespace %s", space.values.size(), ns.c_str());
+        return space;
+    }
+
+    // Must be called with mutex_ held, restarts the debounce window
+    void ScheduleCommit() {
+        xTaskNotifyGive(commit_task_);
+    }
+
+    void NotifyChange(const std::string& ns, const std::string& key) {
+        std::vector<std::function<void(const std::string&)>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(listeners_mutex_);
+            for (auto& listener : listeners_) {
+                if (listener.ns == ns) {
+                    callbacks.push_back(listener.callback);
+                }
+            }
+        }
+        for (auto& callback : callbacks) {
+            callback(key);
+        }
+    }
+};
+
+} // namespace
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+}
+
+Settings::~Settings() {
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
+    return SettingsCache::GetInstance().Get<std::string>(ns_, key).value_or(default_value);
 }
 
 void Settings::SetString(const std::string& key, const std::string& value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
-        dirty_ = true;
+        SettingsCache::GetInstance().Set<std::string>(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
-    int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
-        return default_value;
-    }
-    return value;
+    return SettingsCache::GetInstance().Get<int32_t>(ns_, key).value_or(default_value);
 }
 
 void Settings::SetInt(const std::string& key, int32_t value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
-        dirty_ = true;
+        SettingsCache::GetInstance().Set<int32_t>(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 bool Settings::GetBool(const std::string& key, bool default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
-    uint8_t value;
-    if (nvs_get_u8(nvs_handle_, key.c_str(), &value) != ESP_OK) {
-        return default_value;
-    }
-    return value != 0;
+    auto value = SettingsCache::GetInstance().Get<uint8_t>(ns_, key);
+    return value.has_value() ? *value != 0 : default_value;
 }
 
 void Settings::SetBool(const std::string& key, bool value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_u8(nvs_handle_, key.c_str(), value ? 1 : 0));
-        dirty_ = true;
+        SettingsCache::GetInstance().Set<uint8_t>(ns_, key, value ? 1 : 0);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -90,10 +302,7 @@ void Settings::SetBool(const std::string& key, bool value) {
 
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
+        SettingsCache::GetInstance().Erase(ns_, key);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -101,8 +310,20 @@ void Settings::EraseKey(const std::string& key) {
 
 void Settings::EraseAll() {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
+        SettingsCache::GetInstance().EraseAll(ns_);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
+
+void Settings::Flush() {
+    SettingsCache::GetInstance().Flush();
+}
+
+int Settings::AddChangeListener(const std::string& ns, std::function<void(const std::string& key)> callback) {
+    return SettingsCache::GetInstance().AddChangeListener(ns, std::move(callback));
+}
+
+void Settings::RemoveChangeListener(int id) {
+    SettingsCache::GetInstance().RemoveChangeListener(id);
+}
@@ -2,8 +2,14 @@
 #define SETTINGS_H
 
 #include <string>
+#include <functional>
 #include <nvs_flash.h>
 
+// Settings are served from a process-wide RAM cache, each namespace is loaded from NVS
+// on first use. Writes update the cache immediately and are committed to flash in a
+// debounced batch, pending writes are also flushed on esp_restart(). Code that enters deep
+// sleep or cuts the power must call Flush() first.
+// Keys written by other components through the NVS API directly are re-read after a reboot.
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
@@ -18,11 +24,15 @@ public:
     void EraseKey(const std::string& key);
     void EraseAll();
 
+    // Commit pending writes to flash now instead of waiting for the debounce window
+    static void Flush();
+    // The callback receives the changed key, or an empty key after EraseAll
+    static int AddChangeListener(const std::string& ns, std::function<void(const std::string& key)> callback);
+    static void RemoveChangeListener(int id);
+
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
     bool read_write_ = false;
-    bool dirty_ = false;
 };
 
 #endif
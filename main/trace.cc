@@ -0,0 +1,193 @@
+#include "trace.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <cJSON.h>
+
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+#define TAG "Trace"
+
+#if CONFIG_ENABLE_TRACE
+
+namespace {
+
+struct TraceEvent {
+    int64_t timestamp;
+    const char* name;
+    char phase;
+    uint8_t core;
+    char track[configMAX_TASK_NAME_LEN];
+};
+
+struct TraceSlot {
+    // Index + 1 of the write that filled this slot, 0 while the slot is being written
+    std::atomic<uint32_t> sequence;
+    TraceEvent event;
+};
+
+// Published once by the allocating writer, other tasks and cores may read it at any time
+std::atomic<TraceSlot*> events_{nullptr};
+std::atomic<uint32_t> head_{0};
+
+TraceSlot* GetEvents() {
+    auto events = events_.load(std::memory_order_acquire);
+    if (events == nullptr) {
+        // Allocate lazily, preferring PSRAM, the first racing writers may lose their event
+        static std::atomic<bool> allocating{false};
+        if (allocating.exchange(true)) {
+            return nullptr;
+        }
+        size_t size = sizeof(TraceSlot) * CONFIG_TRACE_BUFFER_EVENTS;
+        events = (TraceSlot*)heap_caps_calloc_prefer(1, size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+        if (events == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate trace buffer");
+            return nullptr;
+        }
+        events_.store(events, std::memory_order_release);
+    }
+    return events;
+}
+
+void Record(char phase, const char* name, const char* track) {
+    auto events = GetEvents();
+    if (events == nullptr) {
+        return;
+    }
+    uint32_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    auto& slot = events[index % CONFIG_TRACE_BUFFER_EVENTS];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    auto& event = slot.event;
+    event.timestamp = esp_timer_get_time();
+    event.name = name;
+    event.phase = phase;
+    event.core = xPortGetCoreID();
+    strncpy(event.track, track != nullptr ? track : pcTaskGetName(NULL), sizeof(event.track) - 1);
+    event.track[sizeof(event.track) - 1] = '\0';
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+// Copy out the events still in the ring, oldest first, skipping slots being rewritten
+std::vector<TraceEvent> Snapshot() {
+    std::vector<TraceEvent> result;
+    auto events = events_.load(std::memory_order_acquire);
+    if (events == nullptr) {
+        return result;
+    }
+    uint32_t head = head_.load(std::memory_order_acquire);
+    uint32_t start = head > CONFIG_TRACE_BUFFER_EVENTS ? head - CONFIG_TRACE_BUFFER_EVENTS : 0;
+    result.reserve(head - start);
+    for (uint32_t index = start; index < head; index++) {
+        auto& slot = events[index % CONFIG_TRACE_BUFFER_EVENTS];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+            continue;
+        }
+        result.push_back(slot.event);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != index + 1) {
+            result.pop_back();
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+void Trace::Begin(const char* name, const char* track) {
+    Record('B', name, track);
+}
+
+void Trace::End(const char* name, const char* track) {
+    Record('E', name, track);
+}
+
+void Trace::Instant(const char* name, const char* track) {
+    Record('i', name, track);
+}
+
+std::string Trace::ToChromeJson() {
+    auto events = Snapshot();
+
+    // Chrome trace wants numeric thread ids, one per track, named by metadata events
+    std::vector<std::string> tracks;
+    cJSON* root = cJSON_CreateObject();
+    cJSON* trace_events = cJSON_AddArrayToObject(root, "traceEvents");
+    for (auto& event : events) {
+        size_t tid = 0;
+        while (tid < tracks.size() && tracks[tid] != event.track) {
+            tid++;
+        }
+        if (tid == tracks.size()) {
+            tracks.push_back(event.track);
+            cJSON* metadata = cJSON_CreateObject();
+            cJSON_AddStringToObject(metadata, "name", "thread_name");
+            cJSON_AddStringToObject(metadata, "ph", "M");
+            cJSON_AddNumberToObject(metadata, "pid", 0);
+            cJSON_AddNumberToObject(metadata, "tid", tid);
+            cJSON* args = cJSON_AddObjectToObject(metadata, "args");
+            cJSON_AddStringToObject(args, "name", event.track);
+            cJSON_AddItemToArray(trace_events, metadata);
+        }
+
+        char phase[2] = { event.phase, '\0' };
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", event.name);
+        cJSON_AddStringToObject(item, "ph", phase);
+        cJSON_AddNumberToObject(item, "ts", (double)event.timestamp);
+        cJSON_AddNumberToObject(item, "pid", 0);
+        cJSON_AddNumberToObject(item, "tid", tid);
+        if (event.phase == 'i') {
+            cJSON_AddStringToObject(item, "s", "t");
+        }
+        cJSON* args = cJSON_AddObjectToObject(item, "args");
+        cJSON_AddNumberToObject(args, "core", event.core);
+        cJSON_AddItemToArray(trace_events, item);
+    }
+    cJSON_AddStringToObject(root, "displayTimeUnit", "ms");
+
+    char* json_str = cJSON_PrintUnformatted(root);
+    std::string result(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return result;
+}
+
+void Trace::DumpToSerial() {
+    auto json = ToChromeJson();
+    // Markers make the trace easy to cut out of a monitor log
+    printf("\n===== TRACE BEGIN =====\n");
+    for (size_t offset = 0; offset < json.size(); offset += 256) {
+        printf("%.*s", (int)std::min<size_t>(256, json.size() - offset), json.data() + offset);
+    }
+    printf("\n===== TRACE END =====\n");
+}
+
+void Trace::Clear() {
+    // Invalidate everything written so far, late writers simply land after the new head
+    auto events = events_.load(std::memory_order_acquire);
+    if (events == nullptr) {
+        return;
+    }
+    for (int i = 0; i < CONFIG_TRACE_BUFFER_EVENTS; i++) {
+        events[i].sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+#else // CONFIG_ENABLE_TRACE
+
+void Trace::Begin(const char* name, const char* track) {}
+void Trace::End(const char* name, const char* track) {}
+void Trace::Instant(const char* name, const char* track) {}
+std::string Trace::ToChromeJson() { return "{\"traceEvents\":[]}"; }
+void Trace::DumpToSerial() { ESP_LOGW(TAG, "Trace is disabled, enable CONFIG_ENABLE_TRACE"); }
+void Trace::Clear() {}
+
+#endif // CONFIG_ENABLE_TRACE
@@ -0,0 +1,47 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <string>
+#include <cstdint>
+
+/**
+ * Trace - Lightweight event recorder for boot time and latency profiling
+ *
+ * Events are written into a fixed-size lock-free ring with esp_timer timestamps,
+ * the oldest events are overwritten when the ring is full. Event names must be
+ * string literals or otherwise outlive the recorder. The ring can be exported in
+ * Chrome trace format (chrome://tracing, https://ui.perfetto.dev).
+ *
+ * Enabled by CONFIG_ENABLE_TRACE, all calls are no-ops otherwise.
+ */
+class Trace {
+public:
+    // Pseudo track for events that are not bound to the calling task
+    static constexpr const char* kStateTrack = "device_state";
+
+    static void Begin(const char* name, const char* track = nullptr);
+    static void End(const char* name, const char* track = nullptr);
+    static void Instant(const char* name, const char* track = nullptr);
+
+    static std::string ToChromeJson();
+    static void DumpToSerial();
+    static void Clear();
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(name) { Trace::Begin(name_); }
+    ~TraceScope() { Trace::End(name_); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#endif // _TRACE_H_
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Convert GIF animations to the pre-rendered .anim format played by LvglAnimation
+
+The device plays .anim files straight from the mmapped assets partition: every frame is
+either a keyframe or a dirty rectangle that is copied into the canvas, so playback costs
+a few memcpy calls instead of LZW decoding and palette lookup.
+
+File layout (little endian, all offsets 4 byte aligned):
+    header   magic "XZAN", u16 version, u16 color format (0: RGB565, 1: RGB565A8),
+             u16 width, u16 height, u16 frame count, u16 reserved,
+             i32 loop count (0: forever, n: play n times), u32 reserved
+    frames   per frame: u32 data offset, u16 x, y, w, h, u16 delay ms, u16 flags (1: keyframe)
+    data     per frame: h rows of w RGB565 pixels, then h rows of w A8 pixels for RGB565A8
+
+Usage:
+    ./anim_converter.py input.gif [output.anim] [--keyframes-only]
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b'XZAN'
+VERSION = 1
+COLOR_RGB565 = 0
+COLOR_RGB565A8 = 1
+FRAME_KEYFRAME = 0x01
+
+HEADER_FORMAT = '<4sHHHHHHiI'
+FRAME_FORMAT = '<IHHHHHH'
+
+# Deltas covering more than this share of the image are stored as keyframes
+KEYFRAME_AREA_RATIO = 0.6
+
+
+def _load_frames(gif_path):
+    """Return composited RGBA frames, per-frame delays in ms and the loop count"""
+    from PIL import Image, ImageSequence
+
+    with Image.open(gif_path) as image:
+        # PIL: no loop key means play once, loop 0 means forever, n means n extra loops
+        loop = image.info.get('loop')
+        loop_count = 1 if loop is None else (0 if loop == 0 else loop + 1)
+        frames = []
+        delays = []
+        for frame in ImageSequence.Iterator(image):
+            frames.append(frame.convert('RGBA'))
+            delays.append(min(int(frame.info.get('duration', 100)), 0xFFFF))
+    return frames, delays, loop_count
+
+
+def _pack_rect(frame, box, has_alpha):
+    """Pack a rectangle as RGB565 rows followed by A8 rows"""
+    region = frame.crop(box)
+    pixels = region.tobytes()
+    color = bytearray()
+    alpha = bytearray()
+    for i in range(0, len(pixels), 4):
+        r, g, b, a = pixels[i], pixels[i + 1], pixels[i + 2], pixels[i + 3]
+        color += struct.pack('<H', ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3))
+        alpha.append(a)
+    return bytes(color + alpha) if has_alpha else bytes(color)
+
+
+def _dirty_box(previous, current, width):
+    """Bounding box of the changed pixels, widened to even x so rows stay word aligned"""
+    from PIL import ImageChops
+
+    box = ImageChops.difference(previous, current).getbbox()
+    if box is None:
+        return None
+    x0, y0, x1, y1 = box
+    x0 &= ~1
+    x1 = min(width, (x1 + 1) & ~1)
+    return x0, y0, x1, y1
+
+
+def convert_gif_to_anim(gif_path, keyframes_only=False):
+    """Convert a GIF file to .anim bytes"""
+    frames, delays, loop_count = _load_frames(gif_path)
+    if not frames:
+        raise ValueError(f'{gif_path} has no frames')
+
+    width, height = frames[0].size
+    has_alpha = any(frame.getextrema()[3][0] < 255 for frame in frames)
+    color_format = COLOR_RGB565A8 if has_alpha else COLOR_RGB565
+
+    entries = []
+    blobs = []
+    previous = None
+    for index, frame in enumerate(frames):
+        box = (0, 0, width, height)
+        flags = FRAME_KEYFRAME
+        if previous is not None and not keyframes_only:
+            dirty = _dirty_box(previous, frame, width)
+            if dirty is None:
+                box, flags = (0, 0, 0, 0), 0
+            elif (dirty[2] - dirty[0]) * (dirty[3] - dirty[1]) < width * height * KEYFRAME_AREA_RATIO:
+                box, flags = dirty, 0
+        elif previous is not None and frame.tobytes() == previous.tobytes():
+            box, flags = (0, 0, 0, 0), 0
+
+        blob = _pack_rect(frame, box, has_alpha) if box[2] > box[0] else b''
+        entries.append((box, delays[index], flags))
+        blobs.append(blob)
+        previous = frame
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    table_size = struct.calcsize(FRAME_FORMAT) * len(frames)
+    out = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, color_format, width, height,
+                                len(frames), 0, loop_count, 0))
+    out += bytes(table_size)
+    for index, ((x0, y0, x1, y1), delay, flags) in enumerate(entries):
+        out += bytes(-len(out) % 4)
+        offset = len(out) if blobs[index] else 0
+        out += blobs[index]
+        struct.pack_into(FRAME_FORMAT, out, header_size + index * struct.calcsize(FRAME_FORMAT),
+                         offset, x0, y0, x1 - x0, y1 - y0, delay, flags)
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert GIF animations to the pre-rendered .anim format')
+    parser.add_argument('input', help='Input GIF file')
+    parser.add_argument('output', nargs='?', help='Output .anim file (default: input with .anim extension)')
+    parser.add_argument('--keyframes-only', action='store_true',
+                        help='Store every frame as a keyframe, played in place without a canvas')
+    args = parser.parse_args()
+
+    output = args.output or os.path.splitext(args.input)[0] + '.anim'
+    data = convert_gif_to_anim(args.input, args.keyframes_only)
+    with open(output, 'wb') as f:
+        f.write(data)
+    print(f'{args.input} -> {output} ({len(data)} bytes, {os.path.getsize(args.input)} bytes as GIF)')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -215,7 +215,29 @@ def process_text_font(text_font_file, assets_dir):
     return None
 
 
-def process_emoji_collection(emoji_collection_dir, assets_dir):
+def convert_gif_emoji(src_file, assets_dir):
+    """
+    Convert a GIF emoji to the pre-rendered .anim format, return the new file name
+    or None to keep the GIF (Pillow missing or conversion failed)
+    """
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), 'Image_Converter'))
+    try:
+        from anim_converter import convert_gif_to_anim
+        data = convert_gif_to_anim(src_file)
+    except Exception as e:
+        print(f"Warning: Failed to pre-render {src_file}, keeping GIF: {e}")
+        return None
+    finally:
+        sys.path.pop(0)
+
+    file = os.path.splitext(os.path.basename(src_file))[0] + '.anim'
+    with open(os.path.join(assets_dir, file), 'wb') as f:
+        f.write(data)
+    print(f"Pre-rendered {os.path.basename(src_file)}: {os.path.getsize(src_file)} -> {len(data)} bytes")
+    return file
+
+
+def process_emoji_collection(emoji_collection_dir, assets_dir, prerender_gif=False):
     """Process emoji_collection parameter"""
     if not emoji_collection_dir:
         return []
@@ -239,10 +261,18 @@ def process_emoji_collection(emoji_collection_dir, assets_dir):
     for root, dirs, files in os.walk(emoji_collection_dir):
         for file in files:
             if file.lower().endswith(('.png', '.gif')):
-                # Copy file
                 src_file = os.path.join(root, file)
-                dst_file = os.path.join(assets_dir, file)
-                if copy_file(src_file, dst_file):
+                anim_file = None
+                if prerender_gif and file.lower().endswith('.gif'):
+                    anim_file = convert_gif_emoji(src_file, assets_dir)
+                if anim_file:
+                    file = anim_file
+                    stored = True
+                else:
+                    # Copy file
+                    dst_file = os.path.join(assets_dir, file)
+                    stored = copy_file(src_file, dst_file)
+                if stored:
                     # Get filename without extension
                     filename_without_ext = os.path.splitext(file)[0]
                     
@@ -293,7 +323,14 @@ def process_extra_files(extra_files_dir, assets_dir):
     return extra_files_list
 
 
-def generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files=None, multinet_model_info=None):
+def read_hot_glyphs(hot_glyphs_file):
+    """Read the characters to pre-cache from a UTF-8 text file, in order and without duplicates"""
+    with open(hot_glyphs_file, 'r', encoding='utf-8') as f:
+        text = f.read()
+    return ''.join(dict.fromkeys(ch for ch in text if not ch.isspace()))
+
+
+def generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files=None, multinet_model_info=None, hot_glyphs=None):
     """Generate index.json file"""
     index_data = {
         "version": 1
@@ -304,6 +341,8 @@ def generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra
     
     if text_font:
         index_data["text_font"] = text_font
+        if hot_glyphs:
+            index_data["hot_glyphs"] = hot_glyphs
     
     if emoji_collection:
         index_data["emoji_collection"] = emoji_collection
@@ -360,12 +399,91 @@ def compute_checksum(data):
     return checksum
 
 
+# Formats that are already compressed gain nothing from LZ4
+UNCOMPRESSIBLE_EXTENSIONS = ('.png', '.gif', '.jpg', '.jpeg')
+
+# Formats read in place from the mmapped partition, never compressed and stored word aligned
+MAPPED_EXTENSIONS = ('.anim',)
+
+
+def _lz4_write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def _lz4_emit_sequence(out, literals, offset=0, match_len=0):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if match_len:
+        token |= min(match_len - 4, 15)
+    out.append(token)
+    if lit_len >= 15:
+        _lz4_write_length(out, lit_len - 15)
+    out.extend(literals)
+    if match_len:
+        out.extend(offset.to_bytes(2, byteorder='little'))
+        if match_len - 4 >= 15:
+            _lz4_write_length(out, match_len - 4 - 15)
+
+
+def lz4_compress_block(data):
+    """
+    Compress data into a raw LZ4 block (no frame header, no size prefix).
+    Uses the lz4 package when installed, otherwise a simple greedy compressor.
+    """
+    try:
+        import lz4.block
+        return lz4.block.compress(bytes(data), mode='high_compression', store_size=False)
+    except ImportError:
+        pass
+
+    data = bytes(data)
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    # LZ4 requires the last match to start 12 bytes before the end and the last 5 bytes to be literals
+    match_limit = n - 12
+    while i < match_limit:
+        key = data[i:i + 4]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate > 0xFFFF:
+            i += 1
+            continue
+        match_len = 4
+        max_len = n - 5 - i
+        while match_len < max_len and data[candidate + match_len] == data[i + match_len]:
+            match_len += 1
+        _lz4_emit_sequence(out, data[anchor:i], i - candidate, match_len)
+        i += match_len
+        anchor = i
+    _lz4_emit_sequence(out, data[anchor:])
+    return bytes(out)
+
+
+def pack_asset_data(file_name, bin_data, compress):
+    """
+    Return the stored bytes for an asset: 'ZZ' + raw data, or 'ZL' + raw size + LZ4 block
+    when compression is enabled and saves at least 10%
+    """
+    if compress and not file_name.lower().endswith(UNCOMPRESSIBLE_EXTENSIONS + MAPPED_EXTENSIONS) and len(bin_data) > 0:
+        block = lz4_compress_block(bin_data)
+        if len(block) + 4 < len(bin_data) * 0.9:
+            print(f'  Compressed {file_name}: {len(bin_data)} -> {len(block) + 4} bytes')
+            return b'ZL' + len(bin_data).to_bytes(4, byteorder='little') + block
+    return b'ZZ' + bin_data
+
+
 def sort_key(filename):
     basename, extension = os.path.splitext(filename)
     return extension, basename
 
 
-def pack_assets_simple(target_path, include_path, out_file, assets_path, max_name_len=32):
+def pack_assets_simple(target_path, include_path, out_file, assets_path, max_name_len=32, compress=False):
     """
     Simplified version of pack_assets that handles basic file packing
     """
@@ -387,16 +505,18 @@ def pack_assets_simple(target_path, include_path, out_file, assets_path, max_nam
             continue
             
         file_name = os.path.basename(file_path)
-        file_size = os.path.getsize(file_path)
-
-        file_info_list.append((file_name, len(merged_data), file_size, 0, 0))
-        # Add 0x5A5A prefix to merged_data
-        merged_data.extend(b'\x5A' * 2)
 
         with open(file_path, 'rb') as bin_file:
             bin_data = bin_file.read()
 
-        merged_data.extend(bin_data)
+        # The header and table are multiples of 4 bytes, pad so the data after the magic is word aligned
+        if file_name.lower().endswith(MAPPED_EXTENSIONS):
+            merged_data.extend(bytes(-(len(merged_data) + 2) % 4))
+
+        # The stored size excludes the 2-byte magic prefix
+        stored_data = pack_asset_data(file_name, bin_data, compress)
+        file_info_list.append((file_name, len(merged_data), len(stored_data) - 2, 0, 0))
+        merged_data.extend(stored_data)
 
     total_files = len(file_info_list)
 
@@ -568,6 +688,34 @@ def read_wake_word_type_from_sdkconfig(sdkconfig_path):
     return config_values
 
 
+def read_assets_compression_from_sdkconfig(sdkconfig_path):
+    """
+    Return True if CONFIG_ASSETS_COMPRESSION is enabled in sdkconfig
+    """
+    if not os.path.exists(sdkconfig_path):
+        return False
+
+    with io.open(sdkconfig_path, "r") as f:
+        for line in f:
+            if line.strip() == 'CONFIG_ASSETS_COMPRESSION=y':
+                return True
+    return False
+
+
+def read_prerender_emoji_gif_from_sdkconfig(sdkconfig_path):
+    """
+    Return True if CONFIG_ASSETS_PRERENDER_EMOJI_GIF is enabled in sdkconfig
+    """
+    if not os.path.exists(sdkconfig_path):
+        return False
+
+    with io.open(sdkconfig_path, "r") as f:
+        for line in f:
+            if line.strip() == 'CONFIG_ASSETS_PRERENDER_EMOJI_GIF=y':
+                return True
+    return False
+
+
 def read_custom_wake_word_from_sdkconfig(sdkconfig_path):
     """
     Read custom wake word configuration from sdkconfig
@@ -747,7 +895,7 @@ def get_emoji_collection_path(default_emoji_collection, xiaozhi_fonts_path, proj
     return None
 
 
-def build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font_path, emoji_collection_path, extra_files_path, output_path, multinet_model_info=None):
+def build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font_path, emoji_collection_path, extra_files_path, output_path, multinet_model_info=None, compress=False, prerender_gif=False, hot_glyphs=None):
     """
     Build assets using integrated functions (no external dependencies)
     """
@@ -767,11 +915,11 @@ def build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font
         # Process each component
         srmodels = process_sr_models(wakenet_model_paths, multinet_model_paths, temp_build_dir, assets_dir) if (wakenet_model_paths or multinet_model_paths) else None
         text_font = process_text_font(text_font_path, assets_dir) if text_font_path else None
-        emoji_collection = process_emoji_collection(emoji_collection_path, assets_dir) if emoji_collection_path else None
+        emoji_collection = process_emoji_collection(emoji_collection_path, assets_dir, prerender_gif) if emoji_collection_path else None
         extra_files = process_extra_files(extra_files_path, assets_dir) if extra_files_path else None
         
         # Generate index.json
-        generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files, multinet_model_info)
+        generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files, multinet_model_info, hot_glyphs)
         
         # Generate config.json for packing
         config_path = generate_config_json(temp_build_dir, assets_dir)
@@ -783,7 +931,7 @@ def build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font
         # Use simplified packing function
         include_path = config_data['include_path']
         image_file = config_data['image_file']
-        pack_assets_simple(assets_dir, include_path, image_file, "assets", int(config_data['name_length']))
+        pack_assets_simple(assets_dir, include_path, image_file, "assets", int(config_data['name_length']), compress)
         
         # Copy final assets.bin to output location
         if os.path.exists(image_file):
@@ -817,6 +965,7 @@ def main():
     parser.add_argument('--esp_sr_model_path', help='Path to ESP-SR model directory')
     parser.add_argument('--xiaozhi_fonts_path', help='Path to xiaozhi-fonts component directory')
     parser.add_argument('--extra_files', help='Path to extra files directory to be included in assets')
+    parser.add_argument('--hot_glyphs', help='UTF-8 text file with the characters to pre-cache from the text font')
     
     args = parser.parse_args()
     
@@ -921,8 +1070,19 @@ def main():
         return
     
     # Build the assets
+    compress = read_assets_compression_from_sdkconfig(args.sdkconfig)
+    if compress:
+        print("  assets compression: LZ4")
+    prerender_gif = read_prerender_emoji_gif_from_sdkconfig(args.sdkconfig)
+    if prerender_gif:
+        print("  GIF emojis: pre-rendered")
+
+    hot_glyphs = read_hot_glyphs(args.hot_glyphs) if args.hot_glyphs else None
+    if hot_glyphs:
+        print(f"  hot glyphs: {len(hot_glyphs)}")
+
     success = build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font_path, emoji_collection_path, 
-                                     extra_files_path, args.output, multinet_model_info)
+                                     extra_files_path, args.output, multinet_model_info, compress, prerender_gif, hot_glyphs)
     
     if not success:
         sys.exit(1)
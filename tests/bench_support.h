@@ -0,0 +1,23 @@
+// Timing helper shared by the host benchmarks
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// Run fn repeatedly for about 200 ms and print the throughput, returns the time per call in ns
+template <typename Fn>
+static double Bench(const char* name, size_t bytes_per_call, Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    fn();
+    size_t calls = 0;
+    auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    do {
+        fn();
+        calls++;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(200));
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+    printf("%-40s %10.1f us/call %10.1f MB/s\n", name, ns / 1000, bytes_per_call / ns * 1000);
+    return ns;
+}
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""
+Generate LZ4 test vectors with the compressor used by scripts/build_default_assets.py,
+so the firmware decoder is always tested against what the asset builder produces.
+"""
+import os
+import random
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'scripts'))
+from build_default_assets import lz4_compress_block
+
+
+def make_inputs():
+    rng = random.Random(20240601)
+    inputs = []
+    inputs.append(('empty', b''))
+    inputs.append(('short_literals', b'xiaozhi'))
+    inputs.append(('run_of_one_byte', b'\x00' * 1000))
+    inputs.append(('repeated_phrase', b'Hello, xiaozhi! ' * 300))
+    inputs.append(('random', bytes(rng.getrandbits(8) for _ in range(4096))))
+    # Long literal runs followed by long matches exercise the 255-byte length extensions
+    noise = bytes(rng.getrandbits(8) for _ in range(700))
+    inputs.append(('long_literals_and_matches', noise + noise * 3 + b'tail bytes!!'))
+    # RGB565 gradient, typical of a decompressed image asset
+    pixels = bytearray()
+    for y in range(96):
+        for x in range(128):
+            color = ((x >> 2) << 11) | ((y >> 1) << 5) | (x >> 3)
+            pixels += color.to_bytes(2, 'little')
+    inputs.append(('rgb565_gradient', bytes(pixels)))
+    # JSON text, like the index.json of an assets partition
+    text = ','.join('{"name":"emoji_%d.png","size":%d}' % (i, 1000 + i * 37) for i in range(200))
+    inputs.append(('json_index', text.encode()))
+    return inputs
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ' '.join('0x%02x,' % b for b in data[i:i + 16]))
+    return '\n'.join(lines) if lines else '    0x00,'
+
+
+def main():
+    if len(sys.argv) != 2:
+        print('Usage: gen_lz4_vectors.py <output header>')
+        sys.exit(1)
+    out = ['// Generated by tests/gen_lz4_vectors.py, do not edit', '#pragma once', '',
+           '#include <cstddef>', '#include <cstdint>', '']
+    entries = []
+    for name, raw in make_inputs():
+        block = lz4_compress_block(raw)
+        out.append('static const uint8_t k_%s_raw[] = {\n%s\n};' % (name, c_array(raw)))
+        out.append('static const uint8_t k_%s_lz4[] = {\n%s\n};' % (name, c_array(block)))
+        entries.append('    { "%s", k_%s_raw, %d, k_%s_lz4, %d },' % (name, name, len(raw), name, len(block)))
+    out.append('')
+    out.append('struct Lz4Vector {')
+    out.append('    const char* name;')
+    out.append('    const uint8_t* raw;')
+    out.append('    size_t raw_size;')
+    out.append('    const uint8_t* block;')
+    out.append('    size_t block_size;')
+    out.append('};')
+    out.append('')
+    out.append('static const Lz4Vector kLz4Vectors[] = {')
+    out.extend(entries)
+    out.append('};')
+    with open(sys.argv[1], 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()
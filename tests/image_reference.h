@@ -0,0 +1,108 @@
+// Straightforward per-pixel versions of the image_kernels functions, used as the reference
+// by the host tests and benchmarks
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+static void RefSwapBytes16(uint8_t* dst, const uint8_t* src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t lo = src[2 * i];
+        uint8_t hi = src[2 * i + 1];
+        dst[2 * i] = hi;
+        dst[2 * i + 1] = lo;
+    }
+}
+
+static void RefYuv422pToYuyv(uint8_t* dst, const uint8_t* src, int width, int height) {
+    const uint8_t* y_plane = src;
+    const uint8_t* u_plane = src + width * height;
+    const uint8_t* v_plane = u_plane + width / 2 * height;
+    for (int row = 0; row < height; row++) {
+        for (int pair = 0; pair < width / 2; pair++) {
+            uint8_t* d = dst + (row * width + pair * 2) * 2;
+            d[0] = y_plane[row * width + pair * 2];
+            d[1] = u_plane[row * width / 2 + pair];
+            d[2] = y_plane[row * width + pair * 2 + 1];
+            d[3] = v_plane[row * width / 2 + pair];
+        }
+    }
+}
+
+// Source pixel of a destination pixel, the centers of the first and last pixels line up.
+// Uses the same 16.16 step as the kernel so the sampled pixel is identical at exact ties.
+static int RefNearestIndex(int dst_pos, int dst_size, int src_size) {
+    int64_t step = ((int64_t)src_size << 16) / dst_size;
+    int64_t s = (dst_pos * step + step / 2) >> 16;
+    return (int)std::clamp<int64_t>(s, 0, src_size - 1);
+}
+
+static void RefScaleNearest(uint8_t* dst, int dst_w, int dst_h, size_t dst_stride, const uint8_t* src, int src_w,
+                            int src_h, size_t src_stride, int bpp) {
+    for (int y = 0; y < dst_h; y++) {
+        int sy = RefNearestIndex(y, dst_h, src_h);
+        for (int x = 0; x < dst_w; x++) {
+            int sx = RefNearestIndex(x, dst_w, src_w);
+            for (int c = 0; c < bpp; c++) {
+                dst[y * dst_stride + x * bpp + c] = src[sy * src_stride + sx * bpp + c];
+            }
+        }
+    }
+}
+
+// Bilinear sample position in floating point: the two source pixels and the weight of the second
+static void RefBilinearTap(int dst_pos, int dst_size, int src_size, int* p0, int* p1, double* w) {
+    double s = (dst_pos + 0.5) * src_size / dst_size - 0.5;
+    s = std::max(s, 0.0);
+    int i = (int)std::floor(s);
+    if (i >= src_size - 1) {
+        *p0 = *p1 = src_size - 1;
+        *w = 0;
+        return;
+    }
+    *p0 = i;
+    *p1 = i + 1;
+    *w = s - i;
+}
+
+// Channels of a pixel as floating point, RGB565 is split into its 5/6/5 bit fields
+static void RefLoadChannels(const uint8_t* p, int bpp, bool rgb565, double* out) {
+    if (rgb565) {
+        uint16_t c = p[0] | (p[1] << 8);
+        out[0] = c >> 11;
+        out[1] = (c >> 5) & 0x3F;
+        out[2] = c & 0x1F;
+        return;
+    }
+    for (int c = 0; c < bpp; c++) {
+        out[c] = p[c];
+    }
+}
+
+// Bilinear scale in floating point, the result is in channel units (5/6/5 bits for RGB565)
+static void RefScaleBilinear(double* dst, int dst_w, int dst_h, const uint8_t* src, int src_w, int src_h,
+                             size_t src_stride, int bpp, bool rgb565) {
+    int channels = rgb565 ? 3 : bpp;
+    for (int y = 0; y < dst_h; y++) {
+        int y0, y1;
+        double wy;
+        RefBilinearTap(y, dst_h, src_h, &y0, &y1, &wy);
+        for (int x = 0; x < dst_w; x++) {
+            int x0, x1;
+            double wx;
+            RefBilinearTap(x, dst_w, src_w, &x0, &x1, &wx);
+            double p00[3], p01[3], p10[3], p11[3];
+            RefLoadChannels(src + y0 * src_stride + x0 * bpp, bpp, rgb565, p00);
+            RefLoadChannels(src + y0 * src_stride + x1 * bpp, bpp, rgb565, p01);
+            RefLoadChannels(src + y1 * src_stride + x0 * bpp, bpp, rgb565, p10);
+            RefLoadChannels(src + y1 * src_stride + x1 * bpp, bpp, rgb565, p11);
+            for (int c = 0; c < channels; c++) {
+                double top = p00[c] * (1 - wx) + p01[c] * wx;
+                double bottom = p10[c] * (1 - wx) + p11[c] * wx;
+                dst[(y * dst_w + x) * channels + c] = top * (1 - wy) + bottom * wy;
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+// Host stand-in for the subset of cJSON used by the MCP server headers. The struct layout, type
+// flags and number handling follow cJSON 1.7, the parser is left out since the tests build their
+// arguments directly.
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define cJSON_Invalid (0)
+#define cJSON_False  (1 << 0)
+#define cJSON_True   (1 << 1)
+#define cJSON_NULL   (1 << 2)
+#define cJSON_Number (1 << 3)
+#define cJSON_String (1 << 4)
+#define cJSON_Array  (1 << 5)
+#define cJSON_Object (1 << 6)
+#define cJSON_Raw    (1 << 7)
+
+typedef int cJSON_bool;
+
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* prev;
+    struct cJSON* child;
+    int type;
+    char* valuestring;
+    int valueint;
+    double valuedouble;
+    char* string;
+} cJSON;
+
+cJSON* cJSON_CreateNull(void);
+cJSON* cJSON_CreateBool(cJSON_bool boolean);
+cJSON* cJSON_CreateNumber(double num);
+cJSON* cJSON_CreateString(const char* string);
+cJSON* cJSON_CreateArray(void);
+cJSON* cJSON_CreateObject(void);
+void cJSON_Delete(cJSON* item);
+void cJSON_free(void* object);
+
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item);
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item);
+cJSON* cJSON_AddBoolToObject(cJSON* const object, const char* const name, const cJSON_bool boolean);
+cJSON* cJSON_AddNumberToObject(cJSON* const object, const char* const name, const double number);
+cJSON* cJSON_AddStringToObject(cJSON* const object, const char* const name, const char* const string);
+
+int cJSON_GetArraySize(const cJSON* array);
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index);
+cJSON* cJSON_GetObjectItem(const cJSON* const object, const char* const string);
+
+cJSON_bool cJSON_IsBool(const cJSON* const item);
+cJSON_bool cJSON_IsTrue(const cJSON* const item);
+cJSON_bool cJSON_IsFalse(const cJSON* const item);
+cJSON_bool cJSON_IsNull(const cJSON* const item);
+cJSON_bool cJSON_IsNumber(const cJSON* const item);
+cJSON_bool cJSON_IsString(const cJSON* const item);
+cJSON_bool cJSON_IsArray(const cJSON* const item);
+cJSON_bool cJSON_IsObject(const cJSON* const item);
+
+char* cJSON_PrintUnformatted(const cJSON* item);
+
+#ifdef __cplusplus
+}
+#endif
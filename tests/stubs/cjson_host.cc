@@ -0,0 +1,249 @@
+// Host stand-in for cJSON, see cJSON.h
+#include "cJSON.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <strings.h>
+
+static cJSON* NewItem(int type) {
+    auto item = static_cast<cJSON*>(calloc(1, sizeof(cJSON)));
+    item->type = type;
+    return item;
+}
+
+static void Append(cJSON* parent, cJSON* item) {
+    if (parent->child == nullptr) {
+        parent->child = item;
+        item->prev = item;
+        return;
+    }
+    // Like cJSON, the first child's prev points at the last one
+    cJSON* last = parent->child->prev;
+    last->next = item;
+    item->prev = last;
+    parent->child->prev = item;
+}
+
+static void PrintString(std::string& out, const char* s) {
+    out += '"';
+    for (; *s; s++) {
+        unsigned char c = *s;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += (char)c;
+                }
+        }
+    }
+    out += '"';
+}
+
+static void Print(std::string& out, const cJSON* item) {
+    switch (item->type & 0xFF) {
+        case cJSON_NULL: out += "null"; break;
+        case cJSON_False: out += "false"; break;
+        case cJSON_True: out += "true"; break;
+        case cJSON_Number: {
+            char buf[32];
+            double d = item->valuedouble;
+            if (d == (double)item->valueint) {
+                snprintf(buf, sizeof(buf), "%d", item->valueint);
+            } else {
+                snprintf(buf, sizeof(buf), "%1.15g", d);
+            }
+            out += buf;
+            break;
+        }
+        case cJSON_String: PrintString(out, item->valuestring); break;
+        case cJSON_Array:
+        case cJSON_Object: {
+            bool object = (item->type & 0xFF) == cJSON_Object;
+            out += object ? '{' : '[';
+            for (cJSON* child = item->child; child; child = child->next) {
+                if (child != item->child) {
+                    out += ',';
+                }
+                if (object) {
+                    PrintString(out, child->string);
+                    out += ':';
+                }
+                Print(out, child);
+            }
+            out += object ? '}' : ']';
+            break;
+        }
+    }
+}
+
+extern "C" {
+
+cJSON* cJSON_CreateNull(void) {
+    return NewItem(cJSON_NULL);
+}
+
+cJSON* cJSON_CreateBool(cJSON_bool boolean) {
+    return NewItem(boolean ? cJSON_True : cJSON_False);
+}
+
+cJSON* cJSON_CreateNumber(double num) {
+    cJSON* item = NewItem(cJSON_Number);
+    item->valuedouble = num;
+    // cJSON saturates valueint instead of overflowing
+    if (num >= INT_MAX) {
+        item->valueint = INT_MAX;
+    } else if (num <= (double)INT_MIN) {
+        item->valueint = INT_MIN;
+    } else {
+        item->valueint = (int)num;
+    }
+    return item;
+}
+
+cJSON* cJSON_CreateString(const char* string) {
+    cJSON* item = NewItem(cJSON_String);
+    item->valuestring = strdup(string);
+    return item;
+}
+
+cJSON* cJSON_CreateArray(void) {
+    return NewItem(cJSON_Array);
+}
+
+cJSON* cJSON_CreateObject(void) {
+    return NewItem(cJSON_Object);
+}
+
+void cJSON_Delete(cJSON* item) {
+    while (item != nullptr) {
+        cJSON* next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+void cJSON_free(void* object) {
+    free(object);
+}
+
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item) {
+    if (array == nullptr || item == nullptr) {
+        return 0;
+    }
+    Append(array, item);
+    return 1;
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item) {
+    if (object == nullptr || string == nullptr || item == nullptr) {
+        return 0;
+    }
+    free(item->string);
+    item->string = strdup(string);
+    Append(object, item);
+    return 1;
+}
+
+cJSON* cJSON_AddBoolToObject(cJSON* const object, const char* const name, const cJSON_bool boolean) {
+    cJSON* item = cJSON_CreateBool(boolean);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+cJSON* cJSON_AddNumberToObject(cJSON* const object, const char* const name, const double number) {
+    cJSON* item = cJSON_CreateNumber(number);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+cJSON* cJSON_AddStringToObject(cJSON* const object, const char* const name, const char* const string) {
+    cJSON* item = cJSON_CreateString(string);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+int cJSON_GetArraySize(const cJSON* array) {
+    int size = 0;
+    for (cJSON* child = array ? array->child : nullptr; child; child = child->next) {
+        size++;
+    }
+    return size;
+}
+
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index) {
+    cJSON* child = array ? array->child : nullptr;
+    while (child && index-- > 0) {
+        child = child->next;
+    }
+    return child;
+}
+
+cJSON* cJSON_GetObjectItem(const cJSON* const object, const char* const string) {
+    if (object == nullptr || string == nullptr) {
+        return nullptr;
+    }
+    // Like cJSON, names are compared case insensitively
+    for (cJSON* child = object->child; child; child = child->next) {
+        if (child->string && strcasecmp(child->string, string) == 0) {
+            return child;
+        }
+    }
+    return nullptr;
+}
+
+cJSON_bool cJSON_IsBool(const cJSON* const item) {
+    return item && (item->type & (cJSON_True | cJSON_False)) != 0;
+}
+
+cJSON_bool cJSON_IsTrue(const cJSON* const item) {
+    return item && (item->type & 0xFF) == cJSON_True;
+}
+
+cJSON_bool cJSON_IsFalse(const cJSON* const item) {
+    return item && (item->type & 0xFF) == cJSON_False;
+}
+
+cJSON_bool cJSON_IsNull(const cJSON* const item) {
+    return item && (item->type & 0xFF) == cJSON_NULL;
+}
+
+cJSON_bool cJSON_IsNumber(const cJSON* const item) {
+    return item && (item->type & 0xFF) == cJSON_Number;
+}
+
+cJSON_bool cJSON_IsString(const cJSON* const item) {
+    return item && (item->type & 0xFF) == cJSON_String;
+}
+
+cJSON_bool cJSON_IsArray(const cJSON* const item) {
+    return item && (item->type & 0xFF) == cJSON_Array;
+}
+
+cJSON_bool cJSON_IsObject(const cJSON* const item) {
+    return item && (item->type & 0xFF) == cJSON_Object;
+}
+
+char* cJSON_PrintUnformatted(const cJSON* item) {
+    if (item == nullptr) {
+        return nullptr;
+    }
+    std::string out;
+    Print(out, item);
+    return strdup(out.c_str());
+}
+
+} // extern "C"
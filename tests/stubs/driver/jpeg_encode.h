@@ -0,0 +1,58 @@
+// Host stand-in for the ESP32-P4 hardware JPEG encoder driver, backed by libjpeg in esp_jpeg_host.cc
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef struct jpeg_encoder_t* jpeg_encoder_handle_t;
+
+typedef struct {
+    int intr_priority;
+    int timeout_ms;
+} jpeg_encode_engine_cfg_t;
+
+typedef enum {
+    JPEG_ENC_ALLOC_INPUT_BUFFER = 0,
+    JPEG_ENC_ALLOC_OUTPUT_BUFFER = 1,
+} jpeg_enc_buffer_alloc_direction_t;
+
+typedef struct {
+    jpeg_enc_buffer_alloc_direction_t buffer_direction;
+} jpeg_encode_memory_alloc_cfg_t;
+
+// RGB565 is little endian, YUV422 is stored as | Y1 V Y0 U | words, that is U Y0 V Y1 in memory
+typedef enum {
+    JPEG_ENCODE_IN_FORMAT_RGB888 = 0,
+    JPEG_ENCODE_IN_FORMAT_RGB565 = 1,
+    JPEG_ENCODE_IN_FORMAT_GRAY = 2,
+    JPEG_ENCODE_IN_FORMAT_YUV422 = 3,
+} jpeg_enc_input_format_t;
+
+typedef enum {
+    JPEG_DOWN_SAMPLING_YUV444 = 0,
+    JPEG_DOWN_SAMPLING_YUV422 = 1,
+    JPEG_DOWN_SAMPLING_YUV420 = 2,
+    JPEG_DOWN_SAMPLING_GRAY = 3,
+} jpeg_down_sampling_type_t;
+
+typedef struct {
+    uint32_t height;
+    uint32_t width;
+    jpeg_enc_input_format_t src_type;
+    jpeg_down_sampling_type_t sub_sample;
+    uint32_t image_quality;
+} jpeg_encode_cfg_t;
+
+esp_err_t jpeg_new_encoder_engine(const jpeg_encode_engine_cfg_t* enc_eng_cfg, jpeg_encoder_handle_t* ret_encoder);
+esp_err_t jpeg_del_encoder_engine(jpeg_encoder_handle_t encoder_engine);
+void* jpeg_alloc_encoder_mem(size_t size, const jpeg_encode_memory_alloc_cfg_t* mem_cfg, size_t* allocated_size);
+esp_err_t jpeg_encoder_process(jpeg_encoder_handle_t encoder_engine, const jpeg_encode_cfg_t* encode_cfg,
+                               const uint8_t* encode_inbuf, uint32_t inbuf_size, uint8_t* encode_outbuf,
+                               uint32_t outbuf_size, uint32_t* out_size);
+
+// Number of frames encoded by the stand-in engine, engines alive and DMA buffers allocated, for the tests
+extern int host_jpeg_hw_encodes;
+extern int host_jpeg_hw_engines;
+extern int host_jpeg_hw_allocs;
@@ -0,0 +1,6 @@
+// Host stand-in, placement attributes have no meaning off target
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
@@ -0,0 +1,36 @@
+// Host stand-in for the ESP-IDF capability allocator
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_DEFAULT (1 << 12)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DMA (1 << 3)
+
+static inline void* heap_caps_malloc(size_t size, unsigned int caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void* heap_caps_calloc(size_t n, size_t size, unsigned int caps) {
+    (void)caps;
+    return calloc(n, size);
+}
+
+static inline void* heap_caps_aligned_alloc(size_t alignment, size_t size, unsigned int caps) {
+    (void)caps;
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static inline void* heap_caps_malloc_prefer(size_t size, size_t num, unsigned int caps1, unsigned int caps2) {
+    (void)num;
+    (void)caps1;
+    (void)caps2;
+    return malloc(size);
+}
+
+static inline void heap_caps_free(void* ptr) {
+    free(ptr);
+}
@@ -0,0 +1,66 @@
+// Host stand-in for esp_imgfx color conversion, see esp_imgfx_types.h. Only the RGB to YUYV
+// conversions used by the JPEG encoder are provided, with the full range BT.601 (JFIF) matrix.
+#pragma once
+
+#include "esp_imgfx_types.h"
+
+typedef struct {
+    esp_imgfx_resolution_t in_res;
+    esp_imgfx_pixel_fmt_t in_pixel_fmt;
+    esp_imgfx_pixel_fmt_t out_pixel_fmt;
+    esp_imgfx_color_space_std_t color_space_std;
+} esp_imgfx_color_convert_cfg_t;
+
+typedef esp_imgfx_color_convert_cfg_t* esp_imgfx_color_convert_handle_t;
+
+static inline esp_imgfx_err_t esp_imgfx_color_convert_open(const esp_imgfx_color_convert_cfg_t* cfg,
+                                                           esp_imgfx_color_convert_handle_t* handle) {
+    *handle = nullptr;
+    bool rgb_in = cfg->in_pixel_fmt == ESP_IMGFX_PIXEL_FMT_RGB565_LE || cfg->in_pixel_fmt == ESP_IMGFX_PIXEL_FMT_RGB565_BE ||
+                  cfg->in_pixel_fmt == ESP_IMGFX_PIXEL_FMT_RGB888;
+    if (!rgb_in || cfg->out_pixel_fmt != ESP_IMGFX_PIXEL_FMT_YUYV || (cfg->in_res.width & 1) != 0) {
+        return ESP_IMGFX_ERR_NOT_SUPPORTED;
+    }
+    *handle = new esp_imgfx_color_convert_cfg_t(*cfg);
+    return ESP_IMGFX_ERR_OK;
+}
+
+static inline void esp_imgfx_host_load_rgb(esp_imgfx_pixel_fmt_t fmt, const uint8_t* p, int* r, int* g, int* b) {
+    if (fmt == ESP_IMGFX_PIXEL_FMT_RGB888) {
+        *r = p[0], *g = p[1], *b = p[2];
+        return;
+    }
+    uint16_t c = fmt == ESP_IMGFX_PIXEL_FMT_RGB565_LE ? (p[0] | (p[1] << 8)) : ((p[0] << 8) | p[1]);
+    *r = ((c >> 11) & 0x1F) * 255 / 31;
+    *g = ((c >> 5) & 0x3F) * 255 / 63;
+    *b = (c & 0x1F) * 255 / 31;
+}
+
+static inline uint8_t esp_imgfx_host_clamp(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline esp_imgfx_err_t esp_imgfx_color_convert_process(esp_imgfx_color_convert_handle_t handle,
+                                                              esp_imgfx_data_t* in, esp_imgfx_data_t* out) {
+    int bpp = handle->in_pixel_fmt == ESP_IMGFX_PIXEL_FMT_RGB888 ? 3 : 2;
+    uint32_t pixels = (uint32_t)handle->in_res.width * handle->in_res.height;
+    if (in->data_len < pixels * bpp || out->data_len < pixels * 2) {
+        return ESP_IMGFX_ERR_NOT_SUPPORTED;
+    }
+    for (uint32_t i = 0; i < pixels; i += 2) {
+        int r0, g0, b0, r1, g1, b1;
+        esp_imgfx_host_load_rgb(handle->in_pixel_fmt, in->data + i * bpp, &r0, &g0, &b0);
+        esp_imgfx_host_load_rgb(handle->in_pixel_fmt, in->data + (i + 1) * bpp, &r1, &g1, &b1);
+        int r = (r0 + r1) / 2, g = (g0 + g1) / 2, b = (b0 + b1) / 2;
+        uint8_t* d = out->data + i * 2;
+        d[0] = esp_imgfx_host_clamp((int)(0.299 * r0 + 0.587 * g0 + 0.114 * b0 + 0.5));
+        d[1] = esp_imgfx_host_clamp((int)(-0.168736 * r - 0.331264 * g + 0.5 * b + 128.5));
+        d[2] = esp_imgfx_host_clamp((int)(0.299 * r1 + 0.587 * g1 + 0.114 * b1 + 0.5));
+        d[3] = esp_imgfx_host_clamp((int)(0.5 * r - 0.418688 * g - 0.081312 * b + 128.5));
+    }
+    return ESP_IMGFX_ERR_OK;
+}
+
+static inline void esp_imgfx_color_convert_close(esp_imgfx_color_convert_handle_t handle) {
+    delete handle;
+}
@@ -0,0 +1,31 @@
+// Host stand-in for esp_imgfx rotation, see esp_imgfx_types.h
+#pragma once
+
+#include "esp_imgfx_types.h"
+
+typedef void* esp_imgfx_rotate_handle_t;
+
+typedef struct {
+    esp_imgfx_resolution_t in_res;
+    esp_imgfx_pixel_fmt_t in_pixel_fmt;
+    uint16_t degree;
+} esp_imgfx_rotate_cfg_t;
+
+static inline esp_imgfx_err_t esp_imgfx_rotate_open(const esp_imgfx_rotate_cfg_t* cfg,
+                                                    esp_imgfx_rotate_handle_t* handle) {
+    (void)cfg;
+    *handle = nullptr;
+    return ESP_IMGFX_ERR_NOT_SUPPORTED;
+}
+
+static inline esp_imgfx_err_t esp_imgfx_rotate_process(esp_imgfx_rotate_handle_t handle, esp_imgfx_data_t* in,
+                                                       esp_imgfx_data_t* out) {
+    (void)handle;
+    (void)in;
+    (void)out;
+    return ESP_IMGFX_ERR_NOT_SUPPORTED;
+}
+
+static inline void esp_imgfx_rotate_close(esp_imgfx_rotate_handle_t handle) {
+    (void)handle;
+}
@@ -0,0 +1,33 @@
+// Host stand-in for the esp_imgfx types. The library is prebuilt for Espressif targets only,
+// so the host stand-ins implement what the tests need and report anything else as not supported.
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+    ESP_IMGFX_ERR_OK = 0,
+    ESP_IMGFX_ERR_NOT_SUPPORTED = -5,
+} esp_imgfx_err_t;
+
+typedef enum {
+    ESP_IMGFX_PIXEL_FMT_RGB565_LE = 0x1,
+    ESP_IMGFX_PIXEL_FMT_RGB565_BE = 0x2,
+    ESP_IMGFX_PIXEL_FMT_RGB888 = 0x3,
+    ESP_IMGFX_PIXEL_FMT_YUYV = 0x4,
+    ESP_IMGFX_PIXEL_FMT_Y = 0x5,
+    ESP_IMGFX_PIXEL_FMT_MAX = 0x7FFFFFFF,
+} esp_imgfx_pixel_fmt_t;
+
+typedef enum {
+    ESP_IMGFX_COLOR_SPACE_STD_BT601 = 0,
+} esp_imgfx_color_space_std_t;
+
+typedef struct {
+    int16_t width;
+    int16_t height;
+} esp_imgfx_resolution_t;
+
+typedef struct {
+    uint8_t* data;
+    uint32_t data_len;
+} esp_imgfx_data_t;
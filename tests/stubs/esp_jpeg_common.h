@@ -0,0 +1,34 @@
+// Host stand-in for the esp_new_jpeg common types, see esp_jpeg_host.cc
+#pragma once
+
+#include <stddef.h>
+
+typedef enum {
+    JPEG_PIXEL_FORMAT_GRAY = 0,
+    JPEG_PIXEL_FORMAT_RGB888 = 1,
+    JPEG_PIXEL_FORMAT_YCbYCr = 5,
+} jpeg_pixel_format_t;
+
+typedef enum {
+    JPEG_SUBSAMPLE_GRAY = 0,
+    JPEG_SUBSAMPLE_444 = 1,
+    JPEG_SUBSAMPLE_422 = 2,
+    JPEG_SUBSAMPLE_420 = 3,
+} jpeg_subsampling_t;
+
+typedef enum {
+    JPEG_ROTATE_0D = 0,
+    JPEG_ROTATE_90D = 1,
+    JPEG_ROTATE_180D = 2,
+    JPEG_ROTATE_270D = 3,
+} jpeg_rotate_t;
+
+typedef enum {
+    JPEG_ERR_OK = 0,
+    JPEG_ERR_FAIL = -1,
+    JPEG_ERR_NO_MEM = -2,
+    JPEG_ERR_INVALID_PARAM = -4,
+} jpeg_error_t;
+
+void* jpeg_calloc_align(size_t size, int aligned);
+void jpeg_free_align(void* data);
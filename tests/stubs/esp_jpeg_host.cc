@@ -0,0 +1,331 @@
+// Host stand-ins for the esp_new_jpeg software encoder and the ESP32-P4 hardware JPEG encoder.
+// Both take the same input layouts as the real encoders and compress with libjpeg, so the
+// conversion, banding and buffer handling in image_to_jpeg.cpp can be checked on the host.
+#include "esp_jpeg_enc.h"
+#include "driver/jpeg_encode.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <jpeglib.h>
+
+int host_jpeg_enc_opened = 0;
+int host_jpeg_enc_closed = 0;
+int host_jpeg_hw_encodes = 0;
+int host_jpeg_hw_engines = 0;
+int host_jpeg_hw_allocs = 0;
+
+namespace {
+
+// Input pixel layouts understood by the encoders
+enum class Layout {
+    kGray,
+    kRgb888,
+    kRgb565Le,
+    kYuyv,  // Y0 Cb Y1 Cr, the esp_new_jpeg YCbYCr format
+    kUyvy,  // Cb Y0 Cr Y1, the hardware YUV422 format
+};
+
+int BytesPerPixel(Layout layout) {
+    switch (layout) {
+        case Layout::kGray:
+            return 1;
+        case Layout::kRgb888:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+class LibjpegEncoder {
+public:
+    LibjpegEncoder(int width, int height, Layout layout, int quality, int h_samp, int v_samp)
+        : width_(width), height_(height), layout_(layout), quality_(quality), h_samp_(h_samp), v_samp_(v_samp) {
+        cinfo_.err = jpeg_std_error(&jerr_);
+        jpeg_create_compress(&cinfo_);
+        dest_.init_destination = InitDestination;
+        dest_.empty_output_buffer = EmptyOutputBuffer;
+        dest_.term_destination = TermDestination;
+        cinfo_.client_data = this;
+        cinfo_.dest = &dest_;
+    }
+
+    ~LibjpegEncoder() { jpeg_destroy_compress(&cinfo_); }
+
+    int rows_per_block() const { return v_samp_ * 8; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    Layout layout() const { return layout_; }
+
+    // Compress the next rows of the frame, the frame is finished after the last row
+    void WriteRows(const uint8_t* src, int rows) {
+        if (rows_written_ == 0) {
+            Start();
+        }
+        std::vector<uint8_t> line(width_ * cinfo_.input_components);
+        for (int r = 0; r < rows && rows_written_ < height_; r++, rows_written_++) {
+            ConvertLine(src + (size_t)r * width_ * BytesPerPixel(layout_), line.data());
+            JSAMPROW row = line.data();
+            jpeg_write_scanlines(&cinfo_, &row, 1);
+        }
+        if (rows_written_ == height_) {
+            jpeg_finish_compress(&cinfo_);
+            rows_written_ = 0;
+        }
+    }
+
+    // Move the compressed bytes produced so far to dst, returns false if they do not fit
+    bool TakeOutput(uint8_t* dst, size_t capacity, size_t* size) {
+        if (rows_written_ != 0) {
+            Flush();
+        }
+        *size = output_.size();
+        if (output_.size() > capacity) {
+            output_.clear();
+            return false;
+        }
+        memcpy(dst, output_.data(), output_.size());
+        output_.clear();
+        return true;
+    }
+
+private:
+    void Start() {
+        cinfo_.image_width = width_;
+        cinfo_.image_height = height_;
+        if (layout_ == Layout::kGray) {
+            cinfo_.input_components = 1;
+            cinfo_.in_color_space = JCS_GRAYSCALE;
+        } else if (layout_ == Layout::kRgb888 || layout_ == Layout::kRgb565Le) {
+            cinfo_.input_components = 3;
+            cinfo_.in_color_space = JCS_RGB;
+        } else {
+            cinfo_.input_components = 3;
+            cinfo_.in_color_space = JCS_YCbCr;
+        }
+        jpeg_set_defaults(&cinfo_);
+        jpeg_set_quality(&cinfo_, quality_, TRUE);
+        if (cinfo_.num_components == 3) {
+            cinfo_.comp_info[0].h_samp_factor = h_samp_;
+            cinfo_.comp_info[0].v_samp_factor = v_samp_;
+        }
+        jpeg_start_compress(&cinfo_, TRUE);
+    }
+
+    void ConvertLine(const uint8_t* src, uint8_t* dst) {
+        switch (layout_) {
+            case Layout::kGray:
+                memcpy(dst, src, width_);
+                break;
+            case Layout::kRgb888:
+                memcpy(dst, src, width_ * 3);
+                break;
+            case Layout::kRgb565Le:
+                for (int x = 0; x < width_; x++) {
+                    uint16_t c = src[2 * x] | (src[2 * x + 1] << 8);
+                    dst[3 * x + 0] = ((c >> 11) & 0x1F) * 255 / 31;
+                    dst[3 * x + 1] = ((c >> 5) & 0x3F) * 255 / 63;
+                    dst[3 * x + 2] = (c & 0x1F) * 255 / 31;
+                }
+                break;
+            case Layout::kYuyv:
+            case Layout::kUyvy: {
+                bool yuyv = layout_ == Layout::kYuyv;
+                for (int x = 0; x + 1 < width_; x += 2) {
+                    const uint8_t* p = src + x * 2;
+                    uint8_t y0 = yuyv ? p[0] : p[1];
+                    uint8_t cb = yuyv ? p[1] : p[0];
+                    uint8_t y1 = yuyv ? p[2] : p[3];
+                    uint8_t cr = yuyv ? p[3] : p[2];
+                    uint8_t* d = dst + x * 3;
+                    d[0] = y0, d[1] = cb, d[2] = cr;
+                    d[3] = y1, d[4] = cb, d[5] = cr;
+                }
+                break;
+            }
+        }
+    }
+
+    void Flush() {
+        output_.insert(output_.end(), buffer_, dest_.next_output_byte);
+        dest_.next_output_byte = buffer_;
+        dest_.free_in_buffer = sizeof(buffer_);
+    }
+
+    static LibjpegEncoder* Self(j_compress_ptr cinfo) { return static_cast<LibjpegEncoder*>(cinfo->client_data); }
+
+    static void InitDestination(j_compress_ptr cinfo) {
+        auto self = Self(cinfo);
+        self->dest_.next_output_byte = self->buffer_;
+        self->dest_.free_in_buffer = sizeof(self->buffer_);
+    }
+
+    static boolean EmptyOutputBuffer(j_compress_ptr cinfo) {
+        auto self = Self(cinfo);
+        self->output_.insert(self->output_.end(), self->buffer_, self->buffer_ + sizeof(self->buffer_));
+        InitDestination(cinfo);
+        return TRUE;
+    }
+
+    static void TermDestination(j_compress_ptr cinfo) { Self(cinfo)->Flush(); }
+
+    int width_;
+    int height_;
+    Layout layout_;
+    int quality_;
+    int h_samp_;
+    int v_samp_;
+    int rows_written_ = 0;
+    jpeg_compress_struct cinfo_ = {};
+    jpeg_error_mgr jerr_ = {};
+    jpeg_destination_mgr dest_ = {};
+    uint8_t buffer_[4096];
+    std::vector<uint8_t> output_;
+};
+
+}  // namespace
+
+void* jpeg_calloc_align(size_t size, int aligned) {
+    size_t rounded = (size + aligned - 1) / aligned * aligned;
+    void* p = aligned_alloc(aligned, rounded == 0 ? aligned : rounded);
+    if (p) {
+        memset(p, 0, rounded);
+    }
+    return p;
+}
+
+void jpeg_free_align(void* data) {
+    free(data);
+}
+
+jpeg_error_t jpeg_enc_open(jpeg_enc_config_t* info, jpeg_enc_handle_t* jpeg_enc) {
+    Layout layout;
+    switch (info->src_type) {
+        case JPEG_PIXEL_FORMAT_GRAY:
+            layout = Layout::kGray;
+            break;
+        case JPEG_PIXEL_FORMAT_RGB888:
+            layout = Layout::kRgb888;
+            break;
+        case JPEG_PIXEL_FORMAT_YCbYCr:
+            layout = Layout::kYuyv;
+            break;
+        default:
+            return JPEG_ERR_INVALID_PARAM;
+    }
+    if (info->width <= 0 || info->height <= 0 || info->rotate != JPEG_ROTATE_0D) {
+        return JPEG_ERR_INVALID_PARAM;
+    }
+    int h_samp = info->subsampling == JPEG_SUBSAMPLE_444 ? 1 : 2;
+    int v_samp = info->subsampling == JPEG_SUBSAMPLE_420 ? 2 : 1;
+    *jpeg_enc = new LibjpegEncoder(info->width, info->height, layout, info->quality, h_samp, v_samp);
+    host_jpeg_enc_opened++;
+    return JPEG_ERR_OK;
+}
+
+jpeg_error_t jpeg_enc_process(const jpeg_enc_handle_t jpeg_enc, const uint8_t* in_buf, int inbuf_size,
+                              uint8_t* out_buf, int outbuf_size, int* out_size) {
+    auto enc = static_cast<LibjpegEncoder*>(jpeg_enc);
+    if (inbuf_size < enc->width() * enc->height() * BytesPerPixel(enc->layout())) {
+        return JPEG_ERR_INVALID_PARAM;
+    }
+    enc->WriteRows(in_buf, enc->height());
+    size_t size = 0;
+    bool fits = enc->TakeOutput(out_buf, outbuf_size, &size);
+    *out_size = (int)size;
+    return fits ? JPEG_ERR_OK : JPEG_ERR_NO_MEM;
+}
+
+jpeg_error_t jpeg_enc_get_block_size(const jpeg_enc_handle_t jpeg_enc, int* block_size) {
+    auto enc = static_cast<LibjpegEncoder*>(jpeg_enc);
+    *block_size = enc->width() * enc->rows_per_block() * BytesPerPixel(enc->layout());
+    return JPEG_ERR_OK;
+}
+
+jpeg_error_t jpeg_enc_process_with_block(const jpeg_enc_handle_t jpeg_enc, const uint8_t* in_buf, int inbuf_size,
+                                         uint8_t* out_buf, int outbuf_size, int* out_size) {
+    auto enc = static_cast<LibjpegEncoder*>(jpeg_enc);
+    int block_size = 0;
+    jpeg_enc_get_block_size(jpeg_enc, &block_size);
+    if (inbuf_size != block_size) {
+        return JPEG_ERR_INVALID_PARAM;
+    }
+    enc->WriteRows(in_buf, enc->rows_per_block());
+    size_t size = 0;
+    bool fits = enc->TakeOutput(out_buf, outbuf_size, &size);
+    *out_size = (int)size;
+    return fits ? JPEG_ERR_OK : JPEG_ERR_NO_MEM;
+}
+
+jpeg_error_t jpeg_enc_close(jpeg_enc_handle_t jpeg_enc) {
+    delete static_cast<LibjpegEncoder*>(jpeg_enc);
+    host_jpeg_enc_closed++;
+    return JPEG_ERR_OK;
+}
+
+struct jpeg_encoder_t {
+    int timeout_ms;
+};
+
+esp_err_t jpeg_new_encoder_engine(const jpeg_encode_engine_cfg_t* enc_eng_cfg, jpeg_encoder_handle_t* ret_encoder) {
+    *ret_encoder = new jpeg_encoder_t{ enc_eng_cfg->timeout_ms };
+    host_jpeg_hw_engines++;
+    return ESP_OK;
+}
+
+esp_err_t jpeg_del_encoder_engine(jpeg_encoder_handle_t encoder_engine) {
+    delete encoder_engine;
+    host_jpeg_hw_engines--;
+    return ESP_OK;
+}
+
+void* jpeg_alloc_encoder_mem(size_t size, const jpeg_encode_memory_alloc_cfg_t* mem_cfg, size_t* allocated_size) {
+    // DMA buffers are rounded up to the cache line size
+    (void)mem_cfg;
+    size_t rounded = (size + 63) / 64 * 64;
+    void* p = aligned_alloc(64, rounded);
+    *allocated_size = p ? rounded : 0;
+    host_jpeg_hw_allocs++;
+    return p;
+}
+
+esp_err_t jpeg_encoder_process(jpeg_encoder_handle_t encoder_engine, const jpeg_encode_cfg_t* encode_cfg,
+                               const uint8_t* encode_inbuf, uint32_t inbuf_size, uint8_t* encode_outbuf,
+                               uint32_t outbuf_size, uint32_t* out_size) {
+    if (encoder_engine == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Layout layout;
+    switch (encode_cfg->src_type) {
+        case JPEG_ENCODE_IN_FORMAT_RGB888:
+            layout = Layout::kRgb888;
+            break;
+        case JPEG_ENCODE_IN_FORMAT_RGB565:
+            layout = Layout::kRgb565Le;
+            break;
+        case JPEG_ENCODE_IN_FORMAT_GRAY:
+            layout = Layout::kGray;
+            break;
+        case JPEG_ENCODE_IN_FORMAT_YUV422:
+            layout = Layout::kUyvy;
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+    if (inbuf_size < encode_cfg->width * encode_cfg->height * BytesPerPixel(layout)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int h_samp = encode_cfg->sub_sample == JPEG_DOWN_SAMPLING_YUV444 ? 1 : 2;
+    int v_samp = encode_cfg->sub_sample == JPEG_DOWN_SAMPLING_YUV420 ? 2 : 1;
+    LibjpegEncoder enc(encode_cfg->width, encode_cfg->height, layout, encode_cfg->image_quality, h_samp, v_samp);
+    enc.WriteRows(encode_inbuf, encode_cfg->height);
+    size_t size = 0;
+    if (!enc.TakeOutput(encode_outbuf, outbuf_size, &size)) {
+        return ESP_ERR_NO_MEM;
+    }
+    *out_size = (uint32_t)size;
+    host_jpeg_hw_encodes++;
+    return ESP_OK;
+}
@@ -0,0 +1,11 @@
+// Host stand-in for the ESP-IDF logging macros
+#pragma once
+
+#include <cstdio>
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) fprintf(stdout, "I %s: " format "\n", tag, ##__VA_ARGS__)
+// Debug and verbose logs are compiled out but still format checked, like on the device
+#define ESP_LOGD(tag, format, ...) do { if (0) fprintf(stdout, "D %s: " format "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGV(tag, format, ...) do { if (0) fprintf(stdout, "V %s: " format "\n", tag, ##__VA_ARGS__); } while (0)
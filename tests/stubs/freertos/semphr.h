@@ -0,0 +1,2 @@
+// Host stand-in, the code under test only uses FreeRTOS on multi-core targets
+#pragma once
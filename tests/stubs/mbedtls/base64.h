@@ -0,0 +1,17 @@
+// Host stand-in for the mbedtls Base64 encoder, backed by OpenSSL
+#pragma once
+
+#include <openssl/evp.h>
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL -0x002A
+
+static inline int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src,
+                                        size_t slen) {
+    size_t needed = (slen + 2) / 3 * 4 + 1;
+    if (dst == nullptr || dlen < needed) {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    *olen = EVP_EncodeBlock(dst, src, (int)slen);
+    return 0;
+}
@@ -0,0 +1,2 @@
+// Host stand-in for the generated sdkconfig.h, no target is selected
+#pragma once
@@ -0,0 +1,151 @@
+// Host test for the checksum, SHA-256 and LZ4 block kernels used by asset and OTA verification
+#include "checksum.h"
+#include "lz4_block.h"
+#include "lz4_vectors.h"
+#include "test_support.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+
+static uint32_t ReferenceByteSum(const uint8_t* data, size_t length, uint32_t seed = 0) {
+    uint32_t sum = seed;
+    for (size_t i = 0; i < length; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static void TestByteSum() {
+    std::vector<uint8_t> buffer(64 * 1024 + 16);
+    std::mt19937 rng(1234);
+    for (auto& b : buffer) {
+        b = rng() & 0xFF;
+    }
+
+    // Every alignment and trailing length around the word loop
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t length : { 0, 1, 2, 3, 4, 5, 7, 8, 511, 512, 513, 4096, 65536 }) {
+            auto p = buffer.data() + offset;
+            CHECK(Checksum::ByteSum(p, length) == ReferenceByteSum(p, length));
+            CHECK(Checksum::ByteSum(p, length, 0x12345678) == ReferenceByteSum(p, length, 0x12345678));
+        }
+    }
+
+    // All 0xFF is the worst case for the 16-bit lanes, fold points must not overflow
+    std::vector<uint8_t> ones(1024 * 1024 + 3, 0xFF);
+    CHECK(Checksum::ByteSum(ones.data(), ones.size()) == ReferenceByteSum(ones.data(), ones.size()));
+    CHECK(Checksum::ByteSum(ones.data() + 1, ones.size() - 1) == ReferenceByteSum(ones.data() + 1, ones.size() - 1));
+
+    // A sum can be continued across chunks, as the streaming download does
+    uint32_t chunked = 0;
+    for (size_t pos = 0; pos < buffer.size(); pos += 1000) {
+        size_t n = std::min<size_t>(1000, buffer.size() - pos);
+        chunked = Checksum::ByteSum(buffer.data() + pos, n, chunked);
+    }
+    CHECK(chunked == ReferenceByteSum(buffer.data(), buffer.size()));
+
+    CHECK(Checksum::ByteSumParallel(ones.data(), ones.size()) == ReferenceByteSum(ones.data(), ones.size()));
+}
+
+static std::string Sha256Hex(const std::string& input, size_t chunk) {
+    Sha256 sha;
+    for (size_t pos = 0; pos < input.size(); pos += chunk) {
+        sha.Update(input.data() + pos, std::min(chunk, input.size() - pos));
+    }
+    return sha.FinishHex();
+}
+
+static void TestSha256() {
+    // FIPS 180-2 test vectors
+    struct {
+        std::string input;
+        const char* digest;
+    } vectors[] = {
+        { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+    };
+    for (auto& v : vectors) {
+        CHECK(Sha256Hex(v.input, 1 << 20) == v.digest);
+        CHECK(Sha256Hex(v.input, 7) == v.digest);
+    }
+
+    CHECK(Sha256::Matches("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+        "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD"));
+    CHECK(Sha256::Matches("ba7816bf", ""));
+    CHECK(!Sha256::Matches("ba7816bf", "ba7816be"));
+
+    const uint8_t bytes[] = { 0x00, 0x0f, 0xa5, 0xff };
+    CHECK(Sha256::ToHex(bytes, sizeof(bytes)) == "000fa5ff");
+}
+
+static void TestLz4Vectors() {
+    for (auto& v : kLz4Vectors) {
+        std::vector<uint8_t> out(v.raw_size + 1, 0xCC);
+        bool ok = Lz4DecompressBlock(v.block, v.block_size, out.data(), v.raw_size);
+        if (!ok || memcmp(out.data(), v.raw, v.raw_size) != 0) {
+            fprintf(stderr, "LZ4 vector %s failed\n", v.name);
+        }
+        CHECK(ok);
+        CHECK(memcmp(out.data(), v.raw, v.raw_size) == 0);
+        // Nothing is written past the declared size
+        CHECK(out[v.raw_size] == 0xCC);
+
+        // The decoded size must match exactly
+        if (v.raw_size > 0) {
+            CHECK(!Lz4DecompressBlock(v.block, v.block_size, out.data(), v.raw_size - 1));
+        }
+        std::vector<uint8_t> larger(v.raw_size + 16);
+        CHECK(!Lz4DecompressBlock(v.block, v.block_size, larger.data(), larger.size()));
+
+        // A truncated block never decodes
+        if (v.block_size > 1) {
+            CHECK(!Lz4DecompressBlock(v.block, v.block_size - 1, out.data(), v.raw_size));
+        }
+    }
+}
+
+static void TestLz4Malformed() {
+    uint8_t out[64];
+
+    // Overlapping match with offset 1, as the reference encoder emits for runs: "a" then 19 more "a"
+    const uint8_t run[] = { 0x1F, 'a', 0x01, 0x00, 0x00, 0x50, 'b', 'b', 'b', 'b', 'b' };
+    CHECK(Lz4DecompressBlock(run, sizeof(run), out, 25));
+    CHECK(memcmp(out, "aaaaaaaaaaaaaaaaaaaabbbbb", 25) == 0);
+
+    // Offset of zero
+    const uint8_t zero_offset[] = { 0x10, 'a', 0x00, 0x00, 0x50, 'b', 'b', 'b', 'b', 'b' };
+    CHECK(!Lz4DecompressBlock(zero_offset, sizeof(zero_offset), out, 10));
+
+    // Offset reaching before the start of the output
+    const uint8_t far_offset[] = { 0x10, 'a', 0x02, 0x00, 0x50, 'b', 'b', 'b', 'b', 'b' };
+    CHECK(!Lz4DecompressBlock(far_offset, sizeof(far_offset), out, 10));
+
+    // Literal length running past the input
+    const uint8_t long_literals[] = { 0x50, 'a', 'b' };
+    CHECK(!Lz4DecompressBlock(long_literals, sizeof(long_literals), out, 5));
+
+    // Length extension bytes missing
+    const uint8_t missing_length[] = { 0xF0 };
+    CHECK(!Lz4DecompressBlock(missing_length, sizeof(missing_length), out, 15));
+
+    // Match running past the output
+    const uint8_t long_match[] = { 0x1F, 'a', 0x01, 0x00, 0xFF, 0x00 };
+    CHECK(!Lz4DecompressBlock(long_match, sizeof(long_match), out, sizeof(out)));
+
+    // Offset cut short
+    const uint8_t short_offset[] = { 0x10, 'a', 0x01 };
+    CHECK(!Lz4DecompressBlock(short_offset, sizeof(short_offset), out, 5));
+}
+
+int main() {
+    TestByteSum();
+    TestSha256();
+    TestLz4Vectors();
+    TestLz4Malformed();
+    return TEST_RESULT();
+}
@@ -0,0 +1,189 @@
+// Host test for the image_kernels pixel loops against the per-pixel reference in image_reference.h
+#include "image_kernels.h"
+#include "image_reference.h"
+#include "test_support.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+static std::mt19937 rng(2024);
+
+static std::vector<uint8_t> RandomBytes(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (auto& b : data) {
+        b = rng() & 0xFF;
+    }
+    return data;
+}
+
+static void TestSwapBytes() {
+    auto src = RandomBytes(4096 + 8);
+    // Both buffers aligned, both misaligned by the same amount, and misaligned relative to each other
+    for (size_t src_offset : { 0, 2, 4, 6 }) {
+        for (size_t dst_offset : { 0, 2, 4, 6 }) {
+            for (size_t count : { 0, 1, 2, 3, 7, 8, 9, 1000, 2047 }) {
+                std::vector<uint8_t> out(4096 + 16, 0xEE), ref(4096 + 16, 0xEE);
+                image_swap_bytes16(out.data() + dst_offset, src.data() + src_offset, count);
+                RefSwapBytes16(ref.data() + dst_offset, src.data() + src_offset, count);
+                CHECK(out == ref);
+            }
+        }
+    }
+
+    // In place
+    for (size_t offset : { 0, 2 }) {
+        auto data = src;
+        std::vector<uint8_t> ref(src.size());
+        RefSwapBytes16(ref.data() + offset, src.data() + offset, 1001);
+        image_swap_bytes16(data.data() + offset, data.data() + offset, 1001);
+        CHECK(memcmp(data.data() + offset, ref.data() + offset, 1001 * 2) == 0);
+    }
+}
+
+static void TestYuv422p() {
+    for (auto [w, h] : { std::pair{ 2, 1 }, { 64, 48 }, { 320, 240 }, { 34, 7 } }) {
+        auto src = RandomBytes(w * h * 2);
+        std::vector<uint8_t> out(w * h * 2 + 1), ref(w * h * 2 + 1);
+        image_yuv422p_to_yuyv(out.data(), src.data(), w, h);
+        RefYuv422pToYuyv(ref.data(), src.data(), w, h);
+        CHECK(out == ref);
+        // Unaligned destination takes the byte path
+        image_yuv422p_to_yuyv(out.data() + 1, src.data(), w, h);
+        CHECK(memcmp(out.data() + 1, ref.data(), w * h * 2) == 0);
+    }
+}
+
+static void TestConvert() {
+    auto src = RandomBytes(32 * 8 * 2);
+    std::vector<uint8_t> out(src.size()), ref(src.size());
+    RefSwapBytes16(ref.data(), src.data(), src.size() / 2);
+
+    CHECK(image_convert(out.data(), out.size(), V4L2_PIX_FMT_RGB565X, src.data(), src.size(), V4L2_PIX_FMT_RGB565, 32, 8));
+    CHECK(out == ref);
+    CHECK(image_convert(out.data(), out.size(), V4L2_PIX_FMT_YUYV, src.data(), src.size(), V4L2_PIX_FMT_UYVY, 32, 8));
+    CHECK(out == ref);
+    CHECK(image_convert(out.data(), out.size(), V4L2_PIX_FMT_RGB565, src.data(), src.size(), V4L2_PIX_FMT_RGB565, 32, 8));
+    CHECK(out == src);
+    // The destination must hold the whole image
+    CHECK(!image_convert(out.data(), out.size() - 1, V4L2_PIX_FMT_RGB565X, src.data(), src.size(), V4L2_PIX_FMT_RGB565, 32, 8));
+}
+
+struct ScaleCase {
+    int src_w, src_h, dst_w, dst_h;
+};
+
+static const ScaleCase kScaleCases[] = {
+    { 640, 480, 320, 240 },  // camera frame to preview
+    { 640, 480, 240, 240 },  // non-uniform
+    { 320, 240, 320, 240 },  // identity
+    { 160, 120, 480, 360 },  // upscale
+    { 640, 3, 3, 2 },        // steps that do not divide exactly
+    { 1, 1, 5, 4 },
+    { 17, 13, 5, 9 },
+};
+
+static void TestScaleNearest() {
+    for (auto& c : kScaleCases) {
+        for (int bpp : { 1, 2, 3, 4 }) {
+            // Source is a region of a wider image, so the stride is larger than the row
+            size_t src_stride = (c.src_w + 5) * bpp;
+            auto src = RandomBytes(src_stride * c.src_h);
+            size_t dst_stride = c.dst_w * bpp + 3;
+            std::vector<uint8_t> out(dst_stride * c.dst_h), ref(dst_stride * c.dst_h);
+            image_scale_nearest(out.data(), c.dst_w, c.dst_h, dst_stride, src.data(), c.src_w, c.src_h, src_stride, bpp);
+            RefScaleNearest(ref.data(), c.dst_w, c.dst_h, dst_stride, src.data(), c.src_w, c.src_h, src_stride, bpp);
+            bool same = true;
+            for (int y = 0; y < c.dst_h; y++) {
+                same &= memcmp(out.data() + y * dst_stride, ref.data() + y * dst_stride, c.dst_w * bpp) == 0;
+            }
+            if (!same) {
+                fprintf(stderr, "nearest %dx%d -> %dx%d bpp %d differs\n", c.src_w, c.src_h, c.dst_w, c.dst_h, bpp);
+            }
+            CHECK(same);
+        }
+    }
+}
+
+// Largest and mean difference from the floating point reference, in channel units
+static double BilinearError(const ScaleCase& c, v4l2_pix_fmt_t format, int bpp, bool* exact, double* mean_error) {
+    bool rgb565 = format == V4L2_PIX_FMT_RGB565;
+    int channels = rgb565 ? 3 : bpp;
+    size_t src_stride = (c.src_w + 3) * bpp;
+    auto src = RandomBytes(src_stride * c.src_h);
+    size_t dst_stride = c.dst_w * bpp;
+    std::vector<uint8_t> out(dst_stride * c.dst_h);
+    CHECK(image_scale_bilinear(out.data(), c.dst_w, c.dst_h, dst_stride, src.data(), c.src_w, c.src_h, src_stride,
+                               format));
+    std::vector<double> ref(c.dst_w * c.dst_h * channels);
+    RefScaleBilinear(ref.data(), c.dst_w, c.dst_h, src.data(), c.src_w, c.src_h, src_stride, bpp, rgb565);
+
+    double max_error = 0;
+    double total_error = 0;
+    *exact = true;
+    for (int y = 0; y < c.dst_h; y++) {
+        for (int x = 0; x < c.dst_w; x++) {
+            double got[3];
+            RefLoadChannels(out.data() + y * dst_stride + x * bpp, bpp, rgb565, got);
+            for (int ch = 0; ch < channels; ch++) {
+                double expected = ref[(y * c.dst_w + x) * channels + ch];
+                max_error = std::max(max_error, std::fabs(got[ch] - expected));
+                total_error += std::fabs(got[ch] - expected);
+                *exact &= got[ch] == expected;
+            }
+        }
+    }
+    *mean_error = total_error / ref.size();
+    return max_error;
+}
+
+static void TestScaleBilinear() {
+    struct {
+        v4l2_pix_fmt_t format;
+        int bpp;
+        double tolerance;
+        double mean_tolerance;
+    } formats[] = {
+        // Weights are truncated to 8 bits, each axis may be off by up to one level near a pixel boundary.
+        // RGB565 further rounds the weights to 5 bits and truncates after each blend.
+        { V4L2_PIX_FMT_GREY, 1, 2.5, 0.5 },
+        { V4L2_PIX_FMT_RGB24, 3, 2.5, 0.5 },
+        { V4L2_PIX_FMT_RGB565, 2, 4.5, 1.0 },
+    };
+    for (auto& f : formats) {
+        for (auto& c : kScaleCases) {
+            bool exact;
+            double mean_error;
+            double error = BilinearError(c, f.format, f.bpp, &exact, &mean_error);
+            if (error > f.tolerance || mean_error > f.mean_tolerance) {
+                fprintf(stderr, "bilinear %dx%d -> %dx%d format 0x%08x error max %.2f mean %.3f\n", c.src_w, c.src_h,
+                        c.dst_w, c.dst_h, f.format, error, mean_error);
+            }
+            CHECK(error <= f.tolerance);
+            CHECK(mean_error <= f.mean_tolerance);
+            // Same size is a plain copy
+            if (c.src_w == c.dst_w && c.src_h == c.dst_h) {
+                CHECK(exact);
+            }
+        }
+    }
+
+    uint8_t pixel[4] = {};
+    CHECK(!image_scale_bilinear(pixel, 1, 1, 4, pixel, 1, 1, 4, V4L2_PIX_FMT_YUYV));
+}
+
+static void TestRotateArguments() {
+    uint8_t pixels[8] = {};
+    CHECK(!image_rotate(pixels, pixels, sizeof(pixels), 2, 2, V4L2_PIX_FMT_RGB565, 45));
+    CHECK(!image_rotate(pixels, pixels, sizeof(pixels), 2, 2, V4L2_PIX_FMT_YUYV, 90));
+}
+
+int main() {
+    TestSwapBytes();
+    TestYuv422p();
+    TestConvert();
+    TestScaleNearest();
+    TestScaleBilinear();
+    TestRotateArguments();
+    return TEST_RESULT();
+}
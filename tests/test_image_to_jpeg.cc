@@ -0,0 +1,359 @@
+// Host test for image_to_jpeg: every entry point and input format is encoded, decoded with libjpeg
+// and compared with the source by PSNR, next to libjpeg encoding the same source directly.
+// The encoders are the libjpeg backed stand-ins in stubs/esp_jpeg_host.cc, not esp_new_jpeg or the
+// ESP32-P4 hardware encoder, so the PSNR figures say nothing about their compression quality.
+// What the test covers is the real code around them: the input format conversion and byte swaps,
+// row banding, handle and buffer reuse, and output framing. A wrong conversion shows up as a PSNR
+// far below libjpeg's on the same source.
+#include "image_to_jpeg.h"
+#include "esp_jpeg_enc.h"
+#if CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
+#include "driver/jpeg_encode.h"
+#endif
+#include "test_support.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <jpeglib.h>
+
+static const int kQuality = 80;
+
+// Encoded output is expected within this many dB of libjpeg on the same source
+static const double kPsnrSlack = 1.5;
+static const double kMinPsnr = 30.0;
+
+struct Image {
+    int width;
+    int height;
+    int channels;
+    std::vector<uint8_t> pixels;
+};
+
+// Smooth gradients with a few hard edges, closer to a camera frame or a UI screen than noise
+static Image MakeRgbImage(int width, int height) {
+    Image image{ width, height, 3, std::vector<uint8_t>(width * height * 3) };
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t* p = &image.pixels[(y * width + x) * 3];
+            p[0] = (uint8_t)(128 + 100 * std::sin(x / 23.0) * std::cos(y / 17.0));
+            p[1] = (uint8_t)(x * 255 / width);
+            p[2] = (uint8_t)(y * 255 / height);
+            if (x > width / 4 && x < width / 2 && y > height / 3 && y < height * 2 / 3) {
+                p[0] = 250, p[1] = 240, p[2] = 20;
+            }
+        }
+    }
+    return image;
+}
+
+static uint8_t Luma(const uint8_t* rgb) {
+    return (uint8_t)(0.299 * rgb[0] + 0.587 * rgb[1] + 0.114 * rgb[2] + 0.5);
+}
+
+// Source bytes in the given V4L2 format, and the image they represent for PSNR
+static std::vector<uint8_t> ToFormat(const Image& rgb, v4l2_pix_fmt_t format, Image* reference) {
+    size_t pixels = (size_t)rgb.width * rgb.height;
+    std::vector<uint8_t> out;
+    *reference = rgb;
+    switch (format) {
+        case V4L2_PIX_FMT_RGB24:
+            out = rgb.pixels;
+            break;
+        case V4L2_PIX_FMT_RGB565:
+        case V4L2_PIX_FMT_RGB565X:
+            out.resize(pixels * 2);
+            for (size_t i = 0; i < pixels; i++) {
+                const uint8_t* p = &rgb.pixels[i * 3];
+                uint16_t c = ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3);
+                out[i * 2 + (format == V4L2_PIX_FMT_RGB565 ? 0 : 1)] = c & 0xFF;
+                out[i * 2 + (format == V4L2_PIX_FMT_RGB565 ? 1 : 0)] = c >> 8;
+                uint8_t* r = &reference->pixels[i * 3];
+                r[0] = (c >> 11) * 255 / 31;
+                r[1] = ((c >> 5) & 0x3F) * 255 / 63;
+                r[2] = (c & 0x1F) * 255 / 31;
+            }
+            break;
+        case V4L2_PIX_FMT_YUYV:
+            out.resize(pixels * 2);
+            for (size_t i = 0; i < pixels; i += 2) {
+                const uint8_t* p0 = &rgb.pixels[i * 3];
+                const uint8_t* p1 = p0 + 3;
+                double r = (p0[0] + p1[0]) / 2.0, g = (p0[1] + p1[1]) / 2.0, b = (p0[2] + p1[2]) / 2.0;
+                out[i * 2 + 0] = Luma(p0);
+                out[i * 2 + 1] = (uint8_t)std::lround(std::clamp(-0.168736 * r - 0.331264 * g + 0.5 * b + 128, 0.0, 255.0));
+                out[i * 2 + 2] = Luma(p1);
+                out[i * 2 + 3] = (uint8_t)std::lround(std::clamp(0.5 * r - 0.418688 * g - 0.081312 * b + 128, 0.0, 255.0));
+            }
+            break;
+        case V4L2_PIX_FMT_GREY:
+            out.resize(pixels);
+            for (size_t i = 0; i < pixels; i++) {
+                out[i] = Luma(&rgb.pixels[i * 3]);
+            }
+            *reference = Image{ rgb.width, rgb.height, 1, out };
+            break;
+    }
+    return out;
+}
+
+static bool Decode(const std::vector<uint8_t>& jpeg, int channels, Image* image) {
+    if (jpeg.size() < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8 || jpeg[jpeg.size() - 2] != 0xFF ||
+        jpeg[jpeg.size() - 1] != 0xD9) {
+        return false;
+    }
+    jpeg_decompress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg.data(), jpeg.size());
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+    image->width = cinfo.output_width;
+    image->height = cinfo.output_height;
+    image->channels = cinfo.output_components;
+    image->pixels.resize((size_t)image->width * image->height * image->channels);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = &image->pixels[(size_t)cinfo.output_scanline * image->width * image->channels];
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+static std::vector<uint8_t> EncodeWithLibjpeg(const Image& image) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+    cinfo.image_width = image.width;
+    cinfo.image_height = image.height;
+    cinfo.input_components = image.channels;
+    cinfo.in_color_space = image.channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, kQuality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = const_cast<uint8_t*>(&image.pixels[(size_t)cinfo.next_scanline * image.width * image.channels]);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    std::vector<uint8_t> jpeg(buffer, buffer + size);
+    jpeg_destroy_compress(&cinfo);
+    free(buffer);
+    return jpeg;
+}
+
+static double Psnr(const Image& a, const Image& b) {
+    if (a.width != b.width || a.height != b.height || a.channels != b.channels) {
+        return 0;
+    }
+    double sum = 0;
+    for (size_t i = 0; i < a.pixels.size(); i++) {
+        double d = (double)a.pixels[i] - b.pixels[i];
+        sum += d * d;
+    }
+    double mse = sum / a.pixels.size();
+    return mse == 0 ? 99.0 : 10 * std::log10(255.0 * 255.0 / mse);
+}
+
+// Collects the callback output and checks the end signal comes once, last
+struct Output {
+    std::vector<uint8_t> data;
+    int chunks = 0;
+    int end_signals = 0;
+    bool data_after_end = false;
+    bool nested_ok = true;
+    bool nest = false;
+};
+
+static size_t CollectOutput(void* arg, size_t index, const void* data, size_t len) {
+    auto out = static_cast<Output*>(arg);
+    if (index == 1 && data == nullptr && len == 0) {
+        out->end_signals++;
+        return 0;
+    }
+    if (out->end_signals > 0) {
+        out->data_after_end = true;
+    }
+    out->data.insert(out->data.end(), (const uint8_t*)data, (const uint8_t*)data + len);
+    out->chunks++;
+    if (out->nest) {
+        // The callback may block on the network, other encodes must not wait for it
+        out->nest = false;
+        uint8_t gray[16 * 16] = {};
+        uint8_t* jpeg = nullptr;
+        size_t jpeg_len = 0;
+        out->nested_ok = image_to_jpeg(gray, sizeof(gray), 16, 16, V4L2_PIX_FMT_GREY, 50, &jpeg, &jpeg_len);
+        free(jpeg);
+    }
+    return len;
+}
+
+struct RowSource {
+    const uint8_t* pixels;
+    size_t row_bytes;
+    int next_row = 0;
+    bool in_order = true;
+    int abort_at = -1;
+};
+
+static bool ReadRows(void* arg, uint16_t y, uint16_t rows, uint8_t* dst) {
+    auto src = static_cast<RowSource*>(arg);
+    if (y == src->abort_at) {
+        return false;
+    }
+    src->in_order &= y == src->next_row;
+    src->next_row = y + rows;
+    memcpy(dst, src->pixels + y * src->row_bytes, rows * src->row_bytes);
+    return true;
+}
+
+static const char* FormatName(v4l2_pix_fmt_t format) {
+    switch (format) {
+        case V4L2_PIX_FMT_RGB24:
+            return "RGB24";
+        case V4L2_PIX_FMT_RGB565:
+            return "RGB565";
+        case V4L2_PIX_FMT_RGB565X:
+            return "RGB565X";
+        case V4L2_PIX_FMT_YUYV:
+            return "YUYV";
+        default:
+            return "GREY";
+    }
+}
+
+static void CheckQuality(const char* api, v4l2_pix_fmt_t format, const Image& reference,
+                         const std::vector<uint8_t>& jpeg) {
+    Image decoded;
+    bool ok = Decode(jpeg, reference.channels, &decoded);
+    CHECK(ok);
+    if (!ok) {
+        fprintf(stderr, "%s %s: output is not a complete JPEG\n", api, FormatName(format));
+        return;
+    }
+    Image baseline;
+    Decode(EncodeWithLibjpeg(reference), reference.channels, &baseline);
+    double psnr = Psnr(decoded, reference);
+    double baseline_psnr = Psnr(baseline, reference);
+    printf("%-22s %-8s %dx%d  %6zu bytes  PSNR %.2f dB (libjpeg %.2f dB)\n", api, FormatName(format),
+           reference.width, reference.height, jpeg.size(), psnr, baseline_psnr);
+    CHECK(psnr >= kMinPsnr);
+    CHECK(psnr >= baseline_psnr - kPsnrSlack);
+}
+
+static void TestFormats(int width, int height) {
+    Image rgb = MakeRgbImage(width, height);
+    for (v4l2_pix_fmt_t format : { V4L2_PIX_FMT_RGB24, V4L2_PIX_FMT_RGB565, V4L2_PIX_FMT_RGB565X, V4L2_PIX_FMT_YUYV,
+                                   V4L2_PIX_FMT_GREY }) {
+        Image reference;
+        auto src = ToFormat(rgb, format, &reference);
+
+        uint8_t* jpeg = nullptr;
+        size_t jpeg_len = 0;
+        CHECK(image_to_jpeg(src.data(), src.size(), width, height, format, kQuality, &jpeg, &jpeg_len));
+        CheckQuality("image_to_jpeg", format, reference, std::vector<uint8_t>(jpeg, jpeg + jpeg_len));
+        free(jpeg);
+
+        Output out;
+        out.nest = true;
+        CHECK(image_to_jpeg_cb(src.data(), src.size(), width, height, format, kQuality, CollectOutput, &out));
+        CHECK(out.end_signals == 1);
+        CHECK(!out.data_after_end);
+        CHECK(out.nested_ok);
+        CheckQuality("image_to_jpeg_cb", format, reference, out.data);
+
+        Output rows_out;
+        RowSource rows{ src.data(), src.size() / height };
+        CHECK(image_rows_to_jpeg_cb(width, height, format, kQuality, ReadRows, &rows, CollectOutput, &rows_out));
+        CHECK(rows.in_order);
+        CHECK(rows.next_row == height);
+        CHECK(rows_out.end_signals == 1);
+        CHECK(!rows_out.data_after_end);
+        CheckQuality("image_rows_to_jpeg_cb", format, reference, rows_out.data);
+    }
+}
+
+static void TestRowsAbort() {
+    Image rgb = MakeRgbImage(64, 64);
+    Image reference;
+    auto src = ToFormat(rgb, V4L2_PIX_FMT_RGB565, &reference);
+#if CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
+    // The hardware encoder reads the whole frame in one call
+    const int abort_rows[] = { 0 };
+#else
+    const int abort_rows[] = { 0, 16 };
+#endif
+    for (int abort_at : abort_rows) {
+        Output out;
+        RowSource rows{ src.data(), 64 * 2 };
+        rows.abort_at = abort_at;
+        CHECK(!image_rows_to_jpeg_cb(64, 64, V4L2_PIX_FMT_RGB565, kQuality, ReadRows, &rows, CollectOutput, &out));
+        CHECK(out.end_signals == 0);
+    }
+}
+
+static void TestCacheRelease() {
+    Image rgb = MakeRgbImage(96, 64);
+    Image reference;
+    auto src = ToFormat(rgb, V4L2_PIX_FMT_YUYV, &reference);
+    uint8_t* jpeg = nullptr;
+    size_t jpeg_len = 0;
+
+#if CONFIG_XIAOZHI_ENABLE_HARDWARE_JPEG_ENCODER
+    int encodes = host_jpeg_hw_encodes;
+    CHECK(image_to_jpeg(src.data(), src.size(), 96, 64, V4L2_PIX_FMT_YUYV, kQuality, &jpeg, &jpeg_len));
+    free(jpeg);
+    CHECK(host_jpeg_hw_encodes == encodes + 1);
+    CHECK(host_jpeg_hw_engines == 1);
+    // image_to_jpeg gave its output buffer away, the first callback encode allocates a new one.
+    // From then on the callback gets the cached buffer itself and the DMA buffers are reused
+    int allocs = 0;
+    for (int i = 0; i < 3; i++) {
+        Output out;
+        CHECK(image_to_jpeg_cb(src.data(), src.size(), 96, 64, V4L2_PIX_FMT_YUYV, kQuality, CollectOutput, &out));
+        CheckQuality("reused buffers", V4L2_PIX_FMT_YUYV, reference, out.data);
+        if (i == 0) {
+            allocs = host_jpeg_hw_allocs;
+        }
+    }
+    CHECK(host_jpeg_hw_allocs == allocs);
+    image_to_jpeg_release_cache();
+    CHECK(host_jpeg_hw_engines == 0);
+#else
+    // The second encode with the same parameters reuses the cached handle
+    CHECK(image_to_jpeg(src.data(), src.size(), 96, 64, V4L2_PIX_FMT_YUYV, kQuality, &jpeg, &jpeg_len));
+    free(jpeg);
+    int opened = host_jpeg_enc_opened;
+    CHECK(image_to_jpeg(src.data(), src.size(), 96, 64, V4L2_PIX_FMT_YUYV, kQuality, &jpeg, &jpeg_len));
+    free(jpeg);
+    CHECK(host_jpeg_enc_opened == opened);
+#endif
+
+    image_to_jpeg_release_cache();
+    CHECK(host_jpeg_enc_opened == host_jpeg_enc_closed);
+
+    // Encoding works again after the release
+    CHECK(image_to_jpeg(src.data(), src.size(), 96, 64, V4L2_PIX_FMT_YUYV, kQuality, &jpeg, &jpeg_len));
+    CheckQuality("after release", V4L2_PIX_FMT_YUYV, reference, std::vector<uint8_t>(jpeg, jpeg + jpeg_len));
+    free(jpeg);
+    image_to_jpeg_release_cache();
+}
+
+int main() {
+    TestFormats(320, 240);
+    // Neither dimension a multiple of the MCU size, the last row band is padded
+    TestFormats(200, 135);
+    TestRowsAbort();
+    TestCacheRelease();
+    return TEST_RESULT();
+}
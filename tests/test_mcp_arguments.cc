@@ -0,0 +1,284 @@
+// Host test for decoding MCP tool call arguments, both into typed argument structs (McpArgument)
+// and into a PropertyList for the untyped tools
+#include "mcp_server.h"
+#include "test_support.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+struct AllArgs {
+    bool flag = false;
+    int count = 0;
+    std::string name;
+};
+
+struct VolumeArgs {
+    int volume = -1;
+};
+
+struct OptionalArgs {
+    bool enabled = false;
+    int level = 0;
+    std::string mode;
+    int percent = 0;
+};
+
+static bool Throws(const McpTool& tool, const cJSON* arguments) {
+    try {
+        tool.Bind(arguments);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+static cJSON* MakeAllArgs() {
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json, "flag", true);
+    cJSON_AddNumberToObject(json, "count", 7);
+    cJSON_AddStringToObject(json, "name", "kitchen");
+    return json;
+}
+
+static McpTool MakeAllArgsTool(AllArgs* seen) {
+    return McpTool("test.all", "All argument types",
+        std::vector<McpArgument<AllArgs>>{
+            McpArgument("flag", &AllArgs::flag),
+            McpArgument("count", &AllArgs::count),
+            McpArgument("name", &AllArgs::name),
+        },
+        std::function<ReturnValue(const AllArgs&)>([seen](const AllArgs& args) -> ReturnValue {
+            *seen = args;
+            return true;
+        }));
+}
+
+static void TestEachType() {
+    AllArgs seen;
+    McpTool tool = MakeAllArgsTool(&seen);
+    cJSON* json = MakeAllArgs();
+    auto call = tool.Bind(json);
+    // The arguments are decoded at bind time, the call does not read the JSON again
+    cJSON_Delete(json);
+    std::string result = tool.Call(call);
+    CHECK(seen.flag);
+    CHECK(seen.count == 7);
+    CHECK(seen.name == "kitchen");
+    CHECK(result.find("\"text\":\"true\"") != std::string::npos);
+    CHECK(result.find("\"isError\":false") != std::string::npos);
+
+    json = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json, "flag", false);
+    cJSON_AddNumberToObject(json, "count", -3);
+    cJSON_AddStringToObject(json, "name", "");
+    tool.Call(tool.Bind(json));
+    CHECK(!seen.flag);
+    CHECK(seen.count == -3);
+    CHECK(seen.name.empty());
+    cJSON_Delete(json);
+}
+
+static void TestMissingRequired() {
+    AllArgs seen;
+    McpTool tool = MakeAllArgsTool(&seen);
+    for (const char* missing : { "flag", "count", "name" }) {
+        cJSON* json = cJSON_CreateObject();
+        if (strcmp(missing, "flag") != 0) {
+            cJSON_AddBoolToObject(json, "flag", true);
+        }
+        if (strcmp(missing, "count") != 0) {
+            cJSON_AddNumberToObject(json, "count", 1);
+        }
+        if (strcmp(missing, "name") != 0) {
+            cJSON_AddStringToObject(json, "name", "x");
+        }
+        CHECK(Throws(tool, json));
+        cJSON_Delete(json);
+    }
+    // No arguments at all, or arguments that are not an object
+    CHECK(Throws(tool, nullptr));
+    cJSON* array = cJSON_CreateArray();
+    CHECK(Throws(tool, array));
+    cJSON_Delete(array);
+}
+
+static void TestWrongType() {
+    AllArgs seen;
+    McpTool tool = MakeAllArgsTool(&seen);
+    const char* fields[] = { "flag", "count", "name" };
+    for (int wrong = 0; wrong < 3; wrong++) {
+        cJSON* json = cJSON_CreateObject();
+        for (int i = 0; i < 3; i++) {
+            if (i != wrong) {
+                cJSON* value = i == 0 ? cJSON_CreateBool(true) : i == 1 ? cJSON_CreateNumber(1) : cJSON_CreateString("x");
+                cJSON_AddItemToObject(json, fields[i], value);
+            } else {
+                // Each field gets a value of the next type: a number for the bool, a string for the int,
+                // a bool for the string
+                cJSON* value = i == 0 ? cJSON_CreateNumber(1) : i == 1 ? cJSON_CreateString("1") : cJSON_CreateBool(true);
+                cJSON_AddItemToObject(json, fields[i], value);
+            }
+        }
+        CHECK(Throws(tool, json));
+        cJSON_Delete(json);
+    }
+}
+
+static void TestRange() {
+    VolumeArgs seen;
+    McpTool tool("test.volume", "Ranged integer",
+        std::vector<McpArgument<VolumeArgs>>{ McpArgument("volume", &VolumeArgs::volume, 0, 100) },
+        std::function<ReturnValue(const VolumeArgs&)>([&seen](const VolumeArgs& args) -> ReturnValue {
+            seen = args;
+            return args.volume;
+        }));
+
+    for (int volume : { 0, 55, 100 }) {
+        cJSON* json = cJSON_CreateObject();
+        cJSON_AddNumberToObject(json, "volume", volume);
+        std::string result = tool.Call(tool.Bind(json));
+        CHECK(seen.volume == volume);
+        CHECK(result.find("\"text\":\"" + std::to_string(volume) + "\"") != std::string::npos);
+        cJSON_Delete(json);
+    }
+    // Numbers past the int range saturate in cJSON and are still rejected
+    for (double volume : { -1.0, 101.0, 1e12, -1e12 }) {
+        cJSON* json = cJSON_CreateObject();
+        cJSON_AddNumberToObject(json, "volume", volume);
+        CHECK(Throws(tool, json));
+        cJSON_Delete(json);
+    }
+
+    // A default outside its range is a programming error caught at registration
+    bool thrown = false;
+    try {
+        McpArgument("volume", &VolumeArgs::volume, 150, 0, 100);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+static void TestDefaults() {
+    OptionalArgs seen;
+    McpTool tool("test.optional", "Optional arguments",
+        std::vector<McpArgument<OptionalArgs>>{
+            McpArgument("enabled", &OptionalArgs::enabled, true),
+            McpArgument("level", &OptionalArgs::level, 3),
+            McpArgument("mode", &OptionalArgs::mode, std::string("auto")),
+            McpArgument("percent", &OptionalArgs::percent, 50, 0, 100),
+        },
+        std::function<ReturnValue(const OptionalArgs&)>([&seen](const OptionalArgs& args) -> ReturnValue {
+            seen = args;
+            return true;
+        }));
+
+    // Missing arguments, missing or non-object argument lists, and wrong types all take the defaults
+    cJSON* empty = cJSON_CreateObject();
+    cJSON* wrong = cJSON_CreateObject();
+    cJSON_AddStringToObject(wrong, "enabled", "no");
+    cJSON_AddBoolToObject(wrong, "level", false);
+    cJSON_AddNumberToObject(wrong, "mode", 1);
+    cJSON_AddStringToObject(wrong, "percent", "10");
+    for (const cJSON* json : { (const cJSON*)empty, (const cJSON*)nullptr, (const cJSON*)wrong }) {
+        seen = OptionalArgs{};
+        tool.Call(tool.Bind(json));
+        CHECK(seen.enabled);
+        CHECK(seen.level == 3);
+        CHECK(seen.mode == "auto");
+        CHECK(seen.percent == 50);
+    }
+    cJSON_Delete(empty);
+    cJSON_Delete(wrong);
+
+    // Given values override the defaults, and the range still applies to them
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json, "enabled", false);
+    cJSON_AddNumberToObject(json, "level", 9);
+    cJSON_AddStringToObject(json, "mode", "manual");
+    cJSON_AddNumberToObject(json, "percent", 0);
+    tool.Call(tool.Bind(json));
+    CHECK(!seen.enabled);
+    CHECK(seen.level == 9);
+    CHECK(seen.mode == "manual");
+    CHECK(seen.percent == 0);
+    cJSON_Delete(json);
+
+    json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "percent", 101);
+    CHECK(Throws(tool, json));
+    cJSON_Delete(json);
+
+    // Only arguments without a default are listed as required
+    std::string schema = tool.to_json();
+    CHECK(schema.find("\"required\"") == std::string::npos);
+    CHECK(schema.find("\"percent\":{\"type\":\"integer\",\"default\":50,\"minimum\":0,\"maximum\":100}") !=
+          std::string::npos);
+}
+
+static void TestDuplicateArgument() {
+    bool thrown = false;
+    try {
+        McpTool tool("test.duplicate", "Duplicate arguments",
+            std::vector<McpArgument<VolumeArgs>>{
+                McpArgument("volume", &VolumeArgs::volume),
+                McpArgument("volume", &VolumeArgs::volume, 10),
+            },
+            std::function<ReturnValue(const VolumeArgs&)>([](const VolumeArgs&) -> ReturnValue { return true; }));
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+// The untyped tools decode into a PropertyList and follow the same rules
+static void TestPropertyList() {
+    PropertyList seen;
+    McpTool tool("test.properties", "Property list",
+        PropertyList({
+            Property("flag", kPropertyTypeBoolean),
+            Property("volume", kPropertyTypeInteger, 0, 100),
+            Property("name", kPropertyTypeString, std::string("default")),
+        }),
+        [&seen](const PropertyList& properties) -> ReturnValue {
+            seen = properties;
+            return true;
+        });
+
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json, "flag", true);
+    cJSON_AddNumberToObject(json, "volume", 80);
+    tool.Call(tool.Bind(json));
+    CHECK(seen["flag"].value<bool>());
+    CHECK(seen["volume"].value<int>() == 80);
+    CHECK(seen["name"].value<std::string>() == "default");
+    cJSON_Delete(json);
+
+    json = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json, "flag", true);
+    CHECK(Throws(tool, json));
+    cJSON_AddStringToObject(json, "volume", "80");
+    CHECK(Throws(tool, json));
+    cJSON_Delete(json);
+
+    json = cJSON_CreateObject();
+    cJSON_AddBoolToObject(json, "flag", true);
+    cJSON_AddNumberToObject(json, "volume", 101);
+    CHECK(Throws(tool, json));
+    cJSON_Delete(json);
+
+    std::string schema = tool.to_json();
+    CHECK(schema.find("\"required\":[\"flag\",\"volume\"]") != std::string::npos);
+}
+
+int main() {
+    TestEachType();
+    TestMissingRequired();
+    TestWrongType();
+    TestRange();
+    TestDefaults();
+    TestDuplicateArgument();
+    TestPropertyList();
+    return TEST_RESULT();
+}
@@ -0,0 +1,17 @@
+// Minimal assertion helpers shared by the host tests
+#pragma once
+
+#include <cstdio>
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+#define TEST_RESULT() \
+    (g_failures == 0 ? (printf("All checks passed\n"), 0) : (fprintf(stderr, "%d check(s) failed\n", g_failures), 1))